@@ -0,0 +1,27 @@
+// Instance data structure
+struct InstanceData {
+    mat4 modelMatrix;
+    vec2 uvScale;
+    uint materialId;
+    uint meshId;
+};
+
+// Instance buffer with interleaved data
+layout (std430, binding = 0) buffer InstanceBuffer {
+    InstanceData instances[];
+};
+
+// Position dequantization per mesh, the identity for float vertices
+struct MeshBounds {
+    vec4 offset;
+    vec4 scale;
+};
+
+layout (std430, binding = 3) buffer MeshBoundsBuffer {
+    MeshBounds meshBounds[];
+};
+
+vec3 dequantizePosition(vec3 position, uint meshId) {
+    MeshBounds bounds = meshBounds[meshId];
+    return bounds.offset.xyz + position * bounds.scale.xyz;
+}
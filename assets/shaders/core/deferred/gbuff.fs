@@ -55,10 +55,16 @@ const uint MATERIAL_HAS_NORMAL_MAP = 2u;
 const uint MATERIAL_HAS_METALLIC_ROUGHNESS_MAP = 4u;
 const uint MATERIAL_HAS_EMISSIVE_MAP = 8u;
 const uint MATERIAL_HAS_HEIGHT_MAP = 16u;
+const uint MATERIAL_NORMAL_MAP_XY = 32u;
 
-// Helper function to check texture flags
+// Helper function to check texture flags. Variants compiled for one set of
+// flags define MATERIAL_PERMUTATION_FLAGS, the checks fold to constants.
 bool hasTextureFlag(uint flags, uint flag) {
+#ifdef MATERIAL_PERMUTATION_FLAGS
+    return (MATERIAL_PERMUTATION_FLAGS & flag) != 0u;
+#else
     return (flags & flag) != 0u;
+#endif
 }
 
 // Apply tiling using material's uvScale
@@ -114,8 +120,15 @@ void main() {
     vec3 mappedNormal = normalize(Normal);
     if (hasTextureFlag(material.textureFlags, MATERIAL_HAS_NORMAL_MAP)) {
         mat3 TBN = mat3(normalize(Tangent), normalize(Bitangent), normalize(Normal));
-        vec3 normalSample = texture(material.normalMapSampler, texCoords).rgb;
-        normalSample = normalSample * 2.0 - 1.0;
+        vec3 normalSample;
+        if (hasTextureFlag(material.textureFlags, MATERIAL_NORMAL_MAP_XY)) {
+            // BC5 keeps X/Y only
+            vec2 xy = texture(material.normalMapSampler, texCoords).rg * 2.0 - 1.0;
+            normalSample = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+        } else {
+            normalSample = texture(material.normalMapSampler, texCoords).rgb;
+            normalSample = normalSample * 2.0 - 1.0;
+        }
         mappedNormal = normalize(TBN * normalSample);
     }
     gNormal = mappedNormal;
@@ -1,21 +1,11 @@
 #version 460 core
 
-// Vertex attributes
-layout(location = 0) in vec4 aPosition;  // xyz = position, w = packed UVs
+// Vertex attributes, float or compact layout (see Renderer::initMeshBuffers)
+layout(location = 0) in vec3 aPosition;  // Position, within the mesh bounds for compact meshes
 layout(location = 1) in vec4 aPackedTNB; // Packed tangent space quaternion
+layout(location = 2) in uint aPackedUV;  // Half precision UVs
 
-// Instance data structure
-struct InstanceData {
-    mat4 modelMatrix;
-    vec2 uvScale;
-    uint materialId;
-    uint padding;
-};
-
-// Instance buffer with interleaved data
-layout (std430, binding = 0) buffer InstanceBuffer {
-    InstanceData instances[];
-};
+#include "../MeshInstances.glsl"
 
 // Output to fragment shader
 out vec3 FragPos;
@@ -56,11 +46,10 @@ void main() {
     MaterialID = instance.materialId;
 
     // Extract vertex position
-    vec3 position = aPosition.xyz;
+    vec3 position = dequantizePosition(aPosition, instance.meshId);
 
-    // Unpack UVs from the packed float in position.w
-    uint packedUVBits = floatBitsToUint(aPosition.w);
-    vec2 uv = unpackHalf2x16(packedUVBits);
+    // Unpack UVs
+    vec2 uv = unpackHalf2x16(aPackedUV);
 
     // Transform position to world space
     FragPos = vec3(modelMatrix * vec4(position, 1.0));
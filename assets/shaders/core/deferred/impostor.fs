@@ -0,0 +1,64 @@
+#version 460 core
+
+// G-buffer outputs, as in gbuff.fs
+layout (location = 0) out vec3 gPosition;
+layout (location = 1) out vec3 gNormal;
+layout (location = 2) out vec4 gAlbedo;
+layout (location = 3) out vec4 gPBRParams;
+layout (location = 4) out vec3 gEmissive;
+
+#include "../MeshInstances.glsl"
+
+in vec3 AtlasCoords;
+in vec3 QuadPosition;
+flat in vec3 FrameDirection;
+flat in vec2 FrameOrigin;
+flat in float Radius;
+flat in uint InstanceIndex;
+
+// Layers of ImpostorAtlas, colors premultiplied by the coverage in the PBR alpha
+uniform sampler2DArray u_ImpostorNormal;
+uniform sampler2DArray u_ImpostorAlbedo;
+uniform sampler2DArray u_ImpostorParams;
+uniform sampler2DArray u_ImpostorEmissive;
+uniform sampler2DArray u_ImpostorDepth;
+
+uniform mat4 u_View;
+uniform mat4 u_Projection;
+
+// ImpostorAtlas::FRAMES, FRAMES * FRAME_SIZE and MIP_LEVELS - 1
+const float FRAMES = 16.0;
+const float ATLAS_SIZE = 512.0;
+const float MAX_LEVEL = 2.0;
+
+void main() {
+    // Bilinear samples stay inside the view at the level they read, texels of the neighbouring views never blend in
+    float level = clamp(floor(textureQueryLod(u_ImpostorParams, AtlasCoords.xy).x + 0.5), 0.0, MAX_LEVEL);
+    float halfTexel = 0.5 * exp2(level) / ATLAS_SIZE;
+    vec3 coords = vec3(clamp(AtlasCoords.xy, FrameOrigin + halfTexel, FrameOrigin + 1.0 / FRAMES - halfTexel), AtlasCoords.z);
+
+    vec4 params = texture(u_ImpostorParams, coords);
+    float coverage = params.a;
+    if (coverage < 0.5) {
+        discard;
+    }
+
+    // Depth across the sphere toward the back, texels just outside the mesh fall back to the center plane
+    float depth = texture(u_ImpostorDepth, coords).r;
+    if (depth >= 1.0) {
+        depth = 0.5;
+    }
+    vec3 position = QuadPosition + FrameDirection * Radius * (1.0 - 2.0 * depth);
+
+    mat4 modelMatrix = instances[InstanceIndex].modelMatrix;
+    vec4 worldPosition = modelMatrix * vec4(position, 1.0);
+    gPosition = worldPosition.xyz;
+    gNormal = normalize(mat3(modelMatrix) * texture(u_ImpostorNormal, coords).xyz);
+    gAlbedo = texture(u_ImpostorAlbedo, coords) / coverage;
+    gPBRParams = vec4(params.rgb / coverage, 1.0);
+    gEmissive = texture(u_ImpostorEmissive, coords).rgb / coverage;
+
+    // Depth of the rebuilt surface, so impostors intersect the scene like the mesh
+    vec4 clipPosition = u_Projection * u_View * worldPosition;
+    gl_FragDepth = clipPosition.z / clipPosition.w * 0.5 + 0.5;
+}
@@ -0,0 +1,83 @@
+#version 460 core
+
+#include "../MeshInstances.glsl"
+
+// See ImpostorAtlas::ImpostorData, indexed by mesh ID
+struct Impostor {
+    vec4 boundingSphere;    // Model space center, radius
+    uint layer;
+    uint _padding0;
+    uint _padding1;
+    uint _padding2;
+};
+
+layout(std430, binding = 8) readonly buffer ImpostorBuffer {
+    Impostor impostors[];
+};
+
+// ImpostorAtlas::FRAMES
+const float FRAMES = 16.0;
+
+// Two triangles, corners of the view in [-1, 1]
+const vec2 QUAD_CORNERS[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+                                    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+uniform vec3 u_ViewPos;
+uniform mat4 u_View;
+uniform mat4 u_Projection;
+
+out vec3 AtlasCoords;           // Atlas UV, layer
+out vec3 QuadPosition;          // Model space, in the plane through the sphere center
+flat out vec3 FrameDirection;   // Model space, from the center toward the camera of the view
+flat out vec2 FrameOrigin;      // Atlas UV of the view's lower corner
+flat out float Radius;
+flat out uint InstanceIndex;
+
+vec2 signNotZero(vec2 v) {
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Octahedral map with the upper hemisphere in the inner diamond, as in ImpostorAtlas::getFrameDirection
+vec2 octahedralEncode(vec3 direction) {
+    direction /= abs(direction.x) + abs(direction.y) + abs(direction.z);
+    vec2 p = direction.xz;
+    if (direction.y < 0.0) {
+        p = (1.0 - abs(p.yx)) * signNotZero(p);
+    }
+    return p;
+}
+
+vec3 octahedralDecode(vec2 p) {
+    vec3 direction = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+    if (direction.y < 0.0) {
+        direction.xz = (1.0 - abs(direction.zx)) * signNotZero(direction.xz);
+    }
+    return normalize(direction);
+}
+
+void main() {
+    InstanceIndex = gl_BaseInstance + gl_InstanceID;
+    InstanceData instance = instances[InstanceIndex];
+    Impostor impostor = impostors[instance.meshId];
+    vec3 center = impostor.boundingSphere.xyz;
+    Radius = impostor.boundingSphere.w;
+
+    // View whose direction is closest to the camera's, in model space
+    vec3 cameraPosition = (inverse(instance.modelMatrix) * vec4(u_ViewPos, 1.0)).xyz;
+    vec2 grid = octahedralEncode(normalize(cameraPosition - center)) * 0.5 + 0.5;
+    vec2 frame = min(floor(grid * FRAMES), FRAMES - 1.0);
+    FrameDirection = octahedralDecode((frame + 0.5) / FRAMES * 2.0 - 1.0);
+
+    // Basis of the view's camera, built like glm::lookAt in ImpostorAtlas::bake
+    vec3 forward = -FrameDirection;
+    vec3 up = abs(FrameDirection.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(forward, up));
+    up = cross(right, forward);
+
+    vec2 corner = QUAD_CORNERS[gl_VertexID];
+    QuadPosition = center + (corner.x * right + corner.y * up) * Radius;
+    FrameOrigin = frame / FRAMES;
+    AtlasCoords = vec3((frame + corner * 0.5 + 0.5) / FRAMES, float(impostor.layer));
+
+    gl_Position = u_Projection * u_View * instance.modelMatrix * vec4(QuadPosition, 1.0);
+}
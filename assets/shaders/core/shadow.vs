@@ -2,17 +2,7 @@
 
 layout (location = 0) in vec3 aPos;
 
-struct InstanceData {
-    mat4 modelMatrix;
-    vec2 uvScale;
-    uint materialId;
-    uint padding;
-};
-
-// Instance buffer with interleaved data
-layout (std430, binding = 0) buffer InstanceBuffer {
-    InstanceData instances[];
-};
+#include "MeshInstances.glsl"
 
 uniform mat4 u_LightSpaceMatrix;
 
@@ -23,6 +13,6 @@ void main() {
     mat4 modelMatrix = instance.modelMatrix;
 
     // Transform vertex position
-    vec3 worldPos = vec3(modelMatrix * vec4(aPos, 1.0));
+    vec3 worldPos = vec3(modelMatrix * vec4(dequantizePosition(aPos, instance.meshId), 1.0));
     gl_Position = u_LightSpaceMatrix * vec4(worldPos, 1.0);
 }
@@ -0,0 +1,91 @@
+#include "engine.h"
+#include "scene/scene.h"
+#include "config/settings.h"
+
+#include "system/headlessRunner.h"
+#include "debugging/profiler.h"
+#include "resources/meshCache.h"
+#include "stressScene.h"
+#include "textureReport.h"
+
+#include <chrono>
+#include <cstring>
+
+// Define globals
+InputManager inputManager;
+DebugContext DEBUG_CTX;
+
+config::GraphicsSettings settings;
+
+static void printUsage() {
+    std::cout <<
+        "FactoryGameBench [options]\n"
+        "  --scene stress|game   Generated stress scene (default) or the regular game scene\n"
+        "  --entities N          Stress objects (default 10000)\n"
+        "  --depth N             Hierarchy depth, 1 = flat (default 1)\n"
+        "  --lights N            Shadow casting lights (default 4)\n"
+        "  --scripts MIX         Script weights, e.g. bounce:0.5,scale:0.3,circle:0.1,none:0.1\n"
+        "  --seed N              RNG seed (default 1337)\n"
+        "  --ticks N             Measured ticks (default 1000)\n"
+        "  --dt S                Fixed delta time in seconds (default 1/60)\n"
+        "  --warmup N            Unmeasured warm-up ticks (default 10)\n"
+        "  --trace FILE          Write a Chrome trace of the measured ticks\n"
+        "  --stats FILE          Write the summary as .csv or .json\n"
+        "  --mesh-cache MODE     warm (default), cold (clear the mesh cache first) or off\n"
+        "  --texture-cache MODE  Same for the block compressed texture cache\n"
+        "  --shader-cache MODE   Same for the program binary cache\n"
+        "  --texture-report      Print block compression PSNR and encode times of the scene's textures\n";
+}
+
+int main(int argc, char** argv) {
+    DEBUG_CTX.mode = -1;
+    DEBUG_CTX.numDepthSlices = 50;
+
+    std::string sceneName = "stress";
+    bool textureReport = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            printUsage();
+            return 0;
+        }
+        if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            sceneName = argv[++i];
+        } else if (std::strcmp(argv[i], "--texture-report") == 0) {
+            textureReport = true;
+        }
+    }
+
+    HeadlessOptions runOptions;
+    runOptions.parse(argc, argv);
+
+    HeadlessRunner::configureMeshCache(runOptions);
+
+    Scene scene;
+    auto loadStart = std::chrono::steady_clock::now();
+    if (sceneName == "game") {
+        scene.loadScene();
+    } else {
+        StressSceneOptions sceneOptions;
+        sceneOptions.parse(argc, argv);
+        std::cout << "[Info] FactoryGameBench: stress scene, " << sceneOptions.entities << " objects, depth "
+                  << sceneOptions.hierarchyDepth << ", " << sceneOptions.lights << " lights, scripts '"
+                  << sceneOptions.scriptMix << "'\n";
+        StressScene::build(scene, sceneOptions);
+    }
+    HeadlessRunner::stubMeshUploads(scene);
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    MeshCache::Stats cacheStats = MeshCache::getStats();
+    std::cout << "[Info] FactoryGameBench: Scene setup took " << loadMs << " ms (mesh cache " << runOptions.meshCache
+              << ": " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, " << cacheStats.writes << " written)\n";
+
+    // Outside the setup timing, materials are still attached to the scene's definitions
+    if (textureReport) {
+        TextureReport::run(scene);
+    }
+
+    HeadlessRunner runner(settings);
+    runner.run(scene, runOptions);
+
+    scene.registry.clear();
+    return 0;
+}
@@ -0,0 +1,413 @@
+#include "engine.h"
+#include "scene/scene.h"
+#include "config/settings.h"
+
+// Render passes
+#include "renderer/framegraph/geometrypass.h"
+#include "renderer/framegraph/lightpass.h"
+#include "renderer/framegraph/shadowpass.h"
+#include "renderer/framegraph/skyboxpass.h"
+#include "renderer/framegraph/framegraph.h"
+#include "renderer/framegraph/debugpass.h"
+
+#include "system/offscreenContext.h"
+#include "system/headlessRunner.h"
+#include "debugging/profiler.h"
+#include "debugging/glStats.h"
+#include "resources/meshCache.h"
+#include "resources/textureCache.h"
+#include "resources/shaderCache.h"
+#include "../stressScene.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Define globals
+InputManager inputManager;
+DebugContext DEBUG_CTX;
+
+config::GraphicsSettings settings;
+
+/*
+ * FactoryGameRenderBench: renders a deterministic camera flythrough into an
+ * offscreen EGL context (Mesa llvmpipe works) and reports, per render pass,
+ * the CPU submission time and the GL work it issued.
+ */
+struct RenderBenchOptions {
+    std::string sceneName = "stress";
+    int width = 1280;
+    int height = 720;
+    float orbitRadius = 40.0f;
+    float orbitHeight = 15.0f;
+    float orbitPeriod = 10.0f;  // Seconds of simulated time per revolution
+    bool finishEachFrame = false;
+    int textureBudgetMB = 0;    // Texture residency budget, 0 keeps every texture resident
+    bool shaderVariants = true; // G-buffer programs specialised by material texture flags
+    bool compactVertices = false;
+    bool positionStreams = true;
+    bool meshLods = true;
+    bool meshletCulling = true;
+    bool impostors = true;
+    std::string outputPath;     // Final frame as PPM when set
+
+    void parse(int argc, char** argv) {
+        for (int i = 1; i < argc; ++i) {
+            const char* arg = argv[i];
+            if (std::strcmp(arg, "--finish") == 0) {
+                finishEachFrame = true;
+                continue;
+            }
+            if (std::strcmp(arg, "--no-shader-variants") == 0) {
+                shaderVariants = false;
+                continue;
+            }
+            if (std::strcmp(arg, "--compact-vertices") == 0) {
+                compactVertices = true;
+                continue;
+            }
+            if (std::strcmp(arg, "--no-position-streams") == 0) {
+                positionStreams = false;
+                continue;
+            }
+            if (std::strcmp(arg, "--no-lods") == 0) {
+                meshLods = false;
+                continue;
+            }
+            if (std::strcmp(arg, "--no-meshlets") == 0) {
+                meshletCulling = false;
+                continue;
+            }
+            if (std::strcmp(arg, "--no-impostors") == 0) {
+                impostors = false;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                break;
+            }
+
+            const char* value = argv[i + 1];
+            if (std::strcmp(arg, "--scene") == 0) {
+                sceneName = value;
+            } else if (std::strcmp(arg, "--width") == 0) {
+                width = std::atoi(value);
+            } else if (std::strcmp(arg, "--height") == 0) {
+                height = std::atoi(value);
+            } else if (std::strcmp(arg, "--radius") == 0) {
+                orbitRadius = std::strtof(value, nullptr);
+            } else if (std::strcmp(arg, "--orbit-height") == 0) {
+                orbitHeight = std::strtof(value, nullptr);
+            } else if (std::strcmp(arg, "--period") == 0) {
+                orbitPeriod = std::strtof(value, nullptr);
+            } else if (std::strcmp(arg, "--texture-budget") == 0) {
+                textureBudgetMB = std::atoi(value);
+            } else if (std::strcmp(arg, "--output") == 0) {
+                outputPath = value;
+            } else {
+                continue;
+            }
+            ++i;
+        }
+    }
+};
+
+static void printUsage() {
+    std::cout <<
+        "FactoryGameRenderBench [options]\n"
+        "  --scene stress|game   Generated stress scene (default) or the regular game scene\n"
+        "  --width N, --height N Offscreen framebuffer size (default 1280x720)\n"
+        "  --ticks N             Measured frames (default 300)\n"
+        "  --warmup N            Unmeasured warm-up frames (default 10)\n"
+        "  --dt S                Fixed delta time in seconds (default 1/60)\n"
+        "  --radius R            Camera orbit radius (default 40)\n"
+        "  --orbit-height H      Camera orbit height (default 15)\n"
+        "  --period S            Simulated seconds per orbit (default 10)\n"
+        "  --finish              glFinish after every frame, adds GPU time to the frame time\n"
+        "  --output FILE.ppm     Save the final frame for golden image comparisons\n"
+        "  --trace FILE          Write a Chrome trace of the measured frames\n"
+        "  --stats FILE          Write the profiler summary as .csv or .json\n"
+        "  --mesh-cache MODE     warm (default), cold (clear the mesh cache first) or off\n"
+        "  --texture-cache MODE  Same for the block compressed texture cache\n"
+        "  --shader-cache MODE   Same for the program binary cache\n"
+        "  --texture-budget MB   Texture residency budget, least recently drawn textures are evicted (default 0, off)\n"
+        "  --no-shader-variants  Draw the G-buffer with the generic program, branching on texture flags per fragment\n"
+        "  --compact-vertices    Upload meshes with 20 byte quantized vertices instead of 32 byte floats\n"
+        "  --no-position-streams Shadow pass reads the full interleaved vertices instead of position-only copies\n"
+        "  --no-lods             Draw every mesh at full detail regardless of its screen size\n"
+        "  --no-meshlets         Cull large meshes whole instead of per meshlet on the GPU\n"
+        "  --no-impostors        Draw far instanced meshes as meshes instead of baked impostors\n"
+        "  Stress scene: --entities N, --depth N, --lights N, --scripts MIX, --seed N\n";
+}
+
+// Deterministic orbit around the origin, a function of simulated time only
+static void placeCamera(GameObject& camera, const RenderBenchOptions& options, float time) {
+    float angle = time / options.orbitPeriod * glm::two_pi<float>();
+    glm::vec3 position(std::cos(angle) * options.orbitRadius,
+                       options.orbitHeight + std::sin(angle * 2.0f) * 2.0f,
+                       std::sin(angle) * options.orbitRadius);
+    glm::vec3 forward = glm::normalize(-position);
+
+    camera.setPosition(position);
+    camera.setRotation(glm::quatLookAt(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+}
+
+int main(int argc, char** argv) {
+    DEBUG_CTX.mode = -1;
+    DEBUG_CTX.numDepthSlices = 50;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            printUsage();
+            return 0;
+        }
+    }
+
+    RenderBenchOptions options;
+    options.parse(argc, argv);
+    HeadlessOptions runOptions;
+    runOptions.ticks = 300;
+    runOptions.parse(argc, argv);
+
+    settings.display.width = options.width;
+    settings.display.height = options.height;
+    settings.quality.compactVertices = options.compactVertices;
+    settings.quality.positionStreams = options.positionStreams;
+    settings.quality.meshLods = options.meshLods;
+    settings.quality.meshletCulling = options.meshletCulling;
+    settings.quality.impostors = options.impostors;
+
+    // ----------------------- Context Setup -----------------------
+    OffscreenContext context(options.width, options.height);
+    if (!context.init()) {
+        return 1;
+    }
+    if (!context.checkRendererSupport()) {
+        std::cerr << "[Error] FactoryGameRenderBench: " << context.getRendererName()
+                  << " can't run the deferred renderer, aborting\n";
+        return 1;
+    }
+    GLStats::install();
+
+    Profiler& profiler = Profiler::getInstance();
+    profiler.setThreadName("Main");
+
+    // ------------------------ Scene Setup --------------------------
+    HeadlessRunner::configureMeshCache(runOptions);
+    HeadlessRunner::configureTextureCache(runOptions);
+    HeadlessRunner::configureShaderCache(runOptions);
+    auto loadStart = std::chrono::steady_clock::now();
+
+    Scene scene;
+    if (options.sceneName == "game") {
+        scene.loadScene();
+    } else {
+        StressSceneOptions sceneOptions;
+        sceneOptions.parse(argc, argv);
+        StressScene::build(scene, sceneOptions);
+    }
+    // Uploads stay synchronous here so every run renders the same frames
+    SceneUtils::loadPendingMeshes(scene.meshEntityPairs);
+    double sceneLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+    // ----------------------- FrameGraph Setup -----------------------
+    Renderer renderer(settings);
+
+    FrameGraph frameGraph(scene);
+    frameGraph.addRenderPass(std::make_unique<ShadowPass>());
+    auto geometryPass = std::make_unique<GeometryPass>();
+    ShaderVariants& gBufferShaders = geometryPass->getShaderVariants();
+    gBufferShaders.setEnabled(options.shaderVariants);
+    frameGraph.addRenderPass(std::move(geometryPass));
+
+    auto skyboxPass = std::make_unique<SkyboxPass>();
+    skyboxPass->setSkyBox(scene.getSkyBox());
+    frameGraph.addRenderPass(std::move(skyboxPass));
+
+    auto lightPass = std::make_unique<LightPass>();
+    lightPass->setSkyBox(scene.getSkyBox());
+    frameGraph.addRenderPass(std::move(lightPass));
+    frameGraph.addRenderPass(std::make_unique<DebugPass>());
+
+    // ----------------------- Renderer Setup -----------------------
+    MaterialManager& matManager = MaterialManager::getInstance();
+    matManager.initialize(TEXTURE_POOL_SIZE);
+    matManager.setResidencyBudget(static_cast<size_t>(options.textureBudgetMB) * 1024 * 1024);
+
+    GLStats::reset();
+    auto uploadStart = std::chrono::steady_clock::now();
+
+    // Decode every texture in parallel up front instead of one per new material
+    std::vector<const MaterialDefinition*> materialDefs;
+    for (const auto& meshDef : scene.meshEntityPairs) {
+        materialDefs.push_back(meshDef.materialDef.get());
+    }
+    for (const auto& instanceGroup : scene.instancedMeshGroups) {
+        materialDefs.push_back(instanceGroup.materialDef.get());
+    }
+    matManager.preloadTextures(materialDefs);
+
+    for (auto& meshDef : scene.meshEntityPairs) {
+        uint32_t materialIndex = matManager.getMaterialIndex(*meshDef.materialDef);
+        Mesh mesh = renderer.initMeshBuffers(meshDef.rawMeshData);
+        mesh.materialIndex = materialIndex;
+        scene.registry.emplace<Mesh>(meshDef.entity, mesh);
+        if (renderer.getMeshLodCount(mesh.id) > 1) {
+            scene.registry.emplace<LOD>(meshDef.entity);
+        }
+    }
+
+    for (auto& instanceGroup : scene.instancedMeshGroups) {
+        uint32_t materialIndex = matManager.getMaterialIndex(*instanceGroup.materialDef);
+        Mesh instancedMesh = renderer.initMeshBuffers(instanceGroup.meshData);
+        instancedMesh.materialIndex = materialIndex;
+        SceneUtils::createInstancedMesh(scene.registry, instanceGroup.entities, instancedMesh);
+    }
+    matManager.updateMaterialBuffer();
+    uint64_t loadBytes = GLStats::get().bytesUploaded;
+    double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+
+    auto shaderStart = std::chrono::steady_clock::now();
+    {
+        PROFILE_SCOPE("SetupPasses");
+        frameGraph.setupPasses();
+        frameGraph.waitForPasses();
+    }
+    double shaderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+    GameObjectSystem gameObjectSystem(scene.registry);
+    TransformSystem transformSystem(scene.registry);
+    LightSystem lightSystem(settings, scene.registry);
+    renderer.setCameraTarget(&scene.getPrimaryCamera());
+    gameObjectSystem.startAll();
+
+    GameObject& cameraObject = scene.registry.get<GameObject>(scene.getPrimaryCameraEntity());
+
+    // -------------------- Flythrough -------------------
+    float currentTime = 0.0f;
+    auto renderFrame = [&]() {
+        PROFILE_SCOPE("Frame");
+        placeCamera(cameraObject, options, currentTime);
+        {
+            PROFILE_SCOPE("Systems");
+            gameObjectSystem.updateAll(currentTime, runOptions.deltaTime);
+            transformSystem.updateTransformComponents();
+            lightSystem.updateShadowMatrices(scene.getPrimaryCamera());
+        }
+        {
+            PROFILE_SCOPE("Rendering");
+            frameGraph.executePasses(scene.registry, scene.getPrimaryCamera(), renderer);
+        }
+        if (options.finishEachFrame) {
+            PROFILE_SCOPE("Finish");
+            glFinish();
+        }
+        currentTime += runOptions.deltaTime;
+    };
+
+    for (uint32_t i = 0; i < runOptions.warmupTicks; ++i) {
+        renderFrame();
+        profiler.endFrame();
+        // The first frame requests the variants, measured frames shouldn't fall back while they compile
+        if (i == 0) {
+            gBufferShaders.wait();
+        }
+    }
+    profiler.setStatsWindow(runOptions.ticks > 0 ? runOptions.ticks : 1);
+    if (!runOptions.tracePath.empty()) {
+        profiler.captureTrace(runOptions.ticks, runOptions.tracePath);
+    }
+
+    std::vector<GLStats::Counters> passTotals(frameGraph.getPassCount());
+    GLStats::reset();
+    gBufferShaders.resetStats();
+
+    auto runStart = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < runOptions.ticks; ++i) {
+        auto frameStart = std::chrono::steady_clock::now();
+        renderFrame();
+        profiler.endFrame();
+        profiler.record(std::chrono::duration<float>(std::chrono::steady_clock::now() - frameStart).count());
+
+        for (size_t pass = 0; pass < passTotals.size(); ++pass) {
+            passTotals[pass] += frameGraph.getPassCounters(pass);
+        }
+    }
+    glFinish();
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+    GLStats::Counters frameTotals = GLStats::get();
+
+    // ---------------------------- Report ----------------------------
+    uint32_t frames = runOptions.ticks > 0 ? runOptions.ticks : 1;
+    std::printf("[Info] FactoryGameRenderBench: %u frames at %dx%d on %s, %.2f ms total, %.1f frames/s, %.2f MB uploaded at load\n",
+                runOptions.ticks, options.width, options.height, context.getRendererName().c_str(), totalMs,
+                totalMs > 0.0 ? runOptions.ticks / (totalMs / 1000.0) : 0.0, loadBytes / (1024.0 * 1024.0));
+
+    MeshCache::Stats cacheStats = MeshCache::getStats();
+    std::printf("[Info] FactoryGameRenderBench: Startup %.2f ms scene load + %.2f ms upload (mesh cache %s: %u hits, %u misses, %u written)\n",
+                sceneLoadMs, uploadMs, runOptions.meshCache.c_str(), cacheStats.hits, cacheStats.misses, cacheStats.writes);
+    TextureCache::Stats textureStats = TextureCache::getStats();
+    std::printf("[Info] FactoryGameRenderBench: Texture cache %s: %u hits, %u misses, %u written, %.2f ms encoding\n",
+                runOptions.textureCache.c_str(), textureStats.hits, textureStats.misses, textureStats.writes, textureStats.encodeMs);
+    ShaderCache::Stats shaderStats = ShaderCache::getStats();
+    std::printf("[Info] FactoryGameRenderBench: Pass setup %.2f ms (shader cache %s: %u hits, %u misses, %u written)\n",
+                shaderMs, runOptions.shaderCache.c_str(), shaderStats.hits, shaderStats.misses, shaderStats.writes);
+    MaterialManager::ResidencyStats residency = matManager.getResidencyStats();
+    std::printf("[Info] FactoryGameRenderBench: Textures %.2f MB resident (budget %d MB): %u full, %u mip tail, %u fallback, "
+                "%u evictions, %u reloads, %u frames over budget\n",
+                residency.residentBytes / (1024.0 * 1024.0), options.textureBudgetMB, residency.residentTextures,
+                residency.mipTailTextures, residency.fallbackTextures, residency.evictions, residency.reloads,
+                residency.overBudgetFrames);
+    const Renderer::VertexStats& vertexStats = renderer.getVertexStats();
+    std::printf("[Info] FactoryGameRenderBench: Vertices %.2f MB (%u float, %u compact meshes, %.2f MB saved, "
+                "%.2f MB position streams), max error %.4f%% of extent, %.3f degrees normal\n",
+                vertexStats.vertexBytes / (1024.0 * 1024.0), vertexStats.floatMeshes, vertexStats.compactMeshes,
+                vertexStats.savedBytes / (1024.0 * 1024.0), vertexStats.positionStreamBytes / (1024.0 * 1024.0),
+                vertexStats.maxRelativePositionError * 100.0, vertexStats.maxNormalError);
+    ShaderVariants::Stats variantStats = gBufferShaders.getStats();
+    std::printf("[Info] FactoryGameRenderBench: G-buffer variants %s: %u ready, %u compiling, %u failed, "
+                "%.1f variant + %.1f generic draws per frame\n",
+                options.shaderVariants ? "on" : "off", variantStats.ready, variantStats.compiling, variantStats.failed,
+                variantStats.variantDraws / double(frames), variantStats.genericDraws / double(frames));
+
+    // Triangles drawn, instances per detail level, meshlets and impostors, averaged over the profiler history
+    std::printf("[Info] FactoryGameRenderBench: LODs %s, meshlet culling %s, impostors %s", options.meshLods ? "on" : "off",
+                options.meshletCulling ? "on" : "off", options.impostors ? "on" : "off");
+    for (uint32_t counter = 0; counter < profiler.getCounterCount(); ++counter) {
+        const Profiler::CounterStats& counterStats = profiler.getCounterStats(counter);
+        if (counterStats.seen) {
+            std::printf(", %s %.0f", profiler.getCounterName(counter), counterStats.average());
+        }
+    }
+    std::printf(" per frame\n");
+
+    // Per frame averages, CPU time is submission only unless --finish is given
+    std::printf("%-20s %10s %10s %10s %10s %12s %10s\n",
+                "pass", "cpu p50", "cpu p95", "draws", "commands", "upload KB", "states");
+    auto printRow = [frames](const char* name, const Profiler::Summary& s, const GLStats::Counters& c) {
+        std::printf("%-20s %10.4f %10.4f %10.1f %10.1f %12.2f %10.1f\n", name, s.p50Ms, s.p95Ms,
+                    c.drawCalls / double(frames), c.drawCommands / double(frames),
+                    c.bytesUploaded / 1024.0 / frames, c.stateChanges / double(frames));
+    };
+    for (size_t pass = 0; pass < frameGraph.getPassCount(); ++pass) {
+        printRow(frameGraph.getPassName(pass), profiler.getScopeSummary(frameGraph.getPassScope(pass)), passTotals[pass]);
+    }
+    printRow("Frame", profiler.getFrameSummary(), frameTotals);
+
+    const std::string& statsPath = runOptions.statsPath;
+    if (!statsPath.empty()) {
+        if (statsPath.size() >= 4 && statsPath.compare(statsPath.size() - 4, 4, ".csv") == 0) {
+            profiler.writeSummaryCSV(statsPath);
+        } else {
+            profiler.writeSummaryJSON(statsPath);
+        }
+    }
+
+    if (!options.outputPath.empty() && context.saveFramebuffer(options.outputPath)) {
+        std::cout << "[Info] FactoryGameRenderBench: Final frame written to " << options.outputPath << "\n";
+    }
+
+    scene.registry.clear();
+    return 0;
+}
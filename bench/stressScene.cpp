@@ -0,0 +1,167 @@
+#include "stressScene.h"
+
+#include "scene/scene.h"
+
+#include "BouncingMotion.h"
+#include "CircularRotation.h"
+#include "ScaleScript.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+void StressSceneOptions::parse(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = argv[i + 1];
+
+        if (std::strcmp(arg, "--entities") == 0) {
+            entities = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(arg, "--depth") == 0) {
+            hierarchyDepth = std::max(1u, static_cast<uint32_t>(std::strtoul(value, nullptr, 10)));
+        } else if (std::strcmp(arg, "--lights") == 0) {
+            lights = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(arg, "--scripts") == 0) {
+            scriptMix = value;
+        } else {
+            continue;
+        }
+        ++i;
+    }
+}
+
+namespace {
+    enum class ScriptKind { None, Bounce, Scale, Circle };
+
+    struct ScriptWeight {
+        ScriptKind kind;
+        float weight;
+    };
+
+    std::vector<ScriptWeight> parseScriptMix(const std::string& mix) {
+        std::vector<ScriptWeight> weights;
+        std::stringstream stream(mix);
+        std::string entry;
+
+        while (std::getline(stream, entry, ',')) {
+            size_t colon = entry.find(':');
+            std::string name = entry.substr(0, colon);
+            float weight = colon == std::string::npos ? 1.0f : std::strtof(entry.c_str() + colon + 1, nullptr);
+
+            ScriptKind kind;
+            if (name == "none") kind = ScriptKind::None;
+            else if (name == "bounce") kind = ScriptKind::Bounce;
+            else if (name == "scale") kind = ScriptKind::Scale;
+            else if (name == "circle") kind = ScriptKind::Circle;
+            else {
+                std::cerr << "[Warning] StressScene: Unknown script '" << name << "' in mix, ignored\n";
+                continue;
+            }
+            weights.push_back({ kind, weight });
+        }
+
+        if (weights.empty()) {
+            weights.push_back({ ScriptKind::None, 1.0f });
+        }
+        return weights;
+    }
+
+    void addScript(GameObject* object, ScriptKind kind) {
+        switch (kind) {
+            case ScriptKind::Bounce: object->addScript<BouncingMotion>(); break;
+            case ScriptKind::Scale: object->addScript<ScaleScript>(); break;
+            case ScriptKind::Circle: object->addScript<CircularRotation>(); break;
+            case ScriptKind::None: break;
+        }
+    }
+}
+
+void StressScene::build(Scene& scene, const StressSceneOptions& options) {
+    entt::registry& registry = scene.registry;
+    std::mt19937 gen(options.seed);
+    std::srand(options.seed);
+
+    // ------------------------ Camera ------------------------
+    entt::entity cameraEntity = registry.create();
+    SceneData cameraData;
+    cameraData.name = "Bench Camera";
+    cameraData.position = glm::vec3(0.0f, 10.0f, 30.0f);
+    SceneUtils::addGameObjectComponent(registry, cameraEntity, cameraData);
+    registry.emplace<Camera>(cameraEntity, Camera(cameraEntity, registry));
+    scene.setPrimaryCamera(cameraEntity);
+
+    // ------------------------ Lights ------------------------
+    for (uint32_t i = 0; i < options.lights; ++i) {
+        entt::entity lightEntity = registry.create();
+        SceneData lightData;
+        lightData.name = "Bench Light(" + std::to_string(i) + ")";
+        lightData.position = glm::vec3(std::cos(i * 1.7f) * 20.0f, 15.0f, std::sin(i * 1.7f) * 20.0f);
+        SceneUtils::addGameObjectComponent(registry, lightEntity, lightData);
+
+        Light light;
+        light.intensity = 5.0f;
+        light.castShadow = true;
+        light.isActive = true;
+        switch (i % 3) {
+            case 0:
+                light.type = LightType::Spot;
+                light.spot.innerCutoff = std::cos(glm::radians(10.0f));
+                light.spot.outerCutoff = std::cos(glm::radians(30.0f));
+                light.spot.range = 50.0f;
+                break;
+            case 1:
+                light.type = LightType::Directional;
+                light.directional.shadowOrthoSize = 20.0f;
+                break;
+            default:
+                light.type = LightType::Point;
+                light.point.radius = 25.0f;
+                break;
+        }
+        SceneUtils::addLightComponents(registry, lightEntity, light);
+    }
+
+    // ------------------------ Objects ------------------------
+    std::vector<ScriptWeight> weights = parseScriptMix(options.scriptMix);
+    std::vector<float> weightValues;
+    for (const auto& w : weights) {
+        weightValues.push_back(w.weight);
+    }
+    std::discrete_distribution<size_t> scriptDist(weightValues.begin(), weightValues.end());
+    std::uniform_real_distribution<float> posDist(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> angleDist(0.0f, 360.0f);
+
+    // All objects share one mesh, as the sphere field in the regular scene does
+    InstancedMeshGroup group;
+    group.meshData.reset(MeshGen::createSphere(8, 8));
+    group.entities.reserve(options.entities);
+
+    entt::entity parent = entt::null;
+    for (uint32_t i = 0; i < options.entities; ++i) {
+        bool isRoot = (i % options.hierarchyDepth) == 0;
+
+        entt::entity entity = registry.create();
+        SceneData data;
+        data.name = "Stress(" + std::to_string(i) + ")";
+        // Children sit at a local offset from their parent
+        data.position = isRoot ? glm::vec3(posDist(gen), 1.0f, posDist(gen)) : glm::vec3(0.0f, 1.0f, 0.0f);
+        data.eulerAngles = glm::vec3(angleDist(gen), angleDist(gen), angleDist(gen));
+        data.scale = glm::vec3(isRoot ? 0.25f : 0.9f);
+
+        GameObject* object = SceneUtils::addGameObjectComponent(registry, entity, data);
+        if (!isRoot) {
+            object->setParent(parent);
+        }
+        addScript(object, weights[scriptDist(gen)].kind);
+
+        group.entities.push_back(entity);
+        parent = entity;
+    }
+
+    scene.instancedMeshGroups.push_back(std::move(group));
+}
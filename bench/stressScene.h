@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class Scene;
+
+/*
+ * Parameterised scenes for FactoryGameBench. Everything is generated in code
+ * so runs are reproducible without assets.
+ */
+struct StressSceneOptions {
+    uint32_t entities = 10000;
+    uint32_t hierarchyDepth = 1;  // 1 = flat, N = chains of N parented objects
+    uint32_t lights = 4;          // Shadow casting, cycled spot/directional/point
+    uint32_t seed = 1337;
+
+    // Script mix as weights, e.g. "bounce:0.5,scale:0.3,circle:0.1,none:0.1"
+    std::string scriptMix = "bounce:1";
+
+    // Picks up --entities, --depth, --lights, --seed and --scripts
+    void parse(int argc, char** argv);
+};
+
+namespace StressScene {
+    void build(Scene& scene, const StressSceneOptions& options);
+}
@@ -0,0 +1,119 @@
+#include "textureReport.h"
+
+#include "scene/scene.h"
+#include "renderer/materialManager.h"
+#include "resources/resourceLoader.h"
+#include "resources/textureCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+    const char* getUsageName(TextureUsage usage) {
+        switch (usage) {
+            case TextureUsage::Color:  return "color";
+            case TextureUsage::Normal: return "normal";
+            case TextureUsage::Height: return "height";
+            default:                   return "data";
+        }
+    }
+
+    // Unique texture paths of the scene's materials, the first slot using a path picks its usage
+    std::vector<std::pair<std::string, TextureUsage>> collectTextures(const Scene& scene) {
+        std::vector<std::pair<std::string, TextureUsage>> textures;
+        std::unordered_set<std::string> seen;
+        auto collect = [&](const MaterialDefinition* def) {
+            if (!def) {
+                return;
+            }
+            const std::pair<const std::string*, uint32_t> slots[] = {
+                {&def->albedoMapPath, MATERIAL_HAS_ALBEDO_MAP},
+                {&def->normalMapPath, MATERIAL_HAS_NORMAL_MAP},
+                {&def->metallicRoughnessMapPath, MATERIAL_HAS_METALLIC_ROUGHNESS_MAP},
+                {&def->emissiveMapPath, MATERIAL_HAS_EMISSIVE_MAP},
+                {&def->heightMapPath, MATERIAL_HAS_HEIGHT_MAP},
+            };
+            for (const auto& [path, textureFlag] : slots) {
+                if (!path->empty() && seen.insert(*path).second) {
+                    textures.emplace_back(*path, MaterialManager::getTextureUsage(textureFlag));
+                }
+            }
+        };
+
+        for (const EntityMeshDefinition& meshDef : scene.meshEntityPairs) {
+            collect(meshDef.materialDef.get());
+        }
+        for (const InstancedMeshGroup& instanceGroup : scene.instancedMeshGroups) {
+            collect(instanceGroup.materialDef.get());
+        }
+        return textures;
+    }
+}
+
+void TextureReport::run(const Scene& scene) {
+    std::vector<std::pair<std::string, TextureUsage>> textures = collectTextures(scene);
+    if (textures.empty()) {
+        std::printf("[Info] TextureReport: No textures referenced by the scene\n");
+        return;
+    }
+
+    struct FormatTotals {
+        double psnrSum = 0.0;
+        uint32_t count = 0;
+        double encodeMs = 0.0;
+        uint64_t texels = 0;
+    };
+    std::map<TextureFormat, FormatTotals> totals;
+
+    // Level 0 only, encode time is wall time with the job system splitting large levels
+    std::printf("%-36s %11s %-7s %-7s %9s %11s %9s\n", "texture", "size", "usage", "format", "PSNR dB", "encode ms", "MPix/s");
+    for (const auto& [path, usage] : textures) {
+        TextureImage image;
+        image.pixels = ResourceLoader::loadImage(path, &image.width, &image.height, &image.channels);
+        if (!image.pixels) {
+            continue;
+        }
+
+        std::vector<TextureFormat> candidates;
+        if (usage == TextureUsage::Normal && image.channels >= 2) {
+            candidates = {TextureFormat::BC5};
+        } else if (usage == TextureUsage::Height || usage == TextureUsage::Normal || image.channels == 1) {
+            candidates = {TextureFormat::BC4};
+        } else {
+            candidates = {TextureFormat::BC1, TextureFormat::BC3, TextureFormat::BC7};
+        }
+        TextureFormat chosen = BlockCompression::chooseFormat(usage, image, TextureCache::getQuality());
+
+        std::string name = std::filesystem::path(path).filename().string();
+        std::string size = std::to_string(image.width) + "x" + std::to_string(image.height);
+        for (TextureFormat format : candidates) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<unsigned char> blocks = BlockCompression::encode(image.pixels, image.width, image.height, image.channels, format);
+            double encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            double psnr = BlockCompression::measurePSNR(image.pixels, image.width, image.height, image.channels, blocks.data(), format);
+
+            uint64_t texels = static_cast<uint64_t>(image.width) * image.height;
+            std::printf("%-36s %11s %-7s %s%-6s %9.2f %11.2f %9.2f\n", name.c_str(), size.c_str(), getUsageName(usage),
+                        format == chosen ? "*" : " ", BlockCompression::getFormatName(format), psnr, encodeMs,
+                        encodeMs > 0.0 ? texels / (encodeMs * 1000.0) : 0.0);
+
+            FormatTotals& formatTotals = totals[format];
+            formatTotals.psnrSum += psnr;
+            formatTotals.count++;
+            formatTotals.encodeMs += encodeMs;
+            formatTotals.texels += texels;
+        }
+    }
+
+    std::printf("%-10s %8s %14s %11s %9s\n", "format", "textures", "mean PSNR dB", "encode ms", "MPix/s");
+    for (const auto& [format, formatTotals] : totals) {
+        std::printf("%-10s %8u %14.2f %11.2f %9.2f\n", BlockCompression::getFormatName(format), formatTotals.count,
+                    formatTotals.psnrSum / formatTotals.count, formatTotals.encodeMs,
+                    formatTotals.encodeMs > 0.0 ? formatTotals.texels / (formatTotals.encodeMs * 1000.0) : 0.0);
+    }
+}
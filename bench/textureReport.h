@@ -0,0 +1,13 @@
+#pragma once
+
+class Scene;
+
+/*
+ * Block compression report for FactoryGameBench (--texture-report). Every
+ * texture the scene's materials reference is encoded in each format that
+ * fits its usage, PSNR and encode throughput are printed per texture and
+ * summed per format. The format the TextureCache would pick is marked.
+ */
+namespace TextureReport {
+    void run(const Scene& scene);
+}
@@ -1,22 +1,126 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 #include <entt/entt.hpp>
 
 #include "../renderer/material.h"
 
+class MappedFile;
+
+// Floats per vertex in the GPU layout: position + packed half UV, packed TBN quaternion
+constexpr size_t MESH_VERTEX_SIZE = 8;
+
+// Bytes per vertex in the compact GPU layout (see VertexQuantizer)
+constexpr size_t MESH_COMPACT_VERTEX_SIZE = 20;
+
+// Vertex layout a mesh is uploaded with
+enum class MeshVertexFormat : uint8_t {
+    Default,    // The renderer's choice, GraphicsSettings::quality.compactVertices
+    Float,      // MESH_VERTEX_SIZE floats
+    Compact     // 16-bit positions within the mesh bounds and a snorm16 TBN quaternion
+};
+
+// Detail levels a mesh can have, LOD 0 is the full mesh
+constexpr size_t MESH_MAX_LODS = 4;
+
+// Level of InstancedMesh members drawn as an impostor (see ImpostorAtlas), past the coarsest LOD
+constexpr uint8_t MESH_IMPOSTOR_LEVEL = 0xFF;
+
+// Index range of one detail level, every level indexes the same vertices
+struct MeshLodRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;  // Of the simplification, relative to the largest extent of the mesh
+};
+
+/*
+* Cluster of the full detail level for GPU culling (see MeshletBuilder), an
+* index range with bounds in model space. std430 layout, uploaded as is.
+*/
+struct Meshlet {
+    glm::vec4 boundingSphere = glm::vec4(0.0f);             // Center, radius
+    glm::vec4 cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);     // Average normal, sine of the spread; 1 is never backfacing
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t _padding[2] = {0, 0};
+};
+
+// Vertex buffers a draw reads, depth-only passes use the position stream when the mesh has one
+enum class MeshVertexStream : uint8_t {
+    Full,
+    Position
+};
+
+/*
+* Vertices already in the GPU layout, e.g. read from the mesh cache. The
+* pointers stay valid while the mapping is held.
+*/
+struct PackedMeshData {
+    std::shared_ptr<const MappedFile> mapping;
+    const float* vertices = nullptr;  // MESH_VERTEX_SIZE floats per vertex
+    const uint32_t* indices = nullptr;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+};
+
 struct RawMeshData {
     std::vector<glm::vec4> packedTNBFrame;
     std::vector<glm::vec3> vertices;
     std::vector<uint32_t> indices;
     std::vector<glm::vec2> uvs;
     int drawMode = GL_TRIANGLES;
+    MeshVertexFormat vertexFormat = MeshVertexFormat::Default;
+
+    // Empty for a single level, else indices hold every level back to back and lods[0] is the full mesh
+    std::vector<MeshLodRange> lods;
+    // Empty for meshes culled whole, else they cover the indices of LOD 0 in order
+    std::vector<Meshlet> meshlets;
+
+    // Used instead of the vectors above when packed.vertices is set
+    PackedMeshData packed;
+
+    bool isPacked() const { return packed.vertices != nullptr; }
+    size_t getVertexCount() const { return isPacked() ? packed.vertexCount : vertices.size(); }
+    size_t getIndexCount() const { return isPacked() ? packed.indexCount : indices.size(); }
+    // Indices of the full detail level
+    size_t getLod0IndexCount() const { return lods.empty() ? getIndexCount() : lods[0].indexCount; }
+
+    // Writes getVertexCount() * MESH_VERTEX_SIZE floats, uvs and packedTNBFrame must be filled
+    void packVertices(float* dst) const {
+        if (isPacked()) {
+            std::memcpy(dst, packed.vertices, packed.vertexCount * MESH_VERTEX_SIZE * sizeof(float));
+            return;
+        }
+
+        for (size_t i = 0; i < vertices.size(); ++i, dst += MESH_VERTEX_SIZE) {
+            // Positions (3 floats)
+            dst[0] = vertices[i].x;
+            dst[1] = vertices[i].y;
+            dst[2] = vertices[i].z;
+
+            // Packed UVs (1 float), bit-level copy of the two halfs
+            uint32_t packedUV = glm::packHalf2x16(uvs[i]);
+            std::memcpy(&dst[3], &packedUV, sizeof(uint32_t));
+
+            // Packed Normal & Tangent frame (4 floats)
+            dst[4] = packedTNBFrame[i].x;
+            dst[5] = packedTNBFrame[i].y;
+            dst[6] = packedTNBFrame[i].z;
+            dst[7] = packedTNBFrame[i].w;
+        }
+    }
 
     void clearData() {
         vertices.clear();
         uvs.clear();
         packedTNBFrame.clear();
+        packed = PackedMeshData();
 
         // Resize vectors to zero
         vertices.shrink_to_fit();
@@ -42,11 +146,20 @@ struct Mesh {
     int drawMode = GL_TRIANGLES;
 };
 
+// Detail level of a mesh entity, the AssetStreamer adds it to meshes with a LOD chain
+struct LOD {
+    uint32_t level = 0;  // Selected by the geometry pass, every pass draws it
+    float bias = 1.0f;   // Scales the projected size, below 1 switches to coarser levels sooner
+};
+
 struct EntityMeshDefinition {
     std::unique_ptr<RawMeshData> rawMeshData;
     std::unique_ptr<MaterialDefinition> materialDef;
     entt::entity entity;
 
+    // Mesh file decoded in the background (see AssetStreamer) instead of rawMeshData when set
+    std::string sourcePath;
+
     // Constructor to make creation easier
     EntityMeshDefinition(entt::entity ent) : entity(ent) {
         rawMeshData = std::make_unique<RawMeshData>();
@@ -62,11 +175,31 @@ struct EntityMeshDefinition {
     EntityMeshDefinition& operator=(const EntityMeshDefinition&) = delete;
 };
 
+/*
+* Render primitive for many entities sharing one mesh, on an entity of its
+* own (see SceneUtils::createInstancedMesh). Members hold a MeshInstance
+* instead of a Mesh, the TransformSystem writes their model matrices straight
+* into matrices, so passes hand the whole range to a RenderBatch at once.
+*/
+struct InstancedMesh {
+    Mesh mesh;
+    std::vector<entt::entity> members;
+    std::vector<glm::mat4> matrices;    // Parallel to members
+    std::vector<uint8_t> lodLevels;     // Parallel to members, selected by the geometry pass like LOD::level or MESH_IMPOSTOR_LEVEL
+    float lodBias = 1.0f;
+};
+
+// Member of an InstancedMesh, destroying it swaps the last member into its slot
+struct MeshInstance {
+    entt::entity group = entt::null;
+    uint32_t index = 0;
+};
+
+// Scene side definition of an InstancedMesh, uploaded by the AssetStreamer
 struct InstancedMeshGroup {
     std::unique_ptr<RawMeshData> meshData;
     std::unique_ptr<MaterialDefinition> materialDef;
     std::vector<entt::entity> entities;
-    Mesh* initializedMesh = nullptr;
 
     // Constructor
     InstancedMeshGroup() {
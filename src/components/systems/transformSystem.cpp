@@ -8,6 +8,7 @@
 #include <algorithm>
 
 #include "transformSystem.h"
+#include "../mesh.h"
 
 TransformSystem::TransformSystem(entt::registry& registry)
     : m_registry(registry) {}
@@ -38,6 +39,13 @@ void TransformSystem::updateTransformRecursive(const entt::entity& entity, const
     modelMatrix.matrix = parentMatrix * localMatrix;
     entStatus.reset(EntityStatus::DIRTY_MODEL_MATRIX);
 
+    // Instanced members draw from their group's range
+    if (const MeshInstance* instance = m_registry.try_get<MeshInstance>(entity)) {
+        if (InstancedMesh* group = m_registry.try_get<InstancedMesh>(instance->group)) {
+            group->matrices[instance->index] = modelMatrix.matrix;
+        }
+    }
+
     if (m_registry.all_of<Children>(entity)) {
         const auto& children = m_registry.get<Children>(entity).children;
         for (auto& child : children) {
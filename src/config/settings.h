@@ -25,6 +25,15 @@ struct GraphicsSettings {
     struct QualitySettings {
         int msaaSamples = 4;
         int textureQuality = 2;  // 0=low, 1=medium, 2=high
+        int textureBudgetMB = 0; // GPU memory for material textures, 0=unlimited
+        bool compactVertices = false; // 20 byte quantized vertices instead of 32 byte floats
+        bool positionStreams = true;  // Position-only copy of every mesh for the shadow pass
+        bool meshLods = true;         // Simplified levels for meshes that cover little of the screen
+        float lodScreenSize = 0.25f;  // Height fraction below which LOD 1 is drawn, halved for every further level
+        float lodHysteresis = 0.15f;  // Fraction past a threshold before the level changes back
+        bool meshletCulling = true;   // GPU frustum and backface culling of large meshes per meshlet
+        bool impostors = true;        // Baked billboards for far members of instanced meshes
+        float impostorScreenSize = 0.02f;  // Height fraction below which a member is drawn as its impostor
         float gamma = 2.2f;
     } quality;
 
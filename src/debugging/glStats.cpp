@@ -0,0 +1,174 @@
+#include "glStats.h"
+
+#include <glad/glad.h>
+
+namespace {
+    GLStats::Counters s_counters;
+    bool s_installed = false;
+
+    uint64_t bytesPerPixel(GLenum format, GLenum type) {
+        switch (type) {
+            case GL_UNSIGNED_INT_24_8:
+            case GL_UNSIGNED_INT_8_8_8_8:
+            case GL_UNSIGNED_INT_2_10_10_10_REV:
+                return 4;
+            default:
+                break;
+        }
+
+        uint64_t components = 4;
+        switch (format) {
+            case GL_RED:
+            case GL_RED_INTEGER:
+            case GL_DEPTH_COMPONENT:
+            case GL_STENCIL_INDEX:
+                components = 1;
+                break;
+            case GL_RG:
+            case GL_RG_INTEGER:
+                components = 2;
+                break;
+            case GL_RGB:
+            case GL_BGR:
+            case GL_RGB_INTEGER:
+                components = 3;
+                break;
+            default:
+                break;
+        }
+
+        switch (type) {
+            case GL_UNSIGNED_BYTE:
+            case GL_BYTE:
+                return components;
+            case GL_UNSIGNED_SHORT:
+            case GL_SHORT:
+            case GL_HALF_FLOAT:
+                return components * 2;
+            default:
+                return components * 4;
+        }
+    }
+}
+
+// Keeps the original GLAD pointer and defines a wrapper that counts, then forwards
+#define GLSTATS_WRAP(name, pfn, params, args, count) \
+    static pfn s_##name = nullptr;                    \
+    static void APIENTRY counted_##name params {      \
+        count;                                        \
+        s_##name args;                                \
+    }
+
+GLSTATS_WRAP(DrawArrays, PFNGLDRAWARRAYSPROC,
+    (GLenum mode, GLint first, GLsizei count), (mode, first, count),
+    (s_counters.drawCalls++, s_counters.drawCommands++))
+GLSTATS_WRAP(DrawElements, PFNGLDRAWELEMENTSPROC,
+    (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices),
+    (s_counters.drawCalls++, s_counters.drawCommands++))
+GLSTATS_WRAP(DrawArraysInstanced, PFNGLDRAWARRAYSINSTANCEDPROC,
+    (GLenum mode, GLint first, GLsizei count, GLsizei instances), (mode, first, count, instances),
+    (s_counters.drawCalls++, s_counters.drawCommands++))
+GLSTATS_WRAP(DrawElementsInstanced, PFNGLDRAWELEMENTSINSTANCEDPROC,
+    (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances), (mode, count, type, indices, instances),
+    (s_counters.drawCalls++, s_counters.drawCommands++))
+GLSTATS_WRAP(MultiDrawArraysIndirect, PFNGLMULTIDRAWARRAYSINDIRECTPROC,
+    (GLenum mode, const void* indirect, GLsizei drawCount, GLsizei stride), (mode, indirect, drawCount, stride),
+    (s_counters.drawCalls++, s_counters.drawCommands += static_cast<uint64_t>(drawCount)))
+GLSTATS_WRAP(MultiDrawElementsIndirect, PFNGLMULTIDRAWELEMENTSINDIRECTPROC,
+    (GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride), (mode, type, indirect, drawCount, stride),
+    (s_counters.drawCalls++, s_counters.drawCommands += static_cast<uint64_t>(drawCount)))
+// The number of commands is on the GPU, only the call counts
+GLSTATS_WRAP(MultiDrawElementsIndirectCount, PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC,
+    (GLenum mode, GLenum type, const void* indirect, GLintptr drawCount, GLsizei maxDrawCount, GLsizei stride),
+    (mode, type, indirect, drawCount, maxDrawCount, stride),
+    s_counters.drawCalls++)
+
+GLSTATS_WRAP(BufferData, PFNGLBUFFERDATAPROC,
+    (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage),
+    if (data) s_counters.bytesUploaded += static_cast<uint64_t>(size))
+GLSTATS_WRAP(BufferSubData, PFNGLBUFFERSUBDATAPROC,
+    (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data),
+    s_counters.bytesUploaded += static_cast<uint64_t>(size))
+GLSTATS_WRAP(TexImage2D, PFNGLTEXIMAGE2DPROC,
+    (GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels),
+    (target, level, internalFormat, width, height, border, format, type, pixels),
+    if (pixels) s_counters.bytesUploaded += static_cast<uint64_t>(width) * height * bytesPerPixel(format, type))
+GLSTATS_WRAP(CompressedTexImage2D, PFNGLCOMPRESSEDTEXIMAGE2DPROC,
+    (GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data),
+    (target, level, internalFormat, width, height, border, imageSize, data),
+    if (data) s_counters.bytesUploaded += static_cast<uint64_t>(imageSize))
+GLSTATS_WRAP(TexSubImage2D, PFNGLTEXSUBIMAGE2DPROC,
+    (GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels),
+    (target, level, x, y, width, height, format, type, pixels),
+    if (pixels) s_counters.bytesUploaded += static_cast<uint64_t>(width) * height * bytesPerPixel(format, type))
+
+GLSTATS_WRAP(BindVertexArray, PFNGLBINDVERTEXARRAYPROC, (GLuint array), (array), s_counters.stateChanges++)
+GLSTATS_WRAP(UseProgram, PFNGLUSEPROGRAMPROC, (GLuint program), (program), s_counters.stateChanges++)
+GLSTATS_WRAP(BindTexture, PFNGLBINDTEXTUREPROC, (GLenum target, GLuint texture), (target, texture), s_counters.stateChanges++)
+GLSTATS_WRAP(ActiveTexture, PFNGLACTIVETEXTUREPROC, (GLenum texture), (texture), s_counters.stateChanges++)
+GLSTATS_WRAP(BindFramebuffer, PFNGLBINDFRAMEBUFFERPROC, (GLenum target, GLuint framebuffer), (target, framebuffer), s_counters.stateChanges++)
+GLSTATS_WRAP(BindBuffer, PFNGLBINDBUFFERPROC, (GLenum target, GLuint buffer), (target, buffer), s_counters.stateChanges++)
+GLSTATS_WRAP(BindBufferBase, PFNGLBINDBUFFERBASEPROC, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), s_counters.stateChanges++)
+GLSTATS_WRAP(Enable, PFNGLENABLEPROC, (GLenum cap), (cap), s_counters.stateChanges++)
+GLSTATS_WRAP(Disable, PFNGLDISABLEPROC, (GLenum cap), (cap), s_counters.stateChanges++)
+GLSTATS_WRAP(Viewport, PFNGLVIEWPORTPROC, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), s_counters.stateChanges++)
+GLSTATS_WRAP(DepthFunc, PFNGLDEPTHFUNCPROC, (GLenum func), (func), s_counters.stateChanges++)
+GLSTATS_WRAP(DepthMask, PFNGLDEPTHMASKPROC, (GLboolean flag), (flag), s_counters.stateChanges++)
+GLSTATS_WRAP(CullFace, PFNGLCULLFACEPROC, (GLenum mode), (mode), s_counters.stateChanges++)
+GLSTATS_WRAP(BlendFunc, PFNGLBLENDFUNCPROC, (GLenum src, GLenum dst), (src, dst), s_counters.stateChanges++)
+
+#define GLSTATS_INSTALL(name)                \
+    if (glad_gl##name && !s_##name) {        \
+        s_##name = glad_gl##name;            \
+        glad_gl##name = counted_##name;      \
+    }
+
+namespace GLStats {
+    void install() {
+        if (s_installed) {
+            return;
+        }
+
+        GLSTATS_INSTALL(DrawArrays)
+        GLSTATS_INSTALL(DrawElements)
+        GLSTATS_INSTALL(DrawArraysInstanced)
+        GLSTATS_INSTALL(DrawElementsInstanced)
+        GLSTATS_INSTALL(MultiDrawArraysIndirect)
+        GLSTATS_INSTALL(MultiDrawElementsIndirect)
+        GLSTATS_INSTALL(MultiDrawElementsIndirectCount)
+        GLSTATS_INSTALL(BufferData)
+        GLSTATS_INSTALL(BufferSubData)
+        GLSTATS_INSTALL(TexImage2D)
+        GLSTATS_INSTALL(CompressedTexImage2D)
+        GLSTATS_INSTALL(TexSubImage2D)
+        GLSTATS_INSTALL(BindVertexArray)
+        GLSTATS_INSTALL(UseProgram)
+        GLSTATS_INSTALL(BindTexture)
+        GLSTATS_INSTALL(ActiveTexture)
+        GLSTATS_INSTALL(BindFramebuffer)
+        GLSTATS_INSTALL(BindBuffer)
+        GLSTATS_INSTALL(BindBufferBase)
+        GLSTATS_INSTALL(Enable)
+        GLSTATS_INSTALL(Disable)
+        GLSTATS_INSTALL(Viewport)
+        GLSTATS_INSTALL(DepthFunc)
+        GLSTATS_INSTALL(DepthMask)
+        GLSTATS_INSTALL(CullFace)
+        GLSTATS_INSTALL(BlendFunc)
+
+        s_counters = Counters();
+        s_installed = true;
+    }
+
+    bool isInstalled() {
+        return s_installed;
+    }
+
+    const Counters& get() {
+        return s_counters;
+    }
+
+    void reset() {
+        s_counters = Counters();
+    }
+}
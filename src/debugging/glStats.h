@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * OpenGL call counters for render benchmarks.
+ *
+ * install() swaps GLAD's function pointers for counting wrappers, so nothing
+ * in the renderer changes and builds that never call it pay nothing. Must be
+ * called after GLAD is loaded, on the thread that owns the context.
+ */
+namespace GLStats {
+    struct Counters {
+        uint64_t drawCalls = 0;      // glDraw* and glMultiDraw* calls
+        uint64_t drawCommands = 0;   // Draws issued, a multi-draw counts each of its commands
+        uint64_t bytesUploaded = 0;  // glBufferData / glBufferSubData / glTex(Sub)Image2D with client data
+        uint64_t stateChanges = 0;   // Binds, glUseProgram, glEnable/glDisable and fixed function state
+
+        Counters& operator+=(const Counters& other) {
+            drawCalls += other.drawCalls;
+            drawCommands += other.drawCommands;
+            bytesUploaded += other.bytesUploaded;
+            stateChanges += other.stateChanges;
+            return *this;
+        }
+
+        Counters operator-(const Counters& other) const {
+            Counters result;
+            result.drawCalls = drawCalls - other.drawCalls;
+            result.drawCommands = drawCommands - other.drawCommands;
+            result.bytesUploaded = bytesUploaded - other.bytesUploaded;
+            result.stateChanges = stateChanges - other.stateChanges;
+            return result;
+        }
+    };
+
+    void install();
+    bool isInstalled();
+
+    // Running totals since install() or the last reset()
+    const Counters& get();
+    void reset();
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/*
+ * HDR style histogram over a sliding window of samples.
+ *
+ * Values (nanoseconds) are bucketed log-linearly: every power of two range is
+ * split into SUB_BUCKETS linear buckets, so any recorded value is reported
+ * within ~3% regardless of magnitude. The window keeps the raw samples so
+ * evicted ones can be removed again, making percentiles exact per bucket
+ * over the last N samples instead of decaying averages.
+ */
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 5;
+    static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_SHIFT = 40; // ~18 minutes in ns, larger values are clamped
+    static constexpr uint32_t BUCKET_COUNT = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+    explicit LatencyHistogram(uint32_t windowSize = 600) {
+        setWindow(windowSize);
+    }
+
+    void setWindow(uint32_t windowSize) {
+        m_window.assign(std::max(windowSize, 1u), 0);
+        m_buckets.assign(BUCKET_COUNT, 0);
+        m_head = 0;
+        m_count = 0;
+    }
+
+    void add(uint64_t valueNs) {
+        if (m_count == m_window.size()) {
+            m_buckets[bucketIndex(m_window[m_head])]--;
+        } else {
+            m_count++;
+        }
+
+        m_window[m_head] = valueNs;
+        m_head = (m_head + 1) % m_window.size();
+        m_buckets[bucketIndex(valueNs)]++;
+    }
+
+    // Upper edge of the bucket holding the requested percentile (never above max), 0 when empty
+    uint64_t percentile(double p) const {
+        if (m_count == 0) return 0;
+
+        uint64_t target = static_cast<uint64_t>(p / 100.0 * static_cast<double>(m_count) + 0.5);
+        target = std::clamp<uint64_t>(target, 1, m_count);
+
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += m_buckets[i];
+            if (seen >= target) {
+                return std::min(bucketUpperBound(i), max());
+            }
+        }
+        return max();
+    }
+
+    // Exact maximum of the samples currently in the window
+    uint64_t max() const {
+        uint64_t result = 0;
+        for (size_t i = 0; i < m_count; ++i) {
+            result = std::max(result, m_window[i]);
+        }
+        return result;
+    }
+
+    double mean() const {
+        if (m_count == 0) return 0.0;
+        double sum = 0.0;
+        for (size_t i = 0; i < m_count; ++i) {
+            sum += static_cast<double>(m_window[i]);
+        }
+        return sum / static_cast<double>(m_count);
+    }
+
+    size_t count() const { return m_count; }
+    size_t windowSize() const { return m_window.size(); }
+
+private:
+    std::vector<uint64_t> m_window;
+    std::vector<uint32_t> m_buckets;
+    size_t m_head = 0;
+    size_t m_count = 0;
+
+    static uint32_t highestBit(uint64_t value) {
+        uint32_t bit = 0;
+        while (value >>= 1) {
+            ++bit;
+        }
+        return bit;
+    }
+
+    static uint32_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<uint32_t>(value);
+        }
+
+        // value >> shift lands in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+        uint32_t shift = highestBit(value) - SUB_BUCKET_BITS;
+        if (shift > MAX_SHIFT) {
+            return BUCKET_COUNT - 1;
+        }
+        uint32_t sub = static_cast<uint32_t>(value >> shift) - SUB_BUCKETS;
+        return (shift + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t bucketUpperBound(uint32_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        uint32_t shift = index / SUB_BUCKETS - 1;
+        uint64_t sub = index % SUB_BUCKETS + SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+};
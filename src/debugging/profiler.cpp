@@ -0,0 +1,396 @@
+#include "profiler.h"
+
+#include <fstream>
+#include <json/json.hpp>
+#include <iostream>
+
+Profiler::Profiler() {
+    m_startTime = std::chrono::steady_clock::now();
+    m_startNs = Profiling::nowNanoseconds();
+}
+
+Profiler& Profiler::getInstance() {
+    static Profiler instance;
+    return instance;
+}
+
+uint32_t Profiler::registerScope(uint32_t id, const char* name) {
+    std::lock_guard<std::mutex> lock(m_registerMutex);
+
+    uint32_t count = m_scopeCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_scopes[i].id == id) {
+            return i;
+        }
+    }
+
+    // The last slot is kept for scopes past the limit, so they don't merge into a real scope's row
+    if (count >= OVERFLOW_SCOPE) {
+        if (count == OVERFLOW_SCOPE) {
+            std::cerr << "[Warning] Profiler::registerScope: Scope limit reached, '" << name
+                      << "' and later scopes are timed as '" << OVERFLOW_SCOPE_NAME << "'\n";
+            m_scopes[OVERFLOW_SCOPE].id = 0;
+            m_scopes[OVERFLOW_SCOPE].name = OVERFLOW_SCOPE_NAME;
+            m_scopeCount.store(PROFILER_MAX_SCOPES, std::memory_order_release);
+        }
+        return OVERFLOW_SCOPE;
+    }
+
+    m_scopes[count].id = id;
+    m_scopes[count].name = name;
+    m_scopeCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+uint32_t Profiler::registerCounter(const char* name) {
+    for (uint32_t i = 0; i < m_counterCount; ++i) {
+        if (m_counterNames[i] == name) {
+            return i;
+        }
+    }
+
+    if (m_counterCount >= PROFILER_MAX_COUNTERS) {
+        std::cerr << "[Error] Profiler::registerCounter: Counter limit reached, dropping '" << name << "'\n";
+        return PROFILER_MAX_COUNTERS - 1;
+    }
+
+    m_counterNames[m_counterCount] = name;
+    return m_counterCount++;
+}
+
+ThreadEventBuffer* Profiler::acquireThreadBuffer() {
+    std::lock_guard<std::mutex> lock(m_threadMutex);
+
+    // Buffers are owned by the profiler so events survive the thread exiting
+    auto buffer = std::make_unique<ThreadEventBuffer>();
+    buffer->threadIndex = static_cast<uint32_t>(m_threadBuffers.size());
+    t_threadBuffer = buffer.get();
+    m_threadBuffers.push_back(std::move(buffer));
+    return t_threadBuffer;
+}
+
+void Profiler::setThreadName(const std::string& name) {
+    if (!t_threadBuffer) {
+        acquireThreadBuffer();
+    }
+
+    std::lock_guard<std::mutex> lock(m_threadMutex);
+    t_threadBuffer->name = name;
+}
+
+void Profiler::endFrame() {
+    {
+        std::lock_guard<std::mutex> lock(m_threadMutex);
+        for (auto& buffer : m_threadBuffers) {
+            uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+            uint32_t head = buffer->head.load(std::memory_order_acquire);
+
+            for (; tail != head; ++tail) {
+                const ProfileEvent& event = buffer->events[tail & (PROFILER_THREAD_BUFFER_SIZE - 1)];
+                m_frameNs[event.scope] += event.endNs - event.startNs;
+                m_frameCalls[event.scope]++;
+
+                TraceEvent traceEvent = { event.scope, buffer->threadIndex, event.startNs, event.endNs };
+                if (m_trace.size() < PROFILER_TRACE_CAPACITY) {
+                    m_trace.push_back(traceEvent);
+                } else {
+                    m_trace[m_traceHead] = traceEvent;
+                    m_traceHead = (m_traceHead + 1) % PROFILER_TRACE_CAPACITY;
+                }
+            }
+            buffer->tail.store(tail, std::memory_order_release);
+
+            m_droppedEvents += buffer->dropped.exchange(0, std::memory_order_relaxed);
+        }
+    }
+
+    m_frameIndex++;
+
+    uint32_t count = getScopeCount();
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_frameCalls[i] == 0) {
+            continue;
+        }
+
+        ScopeStats& stats = m_stats[i];
+        stats.lastMs = static_cast<double>(m_frameNs[i]) / 1.0e6;
+        stats.lastCalls = m_frameCalls[i];
+        stats.lastFrame = m_frameIndex;
+        stats.seen = true;
+        stats.history.push(stats.lastMs);
+
+        if (!stats.histogram) {
+            stats.histogram = std::make_unique<LatencyHistogram>(m_statsWindow);
+        }
+        stats.histogram->add(m_frameNs[i]);
+
+        m_frameNs[i] = 0;
+        m_frameCalls[i] = 0;
+    }
+
+    // Counters nobody added to this frame keep their last value out of the history
+    for (uint32_t i = 0; i < m_counterCount; ++i) {
+        if (!m_counterTouched[i]) {
+            continue;
+        }
+
+        CounterStats& stats = m_counters[i];
+        stats.lastValue = m_counterFrame[i];
+        stats.seen = true;
+        stats.history.push(static_cast<double>(m_counterFrame[i]));
+        m_counterFrame[i] = 0;
+        m_counterTouched[i] = false;
+    }
+
+    if (m_captureFramesLeft > 0 && --m_captureFramesLeft == 0) {
+        exportChromeTrace(m_capturePath);
+    }
+}
+
+void Profiler::record(float deltaTime) {
+    if (deltaTime <= 0.0f) {
+        return;
+    }
+
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+    double frameMs = static_cast<double>(deltaTime) * 1000.0;
+    m_fpsHistory.push({time, 1.0f / deltaTime});
+    m_frameHistogram.add(static_cast<uint64_t>(frameMs * 1.0e6));
+
+    if (frameMs <= m_spikeThresholdMs) {
+        return;
+    }
+
+    // Capture every scope that was timed during this frame
+    FrameSpike spike;
+    spike.frame = m_frameIndex;
+    spike.time = time;
+    spike.frameMs = frameMs;
+
+    uint32_t count = getScopeCount();
+    for (uint32_t i = 0; i < count; ++i) {
+        const ScopeStats& stats = m_stats[i];
+        if (stats.seen && stats.lastFrame == m_frameIndex) {
+            spike.scopes.push_back({ i, stats.lastMs, stats.lastCalls });
+        }
+    }
+
+    m_spikes.push(spike);
+    m_spikeCount++;
+}
+
+/*
+ * Percentile statistics
+ */
+static Profiler::Summary summarize(const LatencyHistogram& histogram) {
+    Profiler::Summary summary;
+    summary.samples = histogram.count();
+    summary.meanMs = histogram.mean() / 1.0e6;
+    summary.p50Ms = static_cast<double>(histogram.percentile(50.0)) / 1.0e6;
+    summary.p95Ms = static_cast<double>(histogram.percentile(95.0)) / 1.0e6;
+    summary.p99Ms = static_cast<double>(histogram.percentile(99.0)) / 1.0e6;
+    summary.maxMs = static_cast<double>(histogram.max()) / 1.0e6;
+    return summary;
+}
+
+void Profiler::setStatsWindow(uint32_t frames) {
+    m_statsWindow = frames > 0 ? frames : 1;
+    m_frameHistogram.setWindow(m_statsWindow);
+    for (auto& stats : m_stats) {
+        if (stats.histogram) {
+            stats.histogram->setWindow(m_statsWindow);
+        }
+    }
+}
+
+Profiler::Summary Profiler::getScopeSummary(uint32_t scope) const {
+    const ScopeStats& stats = m_stats[scope];
+    return stats.histogram ? summarize(*stats.histogram) : Summary{};
+}
+
+Profiler::Summary Profiler::getFrameSummary() const {
+    return summarize(m_frameHistogram);
+}
+
+bool Profiler::writeSummaryCSV(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[Error] Profiler::writeSummaryCSV: Failed to open " << path << "\n";
+        return false;
+    }
+
+    out << "scope,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    // Quoted per RFC 4180, quotes inside the name are doubled
+    auto writeRow = [&out](const std::string& name, const Summary& s) {
+        out << '"';
+        for (char c : name) {
+            if (c == '"') {
+                out << '"';
+            }
+            out << c;
+        }
+        out << "\"," << s.samples << ',' << s.meanMs << ',' << s.p50Ms << ','
+            << s.p95Ms << ',' << s.p99Ms << ',' << s.maxMs << '\n';
+    };
+
+    writeRow("FrameTime", getFrameSummary());
+    uint32_t count = getScopeCount();
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_stats[i].seen) {
+            writeRow(m_scopes[i].name, getScopeSummary(i));
+        }
+    }
+
+    out.flush();
+    if (!out.good()) {
+        std::cerr << "[Error] Profiler::writeSummaryCSV: Failed writing " << path << "\n";
+        return false;
+    }
+
+    std::cout << "[Info] Profiler::writeSummaryCSV: Wrote " << path << "\n";
+    return true;
+}
+
+bool Profiler::writeSummaryJSON(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[Error] Profiler::writeSummaryJSON: Failed to open " << path << "\n";
+        return false;
+    }
+
+    auto toJson = [](const Summary& s) {
+        return nlohmann::json{
+            {"samples", s.samples}, {"mean_ms", s.meanMs}, {"p50_ms", s.p50Ms},
+            {"p95_ms", s.p95Ms}, {"p99_ms", s.p99Ms}, {"max_ms", s.maxMs}
+        };
+    };
+
+    nlohmann::json root;
+    root["window_frames"] = m_statsWindow;
+    root["frames"] = m_frameIndex;
+    root["spike_threshold_ms"] = m_spikeThresholdMs;
+    root["spike_count"] = m_spikeCount;
+    root["frame_time"] = toJson(getFrameSummary());
+
+    nlohmann::json scopes = nlohmann::json::object();
+    uint32_t count = getScopeCount();
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_stats[i].seen) {
+            scopes[m_scopes[i].name] = toJson(getScopeSummary(i));
+        }
+    }
+    root["scopes"] = scopes;
+
+    nlohmann::json counters = nlohmann::json::object();
+    for (uint32_t i = 0; i < m_counterCount; ++i) {
+        if (m_counters[i].seen) {
+            counters[m_counterNames[i]] = { {"last", m_counters[i].lastValue}, {"mean", m_counters[i].average()} };
+        }
+    }
+    root["counters"] = counters;
+
+    nlohmann::json spikes = nlohmann::json::array();
+    for (size_t i = 0; i < m_spikes.size(); ++i) {
+        const FrameSpike& spike = m_spikes[i];
+        nlohmann::json timings = nlohmann::json::object();
+        for (const auto& sample : spike.scopes) {
+            timings[m_scopes[sample.scope].name] = { {"ms", sample.ms}, {"calls", sample.calls} };
+        }
+        spikes.push_back({ {"frame", spike.frame}, {"time_s", spike.time}, {"frame_ms", spike.frameMs}, {"scopes", timings} });
+    }
+    root["spikes"] = spikes;
+
+    out << root.dump(2) << "\n";
+    out.flush();
+    if (!out.good()) {
+        std::cerr << "[Error] Profiler::writeSummaryJSON: Failed writing " << path << "\n";
+        return false;
+    }
+
+    std::cout << "[Info] Profiler::writeSummaryJSON: Wrote " << path << "\n";
+    return true;
+}
+
+/*
+ * Trace export
+ */
+static void writeJsonString(std::ofstream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        switch (c) {
+            case '"':  out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) >= 0x20) {
+                    out << c;
+                }
+                break;
+        }
+    }
+    out << '"';
+}
+
+void Profiler::captureTrace(uint32_t frameCount, const std::string& path) {
+    m_trace.clear();
+    m_traceHead = 0;
+    if (frameCount == 0) {
+        exportChromeTrace(path);
+        return;
+    }
+
+    m_capturePath = path;
+    m_captureFramesLeft = frameCount;
+    std::cout << "[Info] Profiler::captureTrace: Capturing " << frameCount << " frames to " << path << "\n";
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "[Error] Profiler::exportChromeTrace: Failed to open " << path << "\n";
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    // Thread names first so viewers label the tracks
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(m_threadMutex);
+        for (const auto& buffer : m_threadBuffers) {
+            std::string name = buffer->name.empty() ? "Thread " + std::to_string(buffer->threadIndex) : buffer->name;
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadIndex
+                << ",\"args\":{\"name\":";
+            writeJsonString(out, name);
+            out << "}}";
+            first = false;
+        }
+    }
+
+    // Complete events in ring order, oldest first. Timestamps are microseconds.
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    for (size_t i = 0; i < m_trace.size(); ++i) {
+        const TraceEvent& event = m_trace[(m_traceHead + i) % m_trace.size()];
+        double ts = static_cast<double>(static_cast<int64_t>(event.startNs - m_startNs)) / 1000.0;
+        double dur = static_cast<double>(event.endNs - event.startNs) / 1000.0;
+
+        out << (first ? "" : ",\n") << "{\"name\":";
+        writeJsonString(out, m_scopes[event.scope].name);
+        out << ",\"cat\":\"scope\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+        first = false;
+    }
+
+    out << "\n]}\n";
+    out.flush();
+    if (!out.good()) {
+        std::cerr << "[Error] Profiler::exportChromeTrace: Failed writing " << path << "\n";
+        return false;
+    }
+
+    std::cout << "[Info] Profiler::exportChromeTrace: Wrote " << m_trace.size() << " events to " << path << "\n";
+    return true;
+}
@@ -0,0 +1,352 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "latencyHistogram.h"
+
+#define MAX_FPS_HISTORY 10000
+#define PROFILER_HISTORY_SIZE 60
+#define PROFILER_MAX_SCOPES 512
+#define PROFILER_MAX_SCOPE_DEPTH 64
+#define PROFILER_THREAD_BUFFER_SIZE 4096 // Must be a power of two
+#define PROFILER_TRACE_CAPACITY 131072 // Events kept for trace export
+#define PROFILER_STATS_WINDOW 600 // Frames covered by the percentile stats
+#define PROFILER_MAX_SPIKES 64
+#define PROFILER_MAX_COUNTERS 64
+
+namespace Profiling {
+    // FNV-1a, constexpr so PROFILE_SCOPE ids are folded at compile time
+    constexpr uint32_t hashLabel(const char* str) {
+        uint32_t hash = 2166136261u;
+        while (*str != '\0') {
+            hash ^= static_cast<uint8_t>(*str++);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    inline uint64_t nowNanoseconds() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+/*
+ * Fixed size history, push is O(1) and overwrites the oldest sample.
+ * Index 0 is the oldest sample, size() - 1 the newest.
+ */
+template <typename T, size_t N>
+class RingBuffer {
+public:
+    void push(const T& value) {
+        m_data[m_head] = value;
+        m_head = (m_head + 1) % N;
+        if (m_size < N) {
+            ++m_size;
+        }
+    }
+
+    const T& operator[](size_t index) const {
+        return m_data[(m_head + N - m_size + index) % N];
+    }
+
+    const T& back() const { return (*this)[m_size - 1]; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    static constexpr size_t capacity() { return N; }
+
+    void clear() {
+        m_head = 0;
+        m_size = 0;
+    }
+
+private:
+    std::array<T, N> m_data{};
+    size_t m_head = 0;
+    size_t m_size = 0;
+};
+
+/*
+ * Per-thread event storage. The owning thread is the only producer and the
+ * profiler (main thread) the only consumer, so head/tail are enough to keep
+ * it lock-free.
+ */
+struct ProfileEvent {
+    uint32_t scope;
+    uint32_t depth;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+struct ThreadEventBuffer {
+    struct OpenScope {
+        uint32_t scope;
+        uint64_t startNs;
+    };
+
+    std::array<ProfileEvent, PROFILER_THREAD_BUFFER_SIZE> events;
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> dropped{0};
+
+    // Only touched by the owning thread
+    std::array<OpenScope, PROFILER_MAX_SCOPE_DEPTH> stack;
+    uint32_t depth = 0;
+
+    uint32_t threadIndex = 0;
+    std::string name;
+
+    void push(const ProfileEvent& event) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= PROFILER_THREAD_BUFFER_SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[h & (PROFILER_THREAD_BUFFER_SIZE - 1)] = event;
+        head.store(h + 1, std::memory_order_release);
+    }
+};
+
+class Profiler {
+public:
+    struct ScopeStats {
+        double lastMs = 0.0;
+        uint32_t lastCalls = 0;
+        uint64_t lastFrame = 0;
+        bool seen = false;
+        RingBuffer<double, PROFILER_HISTORY_SIZE> history;
+        std::unique_ptr<LatencyHistogram> histogram; // Allocated on first sample
+
+        double averageMs() const {
+            if (history.empty()) return 0.0;
+            double sum = 0.0;
+            for (size_t i = 0; i < history.size(); ++i) {
+                sum += history[i];
+            }
+            return sum / static_cast<double>(history.size());
+        }
+    };
+
+    // Per frame total of a counter, e.g. triangles drawn
+    struct CounterStats {
+        uint64_t lastValue = 0;
+        bool seen = false;
+        RingBuffer<double, PROFILER_HISTORY_SIZE> history;
+
+        double average() const {
+            if (history.empty()) return 0.0;
+            double sum = 0.0;
+            for (size_t i = 0; i < history.size(); ++i) {
+                sum += history[i];
+            }
+            return sum / static_cast<double>(history.size());
+        }
+    };
+
+    struct FPSDataPoint {
+        double time;
+        float fps;
+    };
+
+    struct Summary {
+        size_t samples = 0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    // Snapshot of every scope timed during a frame that went over the spike threshold
+    struct FrameSpike {
+        struct ScopeSample {
+            uint32_t scope;
+            double ms;
+            uint32_t calls;
+        };
+
+        uint64_t frame = 0;
+        double time = 0.0;
+        double frameMs = 0.0;
+        std::vector<ScopeSample> scopes;
+    };
+
+    struct TraceEvent {
+        uint32_t scope;
+        uint32_t thread;
+        uint64_t startNs;
+        uint64_t endNs;
+    };
+
+    static Profiler& getInstance();
+
+    // Returns a dense scope index, scopes sharing a label share the same index
+    uint32_t registerScope(uint32_t id, const char* name);
+
+    static void beginScope(uint32_t scope);
+    static void endScope();
+
+    /*
+     * Counters, summed over the frame and folded into their history by endFrame().
+     * Same label, same counter. Added to from the main thread.
+     */
+    uint32_t registerCounter(const char* name);
+    void addCounter(uint32_t counter, uint64_t value) { m_counterFrame[counter] += value; m_counterTouched[counter] = true; }
+    uint32_t getCounterCount() const { return m_counterCount; }
+    const char* getCounterName(uint32_t counter) const { return m_counterNames[counter].c_str(); }
+    const CounterStats& getCounterStats(uint32_t counter) const { return m_counters[counter]; }
+
+    // Names the calling thread on the exported timeline
+    void setThreadName(const std::string& name);
+
+    // Drains every thread buffer and folds the events into per scope history
+    void endFrame();
+    // Records the frame time in seconds, flags the frame if it exceeds the spike threshold
+    void record(float deltaTime);
+
+    /*
+     * Percentile statistics over the last getStatsWindow() frames
+     */
+    void setStatsWindow(uint32_t frames);
+    uint32_t getStatsWindow() const { return m_statsWindow; }
+    void setSpikeThreshold(double ms) { m_spikeThresholdMs = ms; }
+    double getSpikeThreshold() const { return m_spikeThresholdMs; }
+
+    Summary getScopeSummary(uint32_t scope) const;
+    Summary getFrameSummary() const;
+    const RingBuffer<FrameSpike, PROFILER_MAX_SPIKES>& getSpikes() const { return m_spikes; }
+    uint64_t getSpikeCount() const { return m_spikeCount; }
+    uint64_t getFrameIndex() const { return m_frameIndex; }
+
+    // Regression dumps, one row per scope plus the whole frame
+    bool writeSummaryCSV(const std::string& path) const;
+    bool writeSummaryJSON(const std::string& path) const;
+
+    /*
+     * Trace export. The most recent PROFILER_TRACE_CAPACITY events are kept in
+     * memory and written as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+     */
+    bool exportChromeTrace(const std::string& path);
+    // Clears the trace buffer and exports it once the next frameCount frames have ended
+    void captureTrace(uint32_t frameCount, const std::string& path);
+    bool isCapturingTrace() const { return m_captureFramesLeft > 0; }
+
+    uint32_t getScopeCount() const { return m_scopeCount.load(std::memory_order_acquire); }
+    const char* getScopeName(uint32_t scope) const { return m_scopes[scope].name.c_str(); }
+    const ScopeStats& getScopeStats(uint32_t scope) const { return m_stats[scope]; }
+    const RingBuffer<FPSDataPoint, MAX_FPS_HISTORY>& getFPSHistory() const { return m_fpsHistory; }
+    uint32_t getDroppedEvents() const { return m_droppedEvents; }
+
+private:
+    Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    struct ScopeInfo {
+        uint32_t id = 0;
+        std::string name;
+    };
+
+    ThreadEventBuffer* acquireThreadBuffer();
+
+    static inline thread_local ThreadEventBuffer* t_threadBuffer = nullptr;
+
+    // Scope table, written under m_registerMutex and published through m_scopeCount
+    static constexpr uint32_t OVERFLOW_SCOPE = PROFILER_MAX_SCOPES - 1;
+    static constexpr const char* OVERFLOW_SCOPE_NAME = "(scope limit overflow)";
+    std::array<ScopeInfo, PROFILER_MAX_SCOPES> m_scopes;
+    std::atomic<uint32_t> m_scopeCount{0};
+    std::mutex m_registerMutex;
+
+    std::vector<std::unique_ptr<ThreadEventBuffer>> m_threadBuffers;
+    std::mutex m_threadMutex;
+
+    std::array<ScopeStats, PROFILER_MAX_SCOPES> m_stats;
+    std::array<uint64_t, PROFILER_MAX_SCOPES> m_frameNs{};
+    std::array<uint32_t, PROFILER_MAX_SCOPES> m_frameCalls{};
+    uint32_t m_droppedEvents = 0;
+
+    std::array<std::string, PROFILER_MAX_COUNTERS> m_counterNames;
+    std::array<CounterStats, PROFILER_MAX_COUNTERS> m_counters;
+    std::array<uint64_t, PROFILER_MAX_COUNTERS> m_counterFrame{};
+    std::array<bool, PROFILER_MAX_COUNTERS> m_counterTouched{};
+    uint32_t m_counterCount = 0;
+
+    // Trace ring, overwrites the oldest events once full
+    std::vector<TraceEvent> m_trace;
+    size_t m_traceHead = 0;
+    uint32_t m_captureFramesLeft = 0;
+    std::string m_capturePath;
+    uint64_t m_startNs = 0;
+
+    RingBuffer<FPSDataPoint, MAX_FPS_HISTORY> m_fpsHistory;
+    LatencyHistogram m_frameHistogram{PROFILER_STATS_WINDOW};
+    uint32_t m_statsWindow = PROFILER_STATS_WINDOW;
+    double m_spikeThresholdMs = 33.3;
+    RingBuffer<FrameSpike, PROFILER_MAX_SPIKES> m_spikes;
+    uint64_t m_spikeCount = 0;
+    uint64_t m_frameIndex = 0;
+    std::chrono::time_point<std::chrono::steady_clock> m_startTime;
+};
+
+inline void Profiler::beginScope(uint32_t scope) {
+    ThreadEventBuffer* buffer = t_threadBuffer;
+    if (!buffer) {
+        buffer = getInstance().acquireThreadBuffer();
+    }
+
+    if (buffer->depth < PROFILER_MAX_SCOPE_DEPTH) {
+        buffer->stack[buffer->depth] = { scope, Profiling::nowNanoseconds() };
+    }
+    ++buffer->depth;
+}
+
+inline void Profiler::endScope() {
+    ThreadEventBuffer* buffer = t_threadBuffer;
+    if (!buffer || buffer->depth == 0) {
+        return;
+    }
+
+    uint32_t depth = --buffer->depth;
+    if (depth >= PROFILER_MAX_SCOPE_DEPTH) {
+        return;
+    }
+
+    const ThreadEventBuffer::OpenScope& open = buffer->stack[depth];
+    buffer->push({ open.scope, depth, open.startNs, Profiling::nowNanoseconds() });
+}
+
+class ProfileScope {
+public:
+    explicit ProfileScope(uint32_t scope) { Profiler::beginScope(scope); }
+    ~ProfileScope() { Profiler::endScope(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Registers the label once per call site, after that a scope costs two clock reads
+#define PROFILE_SCOPE(name)                                                                  \
+    static const uint32_t PROFILE_CONCAT(_profileScope, __LINE__) =                          \
+        Profiler::getInstance().registerScope(                                               \
+            std::integral_constant<uint32_t, Profiling::hashLabel(name)>::value, name);      \
+    ProfileScope PROFILE_CONCAT(_profileGuard, __LINE__)(PROFILE_CONCAT(_profileScope, __LINE__))
+
+// Adds value to this frame's total of the counter
+#define PROFILE_COUNTER(name, value)                                                           \
+    do {                                                                                       \
+        static const uint32_t _profileCounter = Profiler::getInstance().registerCounter(name); \
+        Profiler::getInstance().addCounter(_profileCounter, value);                            \
+    } while (0)
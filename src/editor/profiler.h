@@ -1,56 +1,17 @@
-#include <chrono>
+#pragma once
+
 #include <string>
-#include <unordered_map>
 #include <vector>
-#include <stdexcept>
-#include <numeric>
 #include <algorithm>
+#include <limits>
 
 #include "imgui/imgui.h"
 #include "implot/implot.h"
 
-#define MAX_FPS_HISTORY 10000
+#include "debugging/profiler.h"
 
-class Profiler {
+class ProfilerPanel {
 public:
-    Profiler() {
-        m_startTime = std::chrono::high_resolution_clock::now();
-    }
-
-    void start(const std::string& label) {
-        auto now = std::chrono::high_resolution_clock::now();
-        m_times[label].start = now;
-        m_times[label].active = true;
-    }
-
-    void end(const std::string& label) {
-        auto now = std::chrono::high_resolution_clock::now();
-        auto it = m_times.find(label);
-        if (it == m_times.end() || !it->second.active) {
-            throw std::runtime_error("[Error] Profiler end called without matching start for label: " + label);
-        }
-        it->second.duration = std::chrono::duration_cast<std::chrono::microseconds>(now - it->second.start).count();
-        it->second.active = false;
-
-        // Update history for this label
-        it->second.history.push_back(static_cast<double>(it->second.duration) / 1000.0); // Convert to ms
-        if (it->second.history.size() > 60) { // Keep last 60 samples
-            it->second.history.erase(it->second.history.begin());
-        }
-    }
-
-    void record(float fps) {
-        // Record the current time in seconds since start
-        auto now = std::chrono::high_resolution_clock::now();
-        double time = std::chrono::duration<double>(now - m_startTime).count();
-        m_fpsHistory.push_back({time, fps});
-
-        // Remove old data to keep the history within MAX_FPS_HISTORY size
-        if (m_fpsHistory.size() > MAX_FPS_HISTORY) {
-            m_fpsHistory.erase(m_fpsHistory.begin());
-        }
-    }
-
     void display() {
         // Position the window in the top-left corner
         ImGui::SetNextWindowPos(ImVec2(20, 20), ImGuiCond_Always);
@@ -66,9 +27,12 @@ public:
         ImGui::PopStyleColor();
         ImGui::Separator();
 
+        Profiler& profiler = Profiler::getInstance();
+        const auto& fpsHistory = profiler.getFPSHistory();
+
         // FPS Display with color coding
-        if (!m_fpsHistory.empty()) {
-            float currentFPS = m_fpsHistory.back().fps;
+        if (!fpsHistory.empty()) {
+            float currentFPS = fpsHistory.back().fps;
             ImVec4 fpsColor = getFPSColor(currentFPS);
 
             ImGui::PushStyleColor(ImGuiCol_Text, fpsColor);
@@ -79,46 +43,59 @@ public:
             ImGui::SameLine();
             const char* fpsStatus = getFPSStatus(currentFPS);
             ImGui::TextColored(fpsColor, "(%s)", fpsStatus);
+
+            Profiler::Summary frame = profiler.getFrameSummary();
+            ImGui::Text("Frame p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms",
+                        frame.p50Ms, frame.p95Ms, frame.p99Ms, frame.maxMs);
         }
 
         ImGui::Spacing();
 
         // Timing section
-        if (!m_times.empty()) {
+        uint32_t scopeCount = profiler.getScopeCount();
+        if (scopeCount > 0) {
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.8f, 0.8f, 0.2f, 1.0f));
             ImGui::Text("TIMING DATA");
             ImGui::PopStyleColor();
             ImGui::Separator();
 
             // Table for better organization
-            if (ImGui::BeginTable("ProfilerTable", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
-                ImGui::TableSetupColumn("Label", ImGuiTableColumnFlags_WidthFixed, 120.0f);
+            if (ImGui::BeginTable("ProfilerTable", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                ImGui::TableSetupColumn("Label", ImGuiTableColumnFlags_WidthFixed, 160.0f);
                 ImGui::TableSetupColumn("Current", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+                ImGui::TableSetupColumn("p50/p95/p99/max", ImGuiTableColumnFlags_WidthFixed, 190.0f);
                 ImGui::TableSetupColumn("Avg/Graph", ImGuiTableColumnFlags_WidthStretch);
                 ImGui::TableHeadersRow();
 
-                for (const auto& [label, record] : m_times) {
+                for (uint32_t scope = 0; scope < scopeCount; ++scope) {
+                    const Profiler::ScopeStats& record = profiler.getScopeStats(scope);
+                    if (!record.seen) {
+                        continue;
+                    }
                     ImGui::TableNextRow();
 
-                    // Label column
+                    // Label column, scopes hit several times a frame show their call count
                     ImGui::TableNextColumn();
-                    ImGui::Text("%s", label.c_str());
+                    if (record.lastCalls > 1) {
+                        ImGui::Text("%s (x%u)", profiler.getScopeName(scope), record.lastCalls);
+                    } else {
+                        ImGui::Text("%s", profiler.getScopeName(scope));
+                    }
 
                     // Current time column
                     ImGui::TableNextColumn();
-                    if (record.active) {
-                        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Running...");
-                    } else {
-                        double currentMs = static_cast<double>(record.duration) / 1000.0;
-                        ImVec4 timeColor = getTimeColor(currentMs);
-                        ImGui::TextColored(timeColor, "%.2f ms", currentMs);
-                    }
+                    ImVec4 timeColor = getTimeColor(record.lastMs);
+                    ImGui::TextColored(timeColor, "%.2f ms", record.lastMs);
+
+                    // Percentiles over the stats window
+                    ImGui::TableNextColumn();
+                    Profiler::Summary summary = profiler.getScopeSummary(scope);
+                    ImGui::Text("%.2f / %.2f / %.2f / %.2f", summary.p50Ms, summary.p95Ms, summary.p99Ms, summary.maxMs);
 
                     // Average and mini-graph column
                     ImGui::TableNextColumn();
                     if (!record.history.empty()) {
-                        double avgTime = std::accumulate(record.history.begin(), record.history.end(), 0.0) / record.history.size();
-                        ImGui::Text("Avg: %.2f ms", avgTime);
+                        ImGui::Text("Avg: %.2f ms", record.averageMs());
 
                         // Mini sparkline graph
                         if (record.history.size() > 1) {
@@ -129,6 +106,68 @@ public:
                 }
                 ImGui::EndTable();
             }
+
+            if (profiler.getDroppedEvents() > 0) {
+                ImGui::TextColored(ImVec4(0.8f, 0.2f, 0.2f, 1.0f), "Dropped events: %u", profiler.getDroppedEvents());
+            }
+        }
+
+        // Counter section, per frame totals such as triangles drawn
+        uint32_t counterCount = profiler.getCounterCount();
+        if (counterCount > 0) {
+            ImGui::Spacing();
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.8f, 0.8f, 0.2f, 1.0f));
+            ImGui::Text("COUNTERS");
+            ImGui::PopStyleColor();
+            ImGui::Separator();
+
+            if (ImGui::BeginTable("CounterTable", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                ImGui::TableSetupColumn("Label", ImGuiTableColumnFlags_WidthFixed, 160.0f);
+                ImGui::TableSetupColumn("Current", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+                ImGui::TableSetupColumn("Avg/Graph", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableHeadersRow();
+
+                for (uint32_t counter = 0; counter < counterCount; ++counter) {
+                    const Profiler::CounterStats& record = profiler.getCounterStats(counter);
+                    if (!record.seen) {
+                        continue;
+                    }
+                    ImGui::TableNextRow();
+
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", profiler.getCounterName(counter));
+
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(record.lastValue));
+
+                    ImGui::TableNextColumn();
+                    ImGui::Text("Avg: %.0f", record.average());
+                    if (record.history.size() > 1) {
+                        ImGui::SameLine();
+                        drawMiniGraph(record.history, ImVec2(60, 20));
+                    }
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        // Spike section, newest flagged frame first
+        const auto& spikes = profiler.getSpikes();
+        if (!spikes.empty() &&
+            ImGui::CollapsingHeader("Spikes")) {
+            ImGui::Text("%llu frames over %.1f ms", static_cast<unsigned long long>(profiler.getSpikeCount()),
+                        profiler.getSpikeThreshold());
+            for (size_t i = spikes.size(); i-- > 0;) {
+                const Profiler::FrameSpike& spike = spikes[i];
+                ImGui::PushID(static_cast<int>(i));
+                if (ImGui::TreeNode("spike", "Frame %llu: %.2f ms", static_cast<unsigned long long>(spike.frame), spike.frameMs)) {
+                    for (const auto& sample : spike.scopes) {
+                        ImGui::TextColored(getTimeColor(sample.ms), "%s: %.2f ms", profiler.getScopeName(sample.scope), sample.ms);
+                    }
+                    ImGui::TreePop();
+                }
+                ImGui::PopID();
+            }
         }
 
         ImGui::Spacing();
@@ -147,22 +186,6 @@ public:
     }
 
 private:
-    struct TimeRecord {
-        std::chrono::time_point<std::chrono::high_resolution_clock> start;
-        long long duration = 0;
-        bool active = false;
-        std::vector<double> history; // History of timing measurements
-    };
-
-    std::unordered_map<std::string, TimeRecord> m_times;
-
-    struct FPSDataPoint {
-        double time;
-        float fps;
-    };
-
-    std::vector<FPSDataPoint> m_fpsHistory;
-    std::chrono::time_point<std::chrono::high_resolution_clock> m_startTime;
     bool m_showFPSGraph = false;
 
     ImVec4 getFPSColor(float fps) {
@@ -185,7 +208,8 @@ private:
         else return ImVec4(0.8f, 0.2f, 0.2f, 1.0f);                    // Red - very slow
     }
 
-    void drawMiniGraph(const std::vector<double>& data, ImVec2 size) {
+    template <typename History>
+    void drawMiniGraph(const History& data, ImVec2 size) {
         ImDrawList* drawList = ImGui::GetWindowDrawList();
         ImVec2 canvasPos = ImGui::GetCursorScreenPos();
         ImVec2 canvasSize = size;
@@ -201,9 +225,12 @@ private:
         }
 
         // Find min/max for scaling
-        auto [minIt, maxIt] = std::minmax_element(data.begin(), data.end());
-        double minVal = *minIt;
-        double maxVal = *maxIt;
+        double minVal = data[0];
+        double maxVal = data[0];
+        for (size_t i = 1; i < data.size(); ++i) {
+            minVal = std::min(minVal, data[i]);
+            maxVal = std::max(maxVal, data[i]);
+        }
         double range = maxVal - minVal;
 
         if (range < 0.001) range = 0.001; // Avoid division by zero
@@ -228,30 +255,26 @@ private:
 
         ImGui::Begin("FPS Graph", &m_showFPSGraph, ImGuiWindowFlags_NoMove);
 
-        if (m_fpsHistory.empty()) {
+        const auto& fpsHistory = Profiler::getInstance().getFPSHistory();
+        if (fpsHistory.empty()) {
             ImGui::Text("No FPS data available");
             ImGui::End();
             return;
         }
 
-        size_t totalFrames = m_fpsHistory.size();
+        size_t totalFrames = fpsHistory.size();
 
         if (ImPlot::BeginPlot("FPS Over Time", ImVec2(-1, 250))) {
             // Get current time
-            double currentTime = m_fpsHistory.back().time;
+            double currentTime = fpsHistory.back().time;
             // Define time window (e.g., 10 seconds)
             const double timeWindow = 10.0; // seconds
 
-            // Find the starting index where time >= currentTime - timeWindow
-            auto it = std::lower_bound(
-                m_fpsHistory.begin(), m_fpsHistory.end(), currentTime - timeWindow,
-                [](const FPSDataPoint& dataPoint, double time) {
-                    return dataPoint.time < time;
-                }
-            );
-
-            // Get the index
-            size_t startIndex = std::distance(m_fpsHistory.begin(), it);
+            // Walk back from the newest sample until we leave the time window
+            size_t startIndex = totalFrames;
+            while (startIndex > 0 && fpsHistory[startIndex - 1].time >= currentTime - timeWindow) {
+                --startIndex;
+            }
 
             // Prepare data arrays
             size_t dataSize = totalFrames - startIndex;
@@ -263,8 +286,8 @@ private:
             double maxFPS = std::numeric_limits<double>::lowest();
 
             for (size_t i = startIndex; i < totalFrames; ++i) {
-                times[i - startIndex] = m_fpsHistory[i].time;
-                fpsValues[i - startIndex] = m_fpsHistory[i].fps;
+                times[i - startIndex] = fpsHistory[i].time;
+                fpsValues[i - startIndex] = fpsHistory[i].fps;
 
                 // Update min and max FPS for y-axis limits
                 minFPS = std::min(minFPS, fpsValues[i - startIndex]);
@@ -315,20 +338,20 @@ private:
 
         // Statistics section
         ImGui::Separator();
-        if (!m_fpsHistory.empty()) {
-            float currentFPS = m_fpsHistory.back().fps;
+        {
+            float currentFPS = fpsHistory.back().fps;
 
             // Calculate statistics from recent data
-            size_t recentSamples = std::min(size_t(300), m_fpsHistory.size()); // Last 5 seconds at 60fps
-            auto recentStart = m_fpsHistory.end() - static_cast<ptrdiff_t>(recentSamples);
-
-            float minRecentFPS = std::min_element(recentStart, m_fpsHistory.end(),
-                [](const FPSDataPoint& a, const FPSDataPoint& b) { return a.fps < b.fps; })->fps;
-            float maxRecentFPS = std::max_element(recentStart, m_fpsHistory.end(),
-                [](const FPSDataPoint& a, const FPSDataPoint& b) { return a.fps < b.fps; })->fps;
-
-            float avgRecentFPS = std::accumulate(recentStart, m_fpsHistory.end(), 0.0f,
-                [](float sum, const FPSDataPoint& p) { return sum + p.fps; }) / static_cast<float>(recentSamples);
+            size_t recentSamples = std::min(size_t(300), totalFrames); // Last 5 seconds at 60fps
+            float minRecentFPS = std::numeric_limits<float>::max();
+            float maxRecentFPS = 0.0f;
+            float sumRecentFPS = 0.0f;
+            for (size_t i = totalFrames - recentSamples; i < totalFrames; ++i) {
+                minRecentFPS = std::min(minRecentFPS, fpsHistory[i].fps);
+                maxRecentFPS = std::max(maxRecentFPS, fpsHistory[i].fps);
+                sumRecentFPS += fpsHistory[i].fps;
+            }
+            float avgRecentFPS = sumRecentFPS / static_cast<float>(recentSamples);
 
             ImGui::Text("Recent Stats (last %.1fs):", static_cast<float>(recentSamples) / 60.0f);
             ImGui::Text("  Current: %.1f FPS", currentFPS);
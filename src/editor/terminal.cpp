@@ -1,5 +1,9 @@
 #include "terminal.h"
+#include "../debugging/profiler.h"
+
 #include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <regex>
 
 #ifdef _WIN32
@@ -179,6 +183,51 @@ void Terminal::handleCommand(const std::string& command) {
         addMessage("Available commands:", MessageType::INFO);
         addMessage("  clear - Clear the terminal", MessageType::INFO);
         addMessage("  help - Show this help message", MessageType::INFO);
+        addMessage("  trace [file] - Export buffered profiler events as Chrome trace JSON", MessageType::INFO);
+        addMessage("  trace <frames> [file] - Capture the next N frames, then export", MessageType::INFO);
+        addMessage("  stats [file.csv|file.json] - Dump profiler percentile summary", MessageType::INFO);
+    }
+    else if (command == "stats" || command.rfind("stats ", 0) == 0) {
+        std::istringstream args(command.substr(5));
+        std::string path = "profile_stats.json";
+        args >> path;
+
+        Profiler& profiler = Profiler::getInstance();
+        bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        bool written = csv ? profiler.writeSummaryCSV(path) : profiler.writeSummaryJSON(path);
+        if (written) {
+            addMessage("Wrote profiler summary to " + path, MessageType::INFO);
+        } else {
+            addMessage("Failed to write profiler summary to " + path, MessageType::ERR);
+        }
+    }
+    else if (command == "trace" || command.rfind("trace ", 0) == 0) {
+        std::istringstream args(command.substr(5));
+        std::string first;
+        std::string path = "profile_trace.json";
+        args >> first;
+
+        Profiler& profiler = Profiler::getInstance();
+        if (!first.empty() && first.find_first_not_of("0123456789") == std::string::npos) {
+            uint32_t frames = 0;
+            auto [end, error] = std::from_chars(first.data(), first.data() + first.size(), frames);
+            if (error != std::errc() || end != first.data() + first.size()) {
+                addMessage("Usage: trace <frames> [file], frames must be at most " + std::to_string(UINT32_MAX),
+                           MessageType::ERR);
+                return;
+            }
+            args >> path;
+            profiler.captureTrace(frames, path);
+        } else {
+            if (!first.empty()) {
+                path = first;
+            }
+            if (profiler.exportChromeTrace(path)) {
+                addMessage("Wrote trace to " + path, MessageType::INFO);
+            } else {
+                addMessage("Failed to write trace to " + path, MessageType::ERR);
+            }
+        }
     }
     else {
         // Execute command - for demonstration just echo it back
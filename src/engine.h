@@ -22,10 +22,11 @@
 // Resource serializers / creators
 #include "resources/meshgen.h"
 #include "resources/resourceLoader.h"
+#include "resources/assetStreamer.h"
 
 // Renderer
 #include "renderer/shader.h"
-#include "renderer/computeShader.h"
+#include "renderer/computeshader.h"
 #include "renderer/renderer.h"
 #include "renderer/materialManager.h"
 
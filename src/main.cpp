@@ -11,9 +11,13 @@
 #include "renderer/framegraph/framegraph.h"
 #include "renderer/framegraph/debugpass.h"
 
+#ifdef FACTORY_HEADLESS
+#include "system/headlessRunner.h"
+#else
 #include "editor/editor.h"
 #include "editor/profiler.h"
 #include "editor/pcinfo.h"
+#endif
 
 // Define globals
 InputManager inputManager;
@@ -21,10 +25,26 @@ DebugContext DEBUG_CTX;
 
 config::GraphicsSettings settings;
 
-int main() {
+int main(int argc, char** argv) {
     DEBUG_CTX.mode = -1;
     DEBUG_CTX.numDepthSlices = 50;
 
+#ifdef FACTORY_HEADLESS
+    // Simulation only: no window, GL context or renderer
+    HeadlessOptions options;
+    options.parse(argc, argv);
+
+    Scene scene;
+    scene.loadScene();
+    HeadlessRunner::stubMeshUploads(scene);
+
+    HeadlessRunner runner(settings);
+    runner.run(scene, options);
+
+    scene.registry.clear();
+    return 0;
+#else
+
     // Initialize window
     Window window("Factory Engine", settings.display.width, settings.display.height);
     if (!window.init()) {
@@ -32,7 +52,9 @@ int main() {
     }
     inputManager.init(window.getGLFWwindow());
     // Init editor specific UI
-    Profiler profiler;
+    Profiler& profiler = Profiler::getInstance();
+    profiler.setThreadName("Main");
+    ProfilerPanel profilerPanel;
     // Editor editor(settings.display.width, settings.display.height);
     std::cout << "[Info] Success. Running engine setup...\n";
 
@@ -66,37 +88,22 @@ int main() {
     // Post processing passes. Debug pass is like a post process.
     frameGraph.addRenderPass(std::make_unique<DebugPass>());
 
+    {
+        // Shaders compile in the background while assets stream in, this scope shows in the first profiled frame
+        PROFILE_SCOPE("SetupPasses");
+        frameGraph.setupPasses();
+    }
+
     // ----------------------- Renderer Setup -----------------------
     MaterialManager& matManager = MaterialManager::getInstance();
     matManager.initialize(TEXTURE_POOL_SIZE);
+    matManager.setResidencyBudget(static_cast<size_t>(settings.quality.textureBudgetMB) * 1024 * 1024);
 
-    // Init all meshes
-    for (auto& meshDef : scene.meshEntityPairs) {
-        uint32_t materialIndex = matManager.getMaterialIndex(*meshDef.materialDef);
-
-        Mesh mesh = renderer.initMeshBuffers(meshDef.rawMeshData);
-        mesh.materialIndex = materialIndex;
-        scene.registry.emplace<Mesh>(meshDef.entity, mesh);
-    }
-
-    // Instanced mesh groups
-    for (auto& instanceGroup : scene.instancedMeshGroups) {
-        // Get or create material data for instance group
-        uint32_t materialIndex = matManager.getMaterialIndex(*instanceGroup.materialDef);
-        Mesh instancedMesh = renderer.initMeshBuffers(instanceGroup.meshData);
-
-        instancedMesh.materialIndex = materialIndex;
-        instanceGroup.initializedMesh = &instancedMesh;
-
-        // Add the same Mesh component (with material index) to all entities in the group
-        for (entt::entity entity : instanceGroup.entities) {
-            scene.registry.emplace<Mesh>(entity, instancedMesh);
-        }
-    }
-    matManager.updateMaterialBuffer();
+    // Meshes and textures stream in over the first frames, entities draw nothing until theirs arrive
+    AssetStreamer assetStreamer(renderer, scene.registry);
+    assetStreamer.streamScene(scene);
 
     // -------------------- Start Game -------------------
-    frameGraph.setupPasses();
     GameObjectSystem gameObjectSystem(scene.registry);
     TransformSystem transformSystem(scene.registry);
     LightSystem lightSystem(settings, scene.registry);
@@ -113,36 +120,47 @@ int main() {
         float currentFrame = (float)glfwGetTime();
         deltaTime = currentFrame - lastFrame;
 
-        // -------------- Input Management -----------
-        profiler.start("Frame");
-        inputManager.update();
-
-        // TEMPORARY: Exit on ESC key
-        if (inputManager.isKeyPressed(GLFW_KEY_ESCAPE)) {
-            glfwSetWindowShouldClose(window.getGLFWwindow(), true);
+        {
+            PROFILE_SCOPE("Frame");
+
+            // -------------- Input Management -----------
+            inputManager.update();
+
+            // TEMPORARY: Exit on ESC key
+            if (inputManager.isKeyPressed(GLFW_KEY_ESCAPE)) {
+                glfwSetWindowShouldClose(window.getGLFWwindow(), true);
+            }
+
+            // -------------- System updates ------------
+            {
+                PROFILE_SCOPE("Systems");
+                gameObjectSystem.updateAll(currentFrame, deltaTime);
+                {
+                    PROFILE_SCOPE("Transform");
+                    transformSystem.updateTransformComponents();
+                }
+                {
+                    PROFILE_SCOPE("Shadow");
+                    lightSystem.updateShadowMatrices(scene.getPrimaryCamera());
+                }
+            }
+
+            // ------------------------ Streaming ------------------------
+            assetStreamer.update();
+
+            // ------------------------ Rendering ------------------------
+            // Starts once every pass finished compiling its shaders
+            if (frameGraph.arePassesReady()) {
+                PROFILE_SCOPE("Rendering");
+                frameGraph.executePasses(scene.registry, scene.getPrimaryCamera(), renderer);
+            }
         }
-
-        // -------------- System updates ------------
-        profiler.start("Systems");
-        gameObjectSystem.updateAll(currentFrame, deltaTime);
-        profiler.start("Transform");
-        transformSystem.updateTransformComponents();
-        profiler.end("Transform");
-        profiler.start("Shadow");
-        lightSystem.updateShadowMatrices(scene.getPrimaryCamera());
-        profiler.end("Shadow");
-        profiler.end("Systems");
-
-        // ------------------------ Rendering ------------------------
-        profiler.start("Rendering");
-        frameGraph.executePasses(scene.registry, scene.getPrimaryCamera(), renderer);
-        profiler.end("Rendering");
-        profiler.end("Frame");
+        profiler.endFrame();
 
         // // ------------------ ImGui Rendering ------------------
         window.beginImGuiFrame();
-        profiler.record(1.0f / deltaTime);
-        profiler.display();
+        profiler.record(deltaTime);
+        profilerPanel.display();
         // editor.drawEditorLayout(scene, renderer);
         window.endImGuiFrame();
 
@@ -153,4 +171,5 @@ int main() {
 
     scene.registry.clear();
     return 0;
+#endif
 }
@@ -1,6 +1,7 @@
-#include "computeShader.h"
-#include "../resources/resourceLoader.h"
+#include "computeshader.h"
+#include "shaderPreprocessor.h"
 
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <sstream>
 
@@ -64,6 +65,15 @@ void ComputeShader::setInt(const std::string& name, int value) const {
     }
 }
 
+void ComputeShader::setUInt(const std::string& name, unsigned int value) const {
+    GLint location = getUniformLocation(name);
+    if (location != -1) {
+        glUniform1ui(location, value);
+    } else {
+        std::cerr << "[Error] ComputeShader::setUInt: Uniform not found: " << name << "\n";
+    }
+}
+
 void ComputeShader::setFloat(const std::string& name, float value) const {
     GLint location = getUniformLocation(name);
     if (location != -1) {
@@ -100,6 +110,15 @@ void ComputeShader::setVec4(const std::string& name, const glm::vec4& value) con
     }
 }
 
+void ComputeShader::setMat4(const std::string& name, const glm::mat4& mat) const {
+    GLint location = getUniformLocation(name);
+    if (location != -1) {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+    } else {
+        std::cerr << "[Error] ComputeShader::setMat4: Uniform not found: " << name << "\n";
+    }
+}
+
 /*
 * Shader creation
 */
@@ -107,9 +126,9 @@ bool ComputeShader::load(const std::string& computePath) {
     m_ID = 0;
     m_UniformLocationCache.clear();
 
-    // Load shader from file
-    std::string computeCode = ResourceLoader::readFile(computePath);
-    if (computeCode.empty()) {
+    // Load shader from file, with its includes
+    std::string computeCode;
+    if (!ShaderPreprocessor::process(computePath, computeCode) || computeCode.empty()) {
         std::cerr << "[Error] ComputeShader::load: Failed to read compute shader file: " << computePath << "\n";
         return false;
     }
@@ -13,6 +13,7 @@ public:
 
     bool load(const std::string& computePath);
     void use() const;
+    bool isValid() const { return m_ID != 0; }
 
     /*
     * Set uniform data
@@ -20,10 +21,12 @@ public:
     bool hasUniform(const std::string& name) const;
     void setBool(const std::string& name, bool value) const;
     void setInt(const std::string& name, int value) const;
+    void setUInt(const std::string& name, unsigned int value) const;
     void setFloat(const std::string& name, float value) const;
     void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
     void setVec4(const std::string& name, const glm::vec4& value) const;
+    void setMat4(const std::string& name, const glm::mat4& mat) const;
 
     void dispatchCompute(unsigned int x, unsigned int y, unsigned int z) const;
 
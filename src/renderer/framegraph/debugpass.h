@@ -11,10 +11,12 @@ public:
     void setup() override {
         std::string debugVertexPath = SHADER_DIR + "deferred/debug_gbuff.vs";
         std::string debugFragmentPath = SHADER_DIR + "deferred/debug_gbuff.fs";
-        m_debugShader.load(debugVertexPath, debugFragmentPath);
-        m_debugShader.use();
+        m_debugShader.loadAsync(debugVertexPath, debugFragmentPath);
     };
 
+    bool isReady() override { return m_debugShader.poll(); }
+
+    const char* getName() const override { return "DebugPass"; }
     void execute(entt::registry& registry, Camera& camera, Renderer& renderer) override {
         if (DEBUG_CTX.mode < 0) {
             return;
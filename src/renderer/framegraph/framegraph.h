@@ -2,11 +2,14 @@
 #define FRAMEGRAPH_H
 
 #include <memory>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 #include <glm/glm.hpp>
 #include "renderpass.h"
 #include "entt/entt.hpp"
+#include "debugging/profiler.h"
+#include "debugging/glStats.h"
 
 // Forward declaration
 struct Mesh;
@@ -18,26 +21,67 @@ public:
 
     // Add a render pass to the frame graph
     void addRenderPass(std::unique_ptr<RenderPass> pass) {
+        const char* name = pass->getName();
+        m_passScopes.push_back(Profiler::getInstance().registerScope(Profiling::hashLabel(name), name));
         m_renderPasses.push_back(std::move(pass));
+        m_passCounters.emplace_back();
     }
 
-    // Set up all render passes in the frame graph
+    // Set up all render passes in the frame graph, their shaders keep compiling in the background
     void setupPasses() {
         for (auto& pass : m_renderPasses) {
             pass->setup();
         }
+        m_passesReady = false;
+    }
+
+    // Polls the passes still loading, true once every pass can execute. Doesn't block.
+    bool arePassesReady() {
+        if (!m_passesReady) {
+            m_passesReady = true;
+            for (auto& pass : m_renderPasses) {
+                m_passesReady &= pass->isReady();
+            }
+        }
+        return m_passesReady;
+    }
+
+    void waitForPasses() {
+        while (!arePassesReady()) {
+            std::this_thread::yield();
+        }
     }
 
     // Execute all render passes, passing in the renderer and registry
     void executePasses(entt::registry& registry, Camera& camera, Renderer& renderer) {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        for (auto& pass : m_renderPasses) {
-            pass->execute(registry, camera, renderer);
+        bool countCalls = GLStats::isInstalled();
+        for (size_t i = 0; i < m_renderPasses.size(); ++i) {
+            GLStats::Counters before = countCalls ? GLStats::get() : GLStats::Counters();
+            {
+                ProfileScope scope(m_passScopes[i]);
+                m_renderPasses[i]->execute(registry, camera, renderer);
+            }
+            if (countCalls) {
+                m_passCounters[i] = GLStats::get() - before;
+            }
         }
     }
 
+    /*
+     * Per pass introspection for benchmarks
+     */
+    size_t getPassCount() const { return m_renderPasses.size(); }
+    const char* getPassName(size_t index) const { return m_renderPasses[index]->getName(); }
+    uint32_t getPassScope(size_t index) const { return m_passScopes[index]; }
+    // GL calls made by the pass during the last executePasses(), zero unless GLStats is installed
+    const GLStats::Counters& getPassCounters(size_t index) const { return m_passCounters[index]; }
+
 private:
     std::vector<std::unique_ptr<RenderPass>> m_renderPasses;
+    std::vector<uint32_t> m_passScopes;
+    std::vector<GLStats::Counters> m_passCounters;
+    bool m_passesReady = false;
 };
 
 #endif // FRAMEGRAPH_H
@@ -2,6 +2,10 @@
 #define GEOMETRYPASS_H
 
 #include "renderpass.h"
+#include "../shaderVariants.h"
+#include "../lodSelector.h"
+#include "../impostorAtlas.h"
+#include "debugging/profiler.h"
 
 class GeometryPass : public RenderPass {
 public:
@@ -11,11 +15,21 @@ public:
     void setup() override {
         std::string gBufferVertexPath = ASSET_DIR "shaders/core/deferred/gbuff.vs";
         std::string gBufferFragmentPath = ASSET_DIR "shaders/core/deferred/gbuff.fs";
-        if (!m_gBufferShader.load(gBufferVertexPath, gBufferFragmentPath)) {
-            std::cerr << "[Error] Renderer::Renderer: Failed to create gBufferShader!\n";
-        }
+        m_gBufferShaders.loadAsync(gBufferVertexPath, gBufferFragmentPath, "MATERIAL_PERMUTATION_FLAGS");
+        m_impostorShader.loadAsync(ASSET_DIR "shaders/core/deferred/impostor.vs", ASSET_DIR "shaders/core/deferred/impostor.fs");
+        m_geometryBatch.setImpostors(true);
+    }
+
+    bool isReady() override {
+        bool gBufferReady = m_gBufferShaders.poll();
+        bool impostorReady = m_impostorShader.poll();
+        return gBufferReady && impostorReady;
     }
 
+    // G-buffer programs specialised by material texture flags
+    ShaderVariants& getShaderVariants() { return m_gBufferShaders; }
+
+    const char* getName() const override { return "GeometryPass"; }
     void execute(entt::registry& registry, Camera& camera, Renderer& renderer) override {
         // Get resources
         Framebuffer* gbuffer = renderer.getFramebuffer();
@@ -24,28 +38,126 @@ public:
         gbuffer->bind();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Use Geometry Pass Shader
-        m_gBufferShader.use();
-        m_gBufferShader.setVec3("u_ViewPos", camera.getPosition());
-        m_gBufferShader.setMat4("u_View", camera.getViewMatrix());
-        m_gBufferShader.setMat4("u_Projection", camera.getProjectionMatrix());
-
         // Clear and build draw commands for indirect rendering
         m_geometryBatch.clear();
 
-        // Batch draw
+        // Batch draw, the materials drawn decide which textures stay resident.
+        // Residency never takes a texture from a material drawn this frame, so the flags can only gain bits
+        // until the draw and the variants stay valid.
+        MaterialManager& matManager = MaterialManager::getInstance();
+        const config::GraphicsSettings::QualitySettings& quality = renderer.config.quality;
+        glm::vec3 viewPosition = camera.getPosition();
+        float projectionScale = camera.getProjectionMatrix()[1][1];
         const auto& view = registry.view<Mesh, ModelMatrix>();
         for (const auto& entity : view) {
             const Mesh& mesh = view.get<Mesh>(entity);
             const ModelMatrix& modelMatrix = view.get<ModelMatrix>(entity);
 
-            m_geometryBatch.addInstance(RenderInstance(mesh, modelMatrix.matrix));
+            RenderInstance instance(mesh, modelMatrix.matrix);
+            instance.permutation = matManager.getTextureFlags(mesh.materialIndex);
+
+            // Detail level by projected size, stored for the other passes to draw the same one
+            if (LOD* lod = registry.try_get<LOD>(entity)) {
+                if (quality.meshLods) {
+                    float size = LodSelector::projectedSize(renderer.getMeshBoundingSphere(mesh.id), modelMatrix.matrix,
+                                                            viewPosition, projectionScale) * lod->bias;
+                    lod->level = LodSelector::select(size, lod->level, renderer.getMeshLodCount(mesh.id),
+                                                     quality.lodScreenSize, quality.lodHysteresis);
+                } else {
+                    lod->level = 0;
+                }
+                instance.lod = lod->level;
+            }
+            m_geometryBatch.addInstance(instance);
+            matManager.markMaterialUsed(mesh.materialIndex);
+        }
+
+        // Instanced meshes go in whole, their members only need a level. Far members are drawn as the
+        // mesh's impostor once it is baked, groups of meshes without a current one queue a bake.
+        const InstancedMesh* bakeGroup = nullptr;
+        for (auto [entity, group] : registry.view<InstancedMesh>().each()) {
+            uint32_t textureFlags = matManager.getTextureFlags(group.mesh.materialIndex);
+            bool impostors = quality.impostors && m_impostorShader.isValid() && ImpostorAtlas::isCandidate(group.mesh, renderer);
+            if (impostors && !bakeGroup && m_impostors.needsBake(group.mesh, textureFlags)) {
+                bakeGroup = &group;
+            }
+            impostors = impostors && m_impostors.hasImpostor(group.mesh.id);
+
+            uint32_t lodCount = renderer.getMeshLodCount(group.mesh.id);
+            bool meshDrawn = !impostors;
+            if ((quality.meshLods && lodCount > 1) || impostors) {
+                glm::vec4 sphere = renderer.getMeshBoundingSphere(group.mesh.id);
+                for (size_t i = 0; i < group.matrices.size(); ++i) {
+                    float size = LodSelector::projectedSize(sphere, group.matrices[i], viewPosition, projectionScale) * group.lodBias;
+                    bool impostor = group.lodLevels[i] == MESH_IMPOSTOR_LEVEL;
+                    if (impostors && LodSelector::selectImpostor(size, impostor, quality.impostorScreenSize, quality.lodHysteresis)) {
+                        group.lodLevels[i] = MESH_IMPOSTOR_LEVEL;
+                        continue;
+                    }
+                    meshDrawn = true;
+                    group.lodLevels[i] = quality.meshLods
+                        ? static_cast<uint8_t>(LodSelector::select(size, group.lodLevels[i], lodCount, quality.lodScreenSize,
+                                                                   quality.lodHysteresis))
+                        : 0;
+                }
+            } else {
+                std::fill(group.lodLevels.begin(), group.lodLevels.end(), 0);
+            }
+            m_geometryBatch.addInstanceRange(group.mesh, group.matrices.data(), group.lodLevels.data(), group.matrices.size(),
+                                             textureFlags);
+
+            // Impostors have their textures baked in, the material's can go
+            if (meshDrawn || bakeGroup == &group) {
+                matManager.markMaterialUsed(group.mesh.materialIndex);
+            }
         }
-        MaterialManager::getInstance().bindMaterialBuffer(1);
+        matManager.updateResidency();
+        matManager.updateMaterialBuffer();
+        matManager.bindMaterialBuffer(1);
 
-        // Draw scene
+        // One bake per frame, the textures it samples were marked as used above
+        if (bakeGroup) {
+            uint32_t textureFlags = matManager.getTextureFlags(bakeGroup->mesh.materialIndex);
+            m_impostors.bake(bakeGroup->mesh, textureFlags, m_gBufferShaders.get(textureFlags), renderer);
+        }
+
+        // Draw scene, one program per set of texture flags. Meshlets are culled against the camera first.
+        m_geometryBatch.setMeshletCulling(quality.meshletCulling);
         m_geometryBatch.prepare(renderer);
-        m_geometryBatch.render(renderer);
+        m_geometryBatch.cullMeshlets(renderer, camera.getProjectionMatrix() * camera.getViewMatrix(), viewPosition);
+
+        uint64_t triangles = m_geometryBatch.getTriangleCount();
+        const MeshletCuller* culler = m_geometryBatch.getMeshletCuller();
+        if (culler && culler->getTestedMeshletCount() > 0) {
+            triangles += culler->getVisibleTriangleCount();
+            PROFILE_COUNTER("GeometryPass meshlets tested", culler->getTestedMeshletCount());
+            PROFILE_COUNTER("GeometryPass meshlets visible", culler->getVisibleMeshletCount());
+        }
+        PROFILE_COUNTER("GeometryPass triangles", triangles);
+        PROFILE_COUNTER("GeometryPass impostor instances", m_geometryBatch.getImpostorInstanceCount());
+        PROFILE_COUNTER("GeometryPass command rebuilds", m_geometryBatch.commandsRebuilt() ? 1 : 0);
+        static const uint32_t lodCounters[MESH_MAX_LODS] = {
+            Profiler::getInstance().registerCounter("GeometryPass LOD 0 instances"),
+            Profiler::getInstance().registerCounter("GeometryPass LOD 1 instances"),
+            Profiler::getInstance().registerCounter("GeometryPass LOD 2 instances"),
+            Profiler::getInstance().registerCounter("GeometryPass LOD 3 instances"),
+        };
+        for (uint32_t level = 0; level < MESH_MAX_LODS; ++level) {
+            Profiler::getInstance().addCounter(lodCounters[level], m_geometryBatch.getLodInstanceCount(level));
+        }
+
+        for (size_t i = 0; i < m_geometryBatch.getPermutationCount(); ++i) {
+            uint32_t permutation = m_geometryBatch.getPermutation(i);
+            Shader& shader = permutation == RenderBatch::IMPOSTOR_PERMUTATION ? m_impostorShader : m_gBufferShaders.get(permutation);
+            shader.use();
+            if (permutation == RenderBatch::IMPOSTOR_PERMUTATION) {
+                m_impostors.bind(shader, 0, IMPOSTOR_BINDING);
+            }
+            shader.setVec3("u_ViewPos", camera.getPosition());
+            shader.setMat4("u_View", camera.getViewMatrix());
+            shader.setMat4("u_Projection", camera.getProjectionMatrix());
+            m_geometryBatch.render(renderer, i);
+        }
 
         std::pair<int, int> dimensions = renderer.getScreenDimensions();
         int width = dimensions.first;
@@ -61,8 +173,14 @@ public:
     }
 
 private:
-    Shader m_gBufferShader;
+    // See impostor.vs
+    static constexpr GLuint IMPOSTOR_BINDING = 8;
+
+    ShaderVariants m_gBufferShaders;
     RenderBatch m_geometryBatch;
+
+    Shader m_impostorShader;
+    ImpostorAtlas m_impostors;
 };
 
 #endif // GEOMETRYPASS_H
@@ -6,9 +6,7 @@
 void LightPass::setup() {
     std::string lightVertexPath = ASSET_DIR "shaders/core/deferred/lightpass.vs";
     std::string lightFragmentPath = ASSET_DIR "shaders/core/deferred/lightpass.fs";
-    if (!m_lightPassShader.load(lightVertexPath, lightFragmentPath)) {
-        std::cerr << "[Error] LightPass::setup: Failed to create lightPassShader!\n";
-    }
+    m_lightPassShader.loadAsync(lightVertexPath, lightFragmentPath);
 
     // Generate and bind SSBOs
     glGenBuffers(1, &m_pointSSBO);
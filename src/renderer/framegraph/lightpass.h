@@ -7,6 +7,8 @@ class LightPass : public RenderPass {
 public:
     explicit LightPass() = default;
     void setup() override;
+    bool isReady() override { return m_lightPassShader.poll(); }
+    const char* getName() const override { return "LightPass"; }
     void execute(entt::registry& registry, Camera& camera, Renderer& renderer);
     void setSkyBox(unsigned int id) { m_skyboxTexture = id; }
 
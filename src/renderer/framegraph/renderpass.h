@@ -19,6 +19,12 @@ public:
     virtual void setup() = 0;
     virtual void execute(entt::registry& registry, Camera& camera, Renderer& renderer) = 0;
 
+    // Polled after setup() until it returns true, passes loading shaders asynchronously report them here
+    virtual bool isReady() { return true; }
+
+    // Label used for this pass in the profiler and exported traces
+    virtual const char* getName() const { return "RenderPass"; }
+
     // Set the scene reference (this will be called by FrameGraph)
     void setScene(Scene* scene) {
         m_scene = scene;
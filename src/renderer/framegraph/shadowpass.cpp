@@ -1,6 +1,7 @@
 #include "shadowpass.h"
 #include <glad/glad.h>
 #include "../../scene/scene.h"
+#include "debugging/profiler.h"
 
 ShadowPass::~ShadowPass() {
     // Clean up the framebuffer
@@ -22,9 +23,10 @@ ShadowPass::~ShadowPass() {
 void ShadowPass::setup() {
     std::string shadowVertPath = ASSET_DIR "shaders/core/shadow.vs";
     std::string shadowFragPath = ASSET_DIR "shaders/core/shadow.fs";
-    if (!m_shadowShader.load(shadowVertPath, shadowFragPath)) {
-        std::cerr << "[Error] ShadowPass: Failed to load shadow shader!\n";
-    }
+    m_shadowShader.loadAsync(shadowVertPath, shadowFragPath);
+
+    // shadow.vs only reads positions
+    m_shadowBatch.setVertexStream(MeshVertexStream::Position);
 
     // Create a shared framebuffer for all shadow rendering
     m_shadowFrameBuffer = new Framebuffer(1024, 1024, 0, true);
@@ -153,11 +155,21 @@ void ShadowPass::renderSceneDepth(Renderer& renderer, entt::registry& registry)
         const Mesh& mesh = view.get<Mesh>(entity);
         const ModelMatrix& modelMatrix = view.get<ModelMatrix>(entity);
 
-        m_shadowBatch.addInstance(RenderInstance(mesh, modelMatrix.matrix));
+        // Levels selected by the geometry pass, a frame behind since shadows are drawn first
+        RenderInstance instance(mesh, modelMatrix.matrix);
+        if (const LOD* lod = registry.try_get<LOD>(entity)) {
+            instance.lod = lod->level;
+        }
+        m_shadowBatch.addInstance(instance);
+    }
+    // Members the geometry pass draws as impostors cast the shadow of the coarsest level
+    for (const auto& [entity, group] : registry.view<InstancedMesh>().each()) {
+        m_shadowBatch.addInstanceRange(group.mesh, group.matrices.data(), group.lodLevels.data(), group.matrices.size());
     }
 
     // Draw scene
     m_shadowBatch.prepare(renderer);
+    PROFILE_COUNTER("ShadowPass triangles", m_shadowBatch.getTriangleCount());
     m_shadowBatch.render(renderer);
 }
 
@@ -13,6 +13,8 @@ public:
     ~ShadowPass();
 
     void setup() override;
+    bool isReady() override { return m_shadowShader.poll(); }
+    const char* getName() const override { return "ShadowPass"; }
     void execute(entt::registry& registry, Camera& camera, Renderer& renderer) override;
     void cleanupLightResources(entt::entity lightEntity);
 
@@ -12,9 +12,7 @@ public:
         std::string skyboxVertexPath = ASSET_DIR "shaders/core/skybox.vs";
         std::string skyboxFragmentPath = ASSET_DIR "shaders/core/skybox.fs";
 
-        if (!m_skyboxShader.load(skyboxVertexPath, skyboxFragmentPath)) {
-            std::cerr << "[Error] Renderer::loadSkyboxShader: Failed to create skyboxShader!\n";
-        }
+        m_skyboxShader.loadAsync(skyboxVertexPath, skyboxFragmentPath);
 
         // Get the cubemap vertices from MeshGen
         const float* cubeMapVerts = MeshGen::createCubeMapVerts();
@@ -34,6 +32,9 @@ public:
         glBindVertexArray(0);
     };
 
+    bool isReady() override { return m_skyboxShader.poll(); }
+
+    const char* getName() const override { return "SkyboxPass"; }
     void execute(entt::registry& registry, Camera& camera, Renderer& renderer) override {
         // Save ALL relevant OpenGL states
         GLint originalDepthFunc;
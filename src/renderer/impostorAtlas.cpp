@@ -0,0 +1,253 @@
+#include "impostorAtlas.h"
+#include "renderBatch.h"
+#include "renderer.h"
+#include "shader.h"
+#include "debugging/profiler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    constexpr GLenum LAYER_FORMATS[] = {GL_RGBA16F, GL_RGBA8, GL_RGBA8, GL_R11F_G11F_B10F, GL_DEPTH_COMPONENT24};
+    constexpr size_t LAYER_TEXEL_BYTES[] = {8, 4, 4, 4, 4};
+    constexpr const char* LAYER_UNIFORMS[] = {"u_ImpostorNormal", "u_ImpostorAlbedo", "u_ImpostorParams",
+                                              "u_ImpostorEmissive", "u_ImpostorDepth"};
+
+    constexpr GLsizei ATLAS_SIZE = ImpostorAtlas::FRAMES * ImpostorAtlas::FRAME_SIZE;
+
+    // Up vector of a view's camera, impostor.vs builds the same basis
+    glm::vec3 getFrameUp(const glm::vec3& direction) {
+        return std::abs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
+
+ImpostorAtlas::ImpostorAtlas() = default;
+
+ImpostorAtlas::~ImpostorAtlas() {
+    for (GLuint texture : m_textures) {
+        if (texture) {
+            glDeleteTextures(1, &texture);
+        }
+    }
+    if (m_impostorSSBO) {
+        glDeleteBuffers(1, &m_impostorSSBO);
+    }
+    if (m_framebuffer) {
+        glDeleteFramebuffers(1, &m_framebuffer);
+        glDeleteFramebuffers(1, &m_mipFramebuffer);
+    }
+}
+
+bool ImpostorAtlas::isCandidate(const Mesh& mesh, const Renderer& renderer) {
+    return mesh.drawMode == GL_TRIANGLES && renderer.hasMeshIndices(mesh.id) &&
+           renderer.getMeshLod(mesh.id, 0).indexCount / 3 >= MIN_TRIANGLES;
+}
+
+bool ImpostorAtlas::bake(const Mesh& mesh, uint32_t textureFlags, Shader& gBufferShader, Renderer& renderer) {
+    PROFILE_SCOPE("ImpostorAtlas::bake");
+    if (mesh.id >= m_bakes.size()) {
+        m_impostors.resize(mesh.id + 1, ImpostorData{});
+        m_bakes.resize(mesh.id + 1);
+    }
+    Bake& bake = m_bakes[mesh.id];
+    glm::vec4 sphere = renderer.getMeshBoundingSphere(mesh.id);
+    if (!gBufferShader.isValid() || sphere.w <= 0.0f) {
+        bake.failed = true;
+        return false;
+    }
+
+    uint32_t layer = bake.baked ? m_impostors[mesh.id].layer : m_layerCount;
+    if (!bake.baked && !reserveLayers(m_layerCount + 1)) {
+        bake.failed = true;
+        return false;
+    }
+
+    if (!m_framebuffer) {
+        glGenFramebuffers(1, &m_framebuffer);
+        glGenFramebuffers(1, &m_mipFramebuffer);
+        m_bakeBatch = std::make_unique<RenderBatch>(1);
+    }
+
+    GLint previousFramebuffer = 0;
+    GLint previousViewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    // The layers take G-buffer outputs 1-4, the world position output isn't kept
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    for (GLenum i = Normal; i <= Emissive; ++i) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1 + i, m_textures[i], 0, static_cast<GLint>(layer));
+    }
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_textures[Depth], 0, static_cast<GLint>(layer));
+    const GLenum drawBuffers[] = {GL_NONE, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4};
+    glDrawBuffers(5, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "[Error] ImpostorAtlas::bake: Framebuffer is not complete!\n";
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        bake.failed = true;
+        return false;
+    }
+
+    const GLfloat empty[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    const GLfloat farDepth = 1.0f;
+    for (GLint i = 1; i <= 4; ++i) {
+        glClearBufferfv(GL_COLOR, i, empty);
+    }
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+
+    m_bakeBatch->clear();
+    m_bakeBatch->addInstance(RenderInstance(mesh, glm::mat4(1.0f)));
+    m_bakeBatch->prepare(renderer);
+
+    // Depth runs linearly from the front of the sphere (0) to its back (1)
+    glm::vec3 center(sphere);
+    float radius = sphere.w;
+    glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+    gBufferShader.use();
+    gBufferShader.setMat4("u_Projection", projection);
+    for (uint32_t y = 0; y < FRAMES; ++y) {
+        for (uint32_t x = 0; x < FRAMES; ++x) {
+            glm::vec3 direction = getFrameDirection(x, y);
+            glm::vec3 eye = center + direction * (2.0f * radius);
+            glViewport(static_cast<GLint>(x * FRAME_SIZE), static_cast<GLint>(y * FRAME_SIZE), FRAME_SIZE, FRAME_SIZE);
+            gBufferShader.setVec3("u_ViewPos", eye);
+            gBufferShader.setMat4("u_View", glm::lookAt(eye, center, getFrameUp(direction)));
+            m_bakeBatch->render(renderer);
+        }
+    }
+
+    generateFrameMips(layer);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+
+    if (!bake.baked) {
+        m_layerCount++;
+    }
+    m_impostors[mesh.id] = {sphere, layer, {}};
+    bake.baked = true;
+    bake.textureFlags = textureFlags;
+    m_impostorsDirty = true;
+    return true;
+}
+
+void ImpostorAtlas::bind(const Shader& impostorShader, GLuint firstUnit, GLuint bufferBinding) {
+    if (m_impostorsDirty) {
+        uploadImpostors();
+    }
+    for (GLuint i = 0; i < LayerCount; ++i) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_textures[i]);
+        impostorShader.setInt(LAYER_UNIFORMS[i], static_cast<int>(firstUnit + i));
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bufferBinding, m_impostorSSBO);
+}
+
+size_t ImpostorAtlas::getMemoryBytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < LayerCount; ++i) {
+        uint32_t levels = i == Depth ? 1 : MIP_LEVELS;
+        for (uint32_t level = 0; level < levels; ++level) {
+            size_t size = static_cast<size_t>(ATLAS_SIZE >> level);
+            bytes += size * size * LAYER_TEXEL_BYTES[i];
+        }
+    }
+    return bytes * m_layerCapacity;
+}
+
+glm::vec3 ImpostorAtlas::getFrameDirection(uint32_t x, uint32_t y) {
+    // Octahedral map of the view centers, the upper hemisphere is the inner diamond
+    glm::vec2 p = (glm::vec2(x, y) + 0.5f) / static_cast<float>(FRAMES) * 2.0f - 1.0f;
+    glm::vec3 direction(p.x, 1.0f - std::abs(p.x) - std::abs(p.y), p.y);
+    if (direction.y < 0.0f) {
+        glm::vec2 folded = (1.0f - glm::abs(glm::vec2(direction.z, direction.x))) *
+                           glm::vec2(direction.x >= 0.0f ? 1.0f : -1.0f, direction.z >= 0.0f ? 1.0f : -1.0f);
+        direction.x = folded.x;
+        direction.z = folded.y;
+    }
+    return glm::normalize(direction);
+}
+
+bool ImpostorAtlas::reserveLayers(uint32_t count) {
+    if (count <= m_layerCapacity) {
+        return true;
+    }
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (count > static_cast<uint32_t>(maxLayers)) {
+        std::cerr << "[Warning] ImpostorAtlas::reserveLayers: Out of layers, " << count - 1 << " impostors already baked\n";
+        return false;
+    }
+    uint32_t capacity = std::min(std::max(count, m_layerCapacity * 2), static_cast<uint32_t>(maxLayers));
+
+    for (size_t i = 0; i < LayerCount; ++i) {
+        GLsizei levels = i == Depth ? 1 : MIP_LEVELS;
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, LAYER_FORMATS[i], ATLAS_SIZE, ATLAS_SIZE, static_cast<GLsizei>(capacity));
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, i == Depth ? GL_NEAREST : GL_LINEAR_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, i == Depth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        if (m_textures[i]) {
+            if (m_layerCount > 0) {
+                for (GLint level = 0; level < levels; ++level) {
+                    GLsizei size = ATLAS_SIZE >> level;
+                    glCopyImageSubData(m_textures[i], GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, texture, GL_TEXTURE_2D_ARRAY, level,
+                                       0, 0, 0, size, size, static_cast<GLsizei>(m_layerCount));
+                }
+            }
+            glDeleteTextures(1, &m_textures[i]);
+        }
+        m_textures[i] = texture;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    m_layerCapacity = capacity;
+    return true;
+}
+
+void ImpostorAtlas::generateFrameMips(uint32_t layer) {
+    // Every view is halved on its own, so a level never averages texels of neighbouring views
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_mipFramebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    const GLenum drawBuffer = GL_COLOR_ATTACHMENT0;
+    glDrawBuffers(1, &drawBuffer);
+    for (GLenum i = Normal; i <= Emissive; ++i) {
+        for (GLint level = 1; level < static_cast<GLint>(MIP_LEVELS); ++level) {
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_textures[i], level - 1, static_cast<GLint>(layer));
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_textures[i], level, static_cast<GLint>(layer));
+            GLint source = static_cast<GLint>(FRAME_SIZE >> (level - 1));
+            GLint target = source / 2;
+            for (GLint y = 0; y < static_cast<GLint>(FRAMES); ++y) {
+                for (GLint x = 0; x < static_cast<GLint>(FRAMES); ++x) {
+                    glBlitFramebuffer(x * source, y * source, (x + 1) * source, (y + 1) * source,
+                                      x * target, y * target, (x + 1) * target, (y + 1) * target, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+                }
+            }
+        }
+    }
+    // The bake framebuffer's attachment 0 goes back to unused
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0);
+}
+
+void ImpostorAtlas::uploadImpostors() {
+    if (!m_impostorSSBO) {
+        glGenBuffers(1, &m_impostorSSBO);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_impostorSSBO);
+    if (m_impostors.size() > m_impostorCapacity) {
+        m_impostorCapacity = m_impostors.size() * 3 / 2 + 1;
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(m_impostorCapacity * sizeof(ImpostorData)), nullptr,
+                     GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(m_impostors.size() * sizeof(ImpostorData)),
+                    m_impostors.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    m_impostorsDirty = false;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "../components/mesh.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <memory>
+#include <vector>
+
+// Forward declarations
+class Renderer;
+class RenderBatch;
+class Shader;
+
+/*
+ * Octahedral impostors for far members of instanced meshes.
+ *
+ * Every baked mesh owns a layer of the atlas with FRAMES x FRAMES views,
+ * their directions spread over the sphere by an octahedral map. Each view is
+ * an orthographic render around the mesh's bounding sphere with the G-buffer
+ * program of its material, so the layers hold what the G-buffer would get in
+ * model space: normal, albedo, PBR parameters and emissive, plus depth across
+ * the sphere. Texels the mesh doesn't cover stay 0, so the PBR alpha doubles
+ * as coverage and the mip levels hold colors premultiplied by it. Views are
+ * downsampled one by one and impostor.fs keeps its samples inside the view,
+ * so no level blends neighbouring views.
+ *
+ * impostor.vs turns an instance into a quad facing the view nearest to the
+ * camera, impostor.fs rebuilds the position from the depth and fills the
+ * G-buffer like the mesh would.
+ */
+class ImpostorAtlas {
+public:
+    static constexpr uint32_t FRAMES = 16;      // Views per side of the octahedral grid
+    static constexpr uint32_t FRAME_SIZE = 32;  // Texels per side of a view
+    static constexpr uint32_t MIP_LEVELS = 3;   // Down to 8 texels per view
+    // Meshes with fewer triangles are cheaper to draw than a fragment-depth quad
+    static constexpr uint32_t MIN_TRIANGLES = 256;
+
+    ImpostorAtlas();
+    ~ImpostorAtlas();
+
+    // Indexed triangle meshes with enough triangles for an impostor to pay off
+    static bool isCandidate(const Mesh& mesh, const Renderer& renderer);
+
+    bool hasImpostor(size_t meshId) const { return meshId < m_bakes.size() && m_bakes[meshId].baked; }
+    // Not baked yet or the material gained textures since, meshes that failed to bake aren't tried again
+    bool needsBake(const Mesh& mesh, uint32_t textureFlags) const {
+        if (mesh.id >= m_bakes.size()) {
+            return true;
+        }
+        const Bake& bake = m_bakes[mesh.id];
+        return !bake.failed && (!bake.baked || (textureFlags & ~bake.textureFlags) != 0);
+    }
+
+    /*
+     * Renders the views of the mesh into its layer, the first bake of a mesh
+     * takes a new one. Expects the material buffer bound, restores the
+     * framebuffer and viewport.
+     * @param gBufferShader - G-buffer program of the mesh's material.
+     * @return false when the mesh has no bounds or the atlas is out of layers.
+     */
+    bool bake(const Mesh& mesh, uint32_t textureFlags, Shader& gBufferShader, Renderer& renderer);
+
+    // Binds the layers to texture units [firstUnit, firstUnit + 5) of impostor.fs and the impostors indexed by mesh ID
+    void bind(const Shader& impostorShader, GLuint firstUnit, GLuint bufferBinding);
+
+    uint32_t getImpostorCount() const { return m_layerCount; }
+    size_t getMemoryBytes() const;
+
+    // Model space direction from the mesh toward the camera of view (x, y)
+    static glm::vec3 getFrameDirection(uint32_t x, uint32_t y);
+
+private:
+    // Layer textures, in the order of the G-buffer outputs they are rendered from
+    enum Layer { Normal, Albedo, Params, Emissive, Depth, LayerCount };
+
+    // std430 layout of Impostor in impostor.vs, indexed by mesh ID
+    struct ImpostorData {
+        glm::vec4 boundingSphere;   // The views are fitted to it
+        uint32_t layer;
+        uint32_t _padding[3];
+    };
+
+    struct Bake {
+        bool baked = false;
+        bool failed = false;
+        uint32_t textureFlags = 0;
+    };
+
+    std::array<GLuint, LayerCount> m_textures{};
+    uint32_t m_layerCount = 0;
+    uint32_t m_layerCapacity = 0;
+
+    std::vector<ImpostorData> m_impostors;
+    std::vector<Bake> m_bakes;  // Parallel to m_impostors
+    GLuint m_impostorSSBO = 0;
+    size_t m_impostorCapacity = 0;
+    bool m_impostorsDirty = false;
+
+    GLuint m_framebuffer = 0;
+    GLuint m_mipFramebuffer = 0;
+    std::unique_ptr<RenderBatch> m_bakeBatch;
+
+    // Grows the textures to at least count layers, copying the baked ones
+    bool reserveLayers(uint32_t count);
+    // Levels 1+ of the layer's color textures, downsampled view by view
+    void generateFrameMips(uint32_t layer);
+    void uploadImpostors();
+};
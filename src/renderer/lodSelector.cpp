@@ -0,0 +1,43 @@
+#include "lodSelector.h"
+
+#include <algorithm>
+#include <cmath>
+
+float LodSelector::projectedSize(const glm::vec4& sphere, const glm::mat4& modelMatrix, const glm::vec3& viewPosition, float projectionScale) {
+    glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(sphere), 1.0f));
+    float scale = std::max({glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+                            glm::length(glm::vec3(modelMatrix[2]))});
+    float radius = sphere.w * scale;
+
+    // Inside the sphere it covers the whole screen
+    float distance = glm::length(center - viewPosition);
+    if (distance <= radius) {
+        return 1.0f;
+    }
+    return radius * projectionScale / distance;
+}
+
+uint32_t LodSelector::select(float projectedSize, uint32_t currentLevel, uint32_t levelCount, float screenSize, float hysteresis) {
+    if (levelCount <= 1) {
+        return 0;
+    }
+
+    // Threshold between level k and k + 1
+    auto threshold = [screenSize](uint32_t level) { return screenSize * std::ldexp(1.0f, -static_cast<int>(level)); };
+
+    uint32_t level = std::min(currentLevel, levelCount - 1);
+    while (level + 1 < levelCount && projectedSize < threshold(level) * (1.0f - hysteresis)) {
+        level++;
+    }
+    while (level > 0 && projectedSize > threshold(level - 1) * (1.0f + hysteresis)) {
+        level--;
+    }
+    return level;
+}
+
+bool LodSelector::selectImpostor(float projectedSize, bool currentImpostor, float screenSize, float hysteresis) {
+    if (currentImpostor) {
+        return projectedSize <= screenSize * (1.0f + hysteresis);
+    }
+    return projectedSize < screenSize * (1.0f - hysteresis);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/*
+ * Screen size based LOD selection. Level k + 1 takes over once a mesh covers
+ * less than screenSize / 2^k of the viewport height, and only goes back once
+ * it is hysteresis past the threshold again, so meshes near a threshold
+ * don't pop back and forth.
+ */
+namespace LodSelector {
+    /*
+     * Fraction of the viewport height covered by a bounding sphere.
+     * @param sphere - Model space, xyz center and w radius (Renderer::getMeshBoundingSphere).
+     * @param projectionScale - projection[1][1] of the camera.
+     */
+    float projectedSize(const glm::vec4& sphere, const glm::mat4& modelMatrix, const glm::vec3& viewPosition, float projectionScale);
+
+    // @return The level to draw, starting from the one drawn last
+    uint32_t select(float projectedSize, uint32_t currentLevel, uint32_t levelCount, float screenSize, float hysteresis);
+
+    // Whether to draw the impostor instead of a level, with the same hysteresis around screenSize
+    bool selectImpostor(float projectedSize, bool currentImpostor, float screenSize, float hysteresis);
+}
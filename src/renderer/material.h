@@ -10,6 +10,7 @@
 #define MATERIAL_HAS_METALLIC_ROUGHNESS_MAP (1u << 2)  // 0x04
 #define MATERIAL_HAS_EMISSIVE_MAP           (1u << 3)  // 0x08
 #define MATERIAL_HAS_HEIGHT_MAP             (1u << 4)  // 0x10
+#define MATERIAL_NORMAL_MAP_XY              (1u << 5)  // 0x20, BC5 normal map, Z is reconstructed
 
 // Table to fill out in material init
 struct MaterialDefinition {
@@ -1,5 +1,28 @@
 #include "materialManager.h"
 #include "texture.h"
+#include "../system/jobSystem.h"
+#include "../debugging/profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <unordered_set>
+
+namespace {
+    // Largest mip level an evicted texture keeps, 64x64 BC7 is 5.5 KB
+    constexpr int MIP_TAIL_SIZE = 64;
+
+    // Texture paths of a definition with their MATERIAL_HAS_* flag
+    std::array<std::pair<const std::string*, uint32_t>, 5> getTextureSlots(const MaterialDefinition& def) {
+        return {{
+            {&def.albedoMapPath, MATERIAL_HAS_ALBEDO_MAP},
+            {&def.normalMapPath, MATERIAL_HAS_NORMAL_MAP},
+            {&def.metallicRoughnessMapPath, MATERIAL_HAS_METALLIC_ROUGHNESS_MAP},
+            {&def.emissiveMapPath, MATERIAL_HAS_EMISSIVE_MAP},
+            {&def.heightMapPath, MATERIAL_HAS_HEIGHT_MAP},
+        }};
+    }
+}
 
 MaterialManager::~MaterialManager() {
     cleanup();
@@ -34,8 +57,12 @@ bool MaterialManager::initialize(size_t maxMaterials) {
 }
 
 void MaterialManager::cleanup() {
-    // Clean up textures
+    // Clean up textures, decodes still running finish into discarded futures
     m_textureCache.clear();
+    m_pendingTextures.clear();
+    m_materialLastUsed.clear();
+    m_frame = 1;
+    m_residencyTotals = ResidencyStats();
 
     if (m_materialSSBO != 0) {
         glDeleteBuffers(1, &m_materialSSBO);
@@ -47,32 +74,316 @@ void MaterialManager::cleanup() {
     m_initialized = false;
 }
 
-GLuint64 MaterialManager::getTextureHandle(const std::string& filePath) {
+const Texture* MaterialManager::getTexture(const std::string& filePath, uint32_t materialIndex, uint32_t textureFlag) {
     if (filePath.empty()) {
-        return 0;
+        return nullptr;
     }
 
     // Check if texture already exists
     auto it = m_textureCache.find(filePath);
     if (it != m_textureCache.end()) {
-        // Texture already loaded, return existing handle
-        GLuint64 handle = it->second->getHandle();
-        return handle;
+        // An evicted texture hands out its mip tail until it is reloaded
+        CachedTexture& entry = it->second;
+        entry.users.emplace_back(materialIndex, textureFlag);
+        return entry.texture ? entry.texture.get() : entry.mipTail.get();
+    }
+
+    if (m_asyncTextures) {
+        // Decode in the background, the material is patched in uploadNextTexture()
+        PendingTexture& pending = m_pendingTextures[filePath];
+        if (!pending.image.valid()) {
+            TextureUsage usage = getTextureUsage(textureFlag);
+            pending.image = JobSystem::getInstance().submit([filePath, usage]() {
+                return Texture::decode(filePath, usage);
+            });
+        }
+        pending.users.emplace_back(materialIndex, textureFlag);
+        return nullptr;
     }
 
     // Load new texture
-    auto texture = std::make_shared<Texture>(filePath);
+    TextureUsage usage = getTextureUsage(textureFlag);
+    auto texture = std::make_shared<Texture>(filePath, usage);
     if (texture->isValid()) {
-        texture->makeResident();
-        m_textureCache[filePath] = texture;
-        return texture->getHandle();
+        addTexture(filePath, texture, usage).users.emplace_back(materialIndex, textureFlag);
+        return texture.get();
     } else {
         std::cerr << "[Error] MaterialManager: Failed to load texture: " << filePath << "\n";
+        return nullptr;
+    }
+}
+
+void MaterialManager::preloadTextures(const std::vector<const MaterialDefinition*>& materialDefs) {
+    // Unique paths that aren't loaded or streaming, the first slot using a path picks its usage
+    std::vector<std::pair<std::string, TextureUsage>> requests;
+    std::unordered_set<std::string> requested;
+    for (const MaterialDefinition* def : materialDefs) {
+        if (!def) {
+            continue;
+        }
+        for (const auto& [path, textureFlag] : getTextureSlots(*def)) {
+            if (path->empty() || m_textureCache.count(*path) || m_pendingTextures.count(*path) ||
+                !requested.insert(*path).second) {
+                continue;
+            }
+            requests.emplace_back(*path, getTextureUsage(textureFlag));
+        }
+    }
+    if (requests.empty()) {
+        return;
+    }
+    PROFILE_SCOPE("MaterialManager::preloadTextures");
+
+    // Decoded a batch at a time and uploaded before the next, so only one batch of images sits in RAM
+    const size_t batchSize = 2 * (JobSystem::getInstance().getWorkerCount() + 1);
+    std::vector<TextureImage> images(std::min(batchSize, requests.size()));
+    std::chrono::steady_clock::duration decodeTime{};
+    std::chrono::steady_clock::duration uploadTime{};
+    size_t uploadedBytes = 0;
+    size_t loadedCount = 0;
+    for (size_t first = 0; first < requests.size(); first += batchSize) {
+        size_t count = std::min(batchSize, requests.size() - first);
+        auto decodeStart = std::chrono::steady_clock::now();
+        JobSystem::getInstance().parallelFor(count, [&](size_t i) {
+            images[i] = Texture::decode(requests[first + i].first, requests[first + i].second);
+        });
+        auto uploadStart = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < count; ++i) {
+            const std::string& filePath = requests[first + i].first;
+            if (!images[i].isValid()) {
+                continue; // Decode error already logged
+            }
+
+            auto texture = std::make_shared<Texture>(filePath, images[i]);
+            if (texture->isValid()) {
+                addTexture(filePath, texture, requests[first + i].second);
+                uploadedBytes += images[i].getSize();
+                loadedCount++;
+            } else {
+                std::cerr << "[Error] MaterialManager: Failed to load texture: " << filePath << "\n";
+            }
+            images[i] = TextureImage();
+        }
+        decodeTime += uploadStart - decodeStart;
+        uploadTime += std::chrono::steady_clock::now() - uploadStart;
+    }
+
+    std::cout << "[Info] MaterialManager: Preloaded " << loadedCount << " / " << requests.size() << " textures ("
+              << uploadedBytes / (1024 * 1024) << " MB) in "
+              << std::chrono::duration<double, std::milli>(decodeTime).count() << " ms decode + "
+              << std::chrono::duration<double, std::milli>(uploadTime).count() << " ms upload\n";
+}
+
+size_t MaterialManager::uploadNextTexture() {
+    auto it = m_pendingTextures.begin();
+    while (it != m_pendingTextures.end() &&
+           it->second.image.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        ++it;
+    }
+    if (it == m_pendingTextures.end()) {
         return 0;
     }
+    PROFILE_SCOPE("MaterialManager::uploadNextTexture");
+
+    const std::string& filePath = it->first;
+    TextureImage image = it->second.image.get();
+    size_t uploadedBytes = image.getSize();
+
+    auto texture = std::make_shared<Texture>(filePath, image);
+    if (texture->isValid()) {
+        TextureUsers& users = it->second.users;
+        CachedTexture& entry = addTexture(filePath, texture, getTextureUsage(users.front().second));
+        entry.users = std::move(users);
+        updateTextureUsers(entry);
+    } else {
+        std::cerr << "[Error] MaterialManager: Failed to load texture: " << filePath << "\n";
+    }
+
+    m_pendingTextures.erase(it);
+    return uploadedBytes > 0 ? uploadedBytes : 1;
+}
+
+MaterialManager::CachedTexture& MaterialManager::addTexture(const std::string& filePath, std::shared_ptr<Texture> texture,
+                                                             TextureUsage usage) {
+    texture->makeResident();
+    CachedTexture& entry = m_textureCache[filePath];
+    entry.size = texture->getMemorySize();
+    entry.texture = std::move(texture);
+    entry.usage = usage;
+    return entry;
+}
+
+void MaterialManager::evictTexture(CachedTexture& entry) {
+    entry.mipTail = entry.texture->createMipTail(MIP_TAIL_SIZE);
+    if (entry.mipTail) {
+        entry.mipTail->makeResident();
+    }
+    // Deleting the texture makes its handle non-resident and frees the memory
+    entry.texture.reset();
+    updateTextureUsers(entry);
+    m_residencyTotals.evictions++;
+}
+
+void MaterialManager::updateTextureUsers(const CachedTexture& entry) {
+    const Texture* texture = entry.texture ? entry.texture.get() : entry.mipTail.get();
+    for (const auto& [materialIndex, textureFlag] : entry.users) {
+        if (texture) {
+            setTexture(m_materials[materialIndex], textureFlag, *texture);
+        } else {
+            clearTexture(m_materials[materialIndex], textureFlag);
+        }
+    }
+    m_needsUpdate = true;
+}
+
+void MaterialManager::updateResidency() {
+    if (!m_initialized) {
+        return;
+    }
+    PROFILE_SCOPE("MaterialManager::updateResidency");
+
+    uint64_t frame = m_frame++;
+    size_t budget = m_residencyBudget > 0 ? m_residencyBudget : SIZE_MAX;
+    size_t residentBytes = 0;
+    std::vector<CachedTexture*> evictable;                             // Loaded, not used this frame
+    std::vector<std::pair<const std::string*, CachedTexture*>> wanted; // Evicted, used this frame
+
+    for (auto& [filePath, entry] : m_textureCache) {
+        if (entry.reload.valid() && entry.reload.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            TextureImage image = entry.reload.get();
+            auto texture = std::make_shared<Texture>(filePath, image);
+            if (texture->isValid()) {
+                texture->makeResident();
+                entry.texture = std::move(texture);
+                entry.mipTail.reset();
+                updateTextureUsers(entry);
+                m_residencyTotals.reloads++;
+            } else {
+                std::cerr << "[Error] MaterialManager::updateResidency: Failed to reload texture: " << filePath << "\n";
+                entry.reloadFailed = true;
+            }
+        }
+
+        entry.lastUsedFrame = 0;
+        for (const auto& user : entry.users) {
+            entry.lastUsedFrame = std::max(entry.lastUsedFrame, m_materialLastUsed[user.first]);
+        }
+
+        if (entry.texture) {
+            residentBytes += entry.size;
+            // Without a mip tail eviction would clear the texture from its materials for a few KB
+            if (entry.lastUsedFrame < frame && entry.texture->hasMipTail(MIP_TAIL_SIZE)) {
+                evictable.push_back(&entry);
+            }
+            continue;
+        }
+        residentBytes += entry.mipTail ? entry.mipTail->getMemorySize() : 0;
+        if (entry.reload.valid()) {
+            residentBytes += entry.size;
+        } else if (entry.lastUsedFrame == frame && !entry.reloadFailed) {
+            wanted.emplace_back(&filePath, &entry);
+        }
+    }
+
+    // Least recently used go first, textures used this frame are never evicted
+    std::sort(evictable.begin(), evictable.end(), [](const CachedTexture* a, const CachedTexture* b) {
+        return a->lastUsedFrame < b->lastUsedFrame;
+    });
+    size_t nextEviction = 0;
+    auto makeRoom = [&](size_t bytes) {
+        while (residentBytes + bytes > budget && nextEviction < evictable.size()) {
+            CachedTexture& victim = *evictable[nextEviction++];
+            evictTexture(victim);
+            residentBytes -= victim.size;
+            residentBytes += victim.mipTail ? victim.mipTail->getMemorySize() : 0;
+        }
+        return residentBytes + bytes <= budget;
+    };
+
+    // Reload what the draws need while it fits, the rest keeps sampling its mip tail
+    bool overBudget = false;
+    for (const auto& [filePath, entry] : wanted) {
+        if (!makeRoom(entry->size)) {
+            overBudget = true;
+            continue;
+        }
+        residentBytes += entry->size;
+        TextureUsage usage = entry->usage;
+        entry->reload = JobSystem::getInstance().submit([path = *filePath, usage]() {
+            return Texture::decode(path, usage);
+        });
+    }
+    if (!makeRoom(0) || overBudget) {
+        m_residencyTotals.overBudgetFrames++;
+    }
+}
+
+MaterialManager::ResidencyStats MaterialManager::getResidencyStats() const {
+    ResidencyStats stats = m_residencyTotals;
+    stats.budgetBytes = m_residencyBudget;
+    for (const auto& [filePath, entry] : m_textureCache) {
+        if (entry.texture) {
+            stats.residentBytes += entry.size;
+            stats.residentTextures++;
+            continue;
+        }
+        if (entry.mipTail) {
+            stats.residentBytes += entry.mipTail->getMemorySize();
+            stats.mipTailTextures++;
+        } else {
+            stats.fallbackTextures++;
+        }
+        if (entry.reload.valid()) {
+            stats.residentBytes += entry.size;
+            stats.reloadingTextures++;
+        }
+    }
+    return stats;
+}
+
+void MaterialManager::setTexture(MaterialData& data, uint32_t textureFlag, const Texture& texture) {
+    GLuint64 handle = texture.getHandle();
+    switch (textureFlag) {
+        case MATERIAL_HAS_ALBEDO_MAP:             data.albedoMapHandle = handle; break;
+        case MATERIAL_HAS_NORMAL_MAP:             data.normalMapHandle = handle; break;
+        case MATERIAL_HAS_METALLIC_ROUGHNESS_MAP: data.metallicRoughnessMapHandle = handle; break;
+        case MATERIAL_HAS_EMISSIVE_MAP:           data.emissiveMapHandle = handle; break;
+        case MATERIAL_HAS_HEIGHT_MAP:             data.heightMapHandle = handle; break;
+        default: return;
+    }
+    data.setTextureFlag(textureFlag);
+    if (textureFlag == MATERIAL_HAS_NORMAL_MAP && texture.getFormat() == TextureFormat::BC5) {
+        data.setTextureFlag(MATERIAL_NORMAL_MAP_XY);
+    }
+}
+
+void MaterialManager::clearTexture(MaterialData& data, uint32_t textureFlag) {
+    switch (textureFlag) {
+        case MATERIAL_HAS_ALBEDO_MAP:             data.albedoMapHandle = 0; break;
+        case MATERIAL_HAS_NORMAL_MAP:             data.normalMapHandle = 0; break;
+        case MATERIAL_HAS_METALLIC_ROUGHNESS_MAP: data.metallicRoughnessMapHandle = 0; break;
+        case MATERIAL_HAS_EMISSIVE_MAP:           data.emissiveMapHandle = 0; break;
+        case MATERIAL_HAS_HEIGHT_MAP:             data.heightMapHandle = 0; break;
+        default: return;
+    }
+    data.clearTextureFlag(textureFlag);
+    if (textureFlag == MATERIAL_HAS_NORMAL_MAP) {
+        data.clearTextureFlag(MATERIAL_NORMAL_MAP_XY);
+    }
+}
+
+TextureUsage MaterialManager::getTextureUsage(uint32_t textureFlag) {
+    switch (textureFlag) {
+        case MATERIAL_HAS_ALBEDO_MAP:
+        case MATERIAL_HAS_EMISSIVE_MAP: return TextureUsage::Color;
+        case MATERIAL_HAS_NORMAL_MAP:   return TextureUsage::Normal;
+        case MATERIAL_HAS_HEIGHT_MAP:   return TextureUsage::Height;
+        default:                        return TextureUsage::Data;
+    }
 }
 
-MaterialData MaterialManager::createMaterialData(const MaterialDefinition& def) {
+MaterialData MaterialManager::createMaterialData(const MaterialDefinition& def, uint32_t materialIndex) {
     MaterialData data;
 
     // Copy material properties
@@ -85,34 +396,10 @@ MaterialData MaterialManager::createMaterialData(const MaterialDefinition& def)
     data.time = def.time;
 
     // Load textures and set handles + flags
-    GLuint64 handle = getTextureHandle(def.albedoMapPath);
-    if (handle != 0) {
-        data.albedoMapHandle = handle;
-        data.setTextureFlag(MATERIAL_HAS_ALBEDO_MAP);
-    }
-
-    handle = getTextureHandle(def.normalMapPath);
-    if (handle != 0) {
-        data.normalMapHandle = handle;
-        data.setTextureFlag(MATERIAL_HAS_NORMAL_MAP);
-    }
-
-    handle = getTextureHandle(def.metallicRoughnessMapPath);
-    if (handle != 0) {
-        data.metallicRoughnessMapHandle = handle;
-        data.setTextureFlag(MATERIAL_HAS_METALLIC_ROUGHNESS_MAP);
-    }
-
-    handle = getTextureHandle(def.emissiveMapPath);
-    if (handle != 0) {
-        data.emissiveMapHandle = handle;
-        data.setTextureFlag(MATERIAL_HAS_EMISSIVE_MAP);
-    }
-
-    handle = getTextureHandle(def.heightMapPath);
-    if (handle != 0) {
-        data.heightMapHandle = handle;
-        data.setTextureFlag(MATERIAL_HAS_HEIGHT_MAP);
+    for (const auto& [path, textureFlag] : getTextureSlots(def)) {
+        if (const Texture* texture = getTexture(*path, materialIndex, textureFlag)) {
+            setTexture(data, textureFlag, *texture);
+        }
     }
 
     return data;
@@ -139,9 +426,10 @@ uint32_t MaterialManager::getMaterialIndex(const MaterialDefinition& materialDef
     }
 
     uint32_t materialIndex = static_cast<uint32_t>(m_materials.size());
-    MaterialData materialData = createMaterialData(materialDef);
+    MaterialData materialData = createMaterialData(materialDef, materialIndex);
 
     m_materials.push_back(materialData);
+    m_materialLastUsed.push_back(0);
     m_materialMap[materialDef] = materialIndex;
     m_needsUpdate = true;
 
@@ -191,4 +479,16 @@ void MaterialManager::printStats() const {
 
     std::cout << "  Total Texture References: " << totalTextureReferences << "\n";
     std::cout << "  Deduplication Savings: " << (totalTextureReferences - m_textureCache.size()) << " textures\n";
+
+    ResidencyStats residency = getResidencyStats();
+    std::cout << "  Texture Memory: " << residency.residentBytes / (1024.0 * 1024.0) << " MB";
+    if (residency.budgetBytes > 0) {
+        std::cout << " / " << residency.budgetBytes / (1024.0 * 1024.0) << " MB budget\n";
+    } else {
+        std::cout << " (no budget)\n";
+    }
+    std::cout << "  Residency: " << residency.residentTextures << " full, " << residency.mipTailTextures << " mip tail, "
+              << residency.fallbackTextures << " fallback, " << residency.reloadingTextures << " reloading\n";
+    std::cout << "  Evictions: " << residency.evictions << ", Reloads: " << residency.reloads
+              << ", Frames Over Budget: " << residency.overBudgetFrames << "\n";
 }
@@ -6,6 +6,7 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <future>
 #include <iostream>
 
 #include "material.h"
@@ -79,6 +80,72 @@ public:
     // Bind material buffer for rendering
     void bindMaterialBuffer(GLuint bindingPoint = 0);
 
+    /*
+     * Decodes every texture the definitions reference that isn't loaded yet in
+     * parallel on the job system (mip chains included), uploading and freeing
+     * each batch before decoding the next to bound peak memory.
+     * getMaterialIndex() finds them in the cache afterwards instead of
+     * decoding one file at a time.
+     */
+    void preloadTextures(const std::vector<const MaterialDefinition*>& materialDefs);
+
+    /*
+     * Async texture loading. New textures are decoded on the job system and
+     * materials render without them until uploadNextTexture() brings them in.
+     */
+    void setAsyncTextureLoading(bool enabled) { m_asyncTextures = enabled; }
+    bool hasPendingTextures() const { return !m_pendingTextures.empty(); }
+
+    /*
+     * Uploads one decoded texture and patches the materials waiting on it.
+     * Call updateMaterialBuffer() afterwards.
+     * @return Bytes uploaded, 0 if no decode has finished yet.
+     */
+    size_t uploadNextTexture();
+
+    // How a MATERIAL_HAS_* slot samples its texture
+    static TextureUsage getTextureUsage(uint32_t textureFlag);
+
+    /*
+     * Texture residency. Draws report the materials they use every frame and
+     * updateResidency() keeps the GPU memory of the textures under the budget:
+     * the least recently used ones are deleted and their materials sample a
+     * small mip tail instead (or their constants, if the texture has no mips to
+     * spare) until a draw uses them again and they are reloaded in the background.
+     * A budget of 0 keeps every texture resident.
+     */
+    struct ResidencyStats {
+        size_t budgetBytes = 0;
+        size_t residentBytes = 0;       // Full textures, mip tails and reloads in flight
+        uint32_t residentTextures = 0;
+        uint32_t mipTailTextures = 0;   // Evicted, sampling their mip tail
+        uint32_t fallbackTextures = 0;  // Evicted without a tail, materials use their constants
+        uint32_t reloadingTextures = 0;
+        uint32_t evictions = 0;         // Totals since initialize()
+        uint32_t reloads = 0;
+        uint32_t overBudgetFrames = 0;  // Frames whose used textures alone didn't fit
+    };
+
+    void setResidencyBudget(size_t bytes) { m_residencyBudget = bytes; }
+    size_t getResidencyBudget() const { return m_residencyBudget; }
+    void markMaterialUsed(uint32_t materialIndex) {
+        if (materialIndex < m_materialLastUsed.size()) {
+            m_materialLastUsed[materialIndex] = m_frame;
+        }
+    }
+
+    /*
+     * Evicts and reloads textures for the materials marked since the last call.
+     * Call once per frame, followed by updateMaterialBuffer().
+     */
+    void updateResidency();
+    ResidencyStats getResidencyStats() const;
+
+    // MATERIAL_HAS_* flags a material currently samples, the key of its G-buffer shader variant
+    uint32_t getTextureFlags(uint32_t materialIndex) const {
+        return materialIndex < m_materials.size() ? m_materials[materialIndex].textureFlags : 0;
+    }
+
     // Debug info
     size_t getMaterialCount() const { return m_materials.size(); }
     size_t getTextureCount() const { return m_textureCache.size(); }
@@ -89,11 +156,16 @@ private:
     MaterialManager(const MaterialManager&) = delete;
     MaterialManager& operator=(const MaterialManager&) = delete;
 
-    // Load a texture by filepath and return its handle (with deduplication)
-    GLuint64 getTextureHandle(const std::string& filePath);
+    // Load a texture by filepath (with deduplication).
+    // With async loading a new texture returns nullptr and materialIndex is patched once it arrives.
+    const Texture* getTexture(const std::string& filePath, uint32_t materialIndex, uint32_t textureFlag);
 
     // Convert MaterialDefinition to MaterialData
-    MaterialData createMaterialData(const MaterialDefinition& def);
+    MaterialData createMaterialData(const MaterialDefinition& def, uint32_t materialIndex);
+
+    // Sets the handle and flag of a slot, plus MATERIAL_NORMAL_MAP_XY for BC5 normal maps
+    static void setTexture(MaterialData& data, uint32_t textureFlag, const Texture& texture);
+    static void clearTexture(MaterialData& data, uint32_t textureFlag);
 
     // GPU storage
     GLuint m_materialSSBO = 0;
@@ -103,8 +175,42 @@ private:
     // Material deduplication
     std::unordered_map<MaterialDefinition, uint32_t, MaterialDefinitionHash, MaterialDefinitionEqual> m_materialMap;
 
+    // Material slots sampling a texture: material index, MATERIAL_HAS_* flag
+    using TextureUsers = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    // Loaded texture with its residency state
+    struct CachedTexture {
+        std::shared_ptr<Texture> texture;   // Full mip chain, null while evicted
+        std::shared_ptr<Texture> mipTail;   // Sampled while evicted, null if the texture had none
+        std::future<TextureImage> reload;   // Decode of an evicted texture that is used again
+        TextureUsers users;
+        TextureUsage usage = TextureUsage::Data;
+        size_t size = 0;                    // Memory of the full texture, kept while evicted
+        uint64_t lastUsedFrame = 0;
+        bool reloadFailed = false;          // Stays on its mip tail
+    };
+
     // Texture deduplication - maps filepath to texture
-    std::unordered_map<std::string, std::shared_ptr<Texture>> m_textureCache;
+    std::unordered_map<std::string, CachedTexture> m_textureCache;
+
+    // Textures still decoding, with the material slots waiting on them
+    struct PendingTexture {
+        std::future<TextureImage> image;
+        TextureUsers users;
+    };
+    std::unordered_map<std::string, PendingTexture> m_pendingTextures;
+    bool m_asyncTextures = false;
+
+    CachedTexture& addTexture(const std::string& filePath, std::shared_ptr<Texture> texture, TextureUsage usage);
+    void evictTexture(CachedTexture& entry);
+    // Patches the users of a texture to its current state: full texture, mip tail or constants
+    void updateTextureUsers(const CachedTexture& entry);
+
+    // Residency, m_materialLastUsed runs parallel to m_materials
+    std::vector<uint64_t> m_materialLastUsed;
+    uint64_t m_frame = 1;
+    size_t m_residencyBudget = 0;
+    ResidencyStats m_residencyTotals;   // Only the totals are kept, the rest is counted on demand
 
     bool m_initialized = false;
     bool m_needsUpdate = false;
@@ -0,0 +1,199 @@
+#include "meshletCuller.h"
+#include "renderer.h"
+#include "debugging/profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    // DrawElementsIndirectCommand
+    constexpr size_t COMMAND_SIZE = 5 * sizeof(GLuint);
+
+    // Guaranteed minimum of GL_MAX_COMPUTE_WORK_GROUP_COUNT, larger job lists take several dispatches
+    constexpr size_t MAX_DISPATCH_GROUPS = 65535;
+
+    // Bindings of meshlet_cull.comp, the instances stay on 0 like in the draw shaders
+    constexpr GLuint INSTANCE_BINDING = 0;
+    constexpr GLuint MESHLET_BINDING = 4;
+    constexpr GLuint JOB_BINDING = 5;
+    constexpr GLuint COMMAND_BINDING = 6;
+    constexpr GLuint COUNT_BINDING = 7;
+}
+
+MeshletCuller::MeshletCuller() = default;
+
+MeshletCuller::~MeshletCuller() {
+    if (m_readbackFence) {
+        glDeleteSync(m_readbackFence);
+    }
+    GLuint buffers[] = {m_jobBuffer, m_commandBuffer, m_countBuffer, m_readbackBuffer};
+    for (GLuint buffer : buffers) {
+        if (buffer) {
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+}
+
+bool MeshletCuller::init() {
+    if (isReady()) {
+        return true;
+    }
+
+    // Core in 4.6, the count has to come from the GPU or culling would need a readback
+    if (glMultiDrawElementsIndirectCount == nullptr) {
+        std::cerr << "[Warning] MeshletCuller::init: glMultiDrawElementsIndirectCount is unavailable, meshes are culled whole\n";
+        return false;
+    }
+    if (!m_shader.load(ASSET_DIR "shaders/core/meshlet_cull.comp")) {
+        std::cerr << "[Error] MeshletCuller::init: Failed to load the cull shader, meshes are culled whole\n";
+        return false;
+    }
+
+    glGenBuffers(1, &m_jobBuffer);
+    glGenBuffers(1, &m_commandBuffer);
+    glGenBuffers(1, &m_countBuffer);
+    glGenBuffers(1, &m_readbackBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_readbackBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, COUNT_HEADER * sizeof(GLuint), nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return true;
+}
+
+void MeshletCuller::clear() {
+    m_groups.clear();
+    m_jobs.clear();
+    m_commandCount = 0;
+    m_testedMeshlets = 0;
+}
+
+size_t MeshletCuller::addGroup(size_t meshId, GLuint baseInstance, GLuint instanceCount, Renderer& renderer) {
+    uint32_t meshletCount = renderer.getMeshletCount(meshId);
+    uint32_t firstMeshlet = renderer.getFirstMeshlet(meshId);
+
+    size_t groupIndex = m_groups.size();
+    m_groups.push_back({meshId, m_commandCount, meshletCount * instanceCount});
+    for (GLuint instance = 0; instance < instanceCount; ++instance) {
+        m_jobs.push_back({baseInstance + instance, firstMeshlet, meshletCount, static_cast<uint32_t>(groupIndex), m_commandCount});
+    }
+    m_commandCount += meshletCount * instanceCount;
+    m_testedMeshlets += static_cast<uint64_t>(meshletCount) * instanceCount;
+    return groupIndex;
+}
+
+void MeshletCuller::cull(Renderer& renderer, GLuint instanceBuffer, const glm::mat4& viewProjection, const glm::vec3& viewPosition) {
+    PROFILE_SCOPE("MeshletCuller::cull");
+    readStatistics();
+    if (m_groups.empty() || !isReady()) {
+        return;
+    }
+
+    reserveBuffer(m_jobBuffer, m_jobCapacity, m_jobs.size(), sizeof(Job));
+    reserveBuffer(m_commandBuffer, m_commandCapacity, m_commandCount, COMMAND_SIZE);
+    reserveBuffer(m_countBuffer, m_countCapacity, COUNT_HEADER + m_groups.size(), sizeof(GLuint));
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_jobBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(m_jobs.size() * sizeof(Job)), m_jobs.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_countBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, instanceBuffer);
+    renderer.bindMeshletBuffer(MESHLET_BINDING);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, JOB_BINDING, m_jobBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, m_commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNT_BINDING, m_countBuffer);
+
+    m_shader.use();
+    std::array<glm::vec4, 6> planes = extractFrustumPlanes(viewProjection);
+    for (size_t i = 0; i < planes.size(); ++i) {
+        m_shader.setVec4("u_FrustumPlanes[" + std::to_string(i) + "]", planes[i]);
+    }
+    m_shader.setVec3("u_ViewPos", viewPosition);
+    m_shader.setUInt("u_JobCount", static_cast<GLuint>(m_jobs.size()));
+    for (size_t offset = 0; offset < m_jobs.size(); offset += MAX_DISPATCH_GROUPS) {
+        m_shader.setUInt("u_JobOffset", static_cast<GLuint>(offset));
+        m_shader.dispatchCompute(static_cast<GLuint>(std::min(m_jobs.size() - offset, MAX_DISPATCH_GROUPS)), 1, 1);
+    }
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // Statistics of this cull, unless an older copy is still in flight
+    if (!m_readbackFence) {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_countBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_readbackBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, COUNT_HEADER * sizeof(GLuint));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        m_readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    for (GLuint binding : {JOB_BINDING, COMMAND_BINDING, COUNT_BINDING}) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+    }
+}
+
+void MeshletCuller::draw(Renderer& renderer, size_t begin, size_t end, MeshVertexStream stream) {
+    end = std::min(end, m_groups.size());
+    if (begin >= end || !isReady()) {
+        return;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBindBuffer(GL_PARAMETER_BUFFER, m_countBuffer);
+    for (size_t i = begin; i < end; ++i) {
+        const Group& group = m_groups[i];
+        glBindVertexArray(renderer.getMeshVAO(group.meshId, stream));
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                         reinterpret_cast<const void*>(group.firstCommand * COMMAND_SIZE),
+                                         static_cast<GLintptr>((COUNT_HEADER + i) * sizeof(GLuint)),
+                                         static_cast<GLsizei>(group.maxDrawCount), COMMAND_SIZE);
+    }
+    glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+std::array<glm::vec4, 6> MeshletCuller::extractFrustumPlanes(const glm::mat4& viewProjection) {
+    // Gribb & Hartmann, rows of the matrix added to and subtracted from the w row
+    glm::vec4 rows[4];
+    for (int row = 0; row < 4; ++row) {
+        rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+    }
+    std::array<glm::vec4, 6> planes = {
+        rows[3] + rows[0], rows[3] - rows[0],
+        rows[3] + rows[1], rows[3] - rows[1],
+        rows[3] + rows[2], rows[3] - rows[2],
+    };
+    for (glm::vec4& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+}
+
+void MeshletCuller::reserveBuffer(GLuint buffer, size_t& capacity, size_t required, size_t elementSize) {
+    if (required <= capacity) {
+        return;
+    }
+    capacity = required * 3 / 2;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(capacity * elementSize), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void MeshletCuller::readStatistics() {
+    if (!m_readbackFence) {
+        return;
+    }
+    GLenum status = glClientWaitSync(m_readbackFence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return;
+    }
+    glDeleteSync(m_readbackFence);
+    m_readbackFence = nullptr;
+
+    GLuint header[COUNT_HEADER] = {};
+    glBindBuffer(GL_COPY_READ_BUFFER, m_readbackBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(header), header);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    m_visibleTriangles = header[0];
+    m_visibleMeshlets = header[1];
+}
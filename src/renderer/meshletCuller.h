@@ -0,0 +1,94 @@
+#pragma once
+
+#include "computeshader.h"
+#include "../components/mesh.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+// Forward declaration
+class Renderer;
+
+/*
+ * GPU culling of meshlets (see MeshletBuilder) for RenderBatch.
+ *
+ * Every group is one mesh drawn for a range of instances. A compute pass
+ * tests each meshlet of each instance against the view frustum and its
+ * normal cone, and appends the visible ones to the group's region of the
+ * command buffer as single instance draws. The groups are then drawn with
+ * glMultiDrawElementsIndirectCount, the draw counts never leave the GPU.
+ *
+ * Visible totals are read back through a fence a frame or more later, so
+ * the statistics never stall the pipeline.
+ */
+class MeshletCuller {
+public:
+    MeshletCuller();
+    ~MeshletCuller();
+
+    // Compiles the cull shader, false when it or indirect count draws aren't available
+    bool init();
+    bool isReady() const { return m_shader.isValid(); }
+
+    void clear();
+    // Draws [baseInstance, baseInstance + instanceCount) of the mesh, @return the group index
+    size_t addGroup(size_t meshId, GLuint baseInstance, GLuint instanceCount, Renderer& renderer);
+    size_t getGroupCount() const { return m_groups.size(); }
+
+    // Runs the cull pass, instanceBuffer holds the instances the groups refer to
+    void cull(Renderer& renderer, GLuint instanceBuffer, const glm::mat4& viewProjection, const glm::vec3& viewPosition);
+    // Draws groups [begin, end) of the last cull()
+    void draw(Renderer& renderer, size_t begin, size_t end, MeshVertexStream stream);
+
+    // Meshlets tested by the last cull()
+    uint64_t getTestedMeshletCount() const { return m_testedMeshlets; }
+    // Of the latest cull the GPU finished
+    uint32_t getVisibleMeshletCount() const { return m_visibleMeshlets; }
+    uint64_t getVisibleTriangleCount() const { return m_visibleTriangles; }
+
+    // World space planes (normal, distance) of a view-projection matrix, pointing inwards
+    static std::array<glm::vec4, 6> extractFrustumPlanes(const glm::mat4& viewProjection);
+
+private:
+    // std430 layout of CullJob in meshlet_cull.comp
+    struct Job {
+        uint32_t instance;
+        uint32_t firstMeshlet;
+        uint32_t meshletCount;
+        uint32_t group;
+        uint32_t firstCommand;
+    };
+
+    struct Group {
+        size_t meshId;
+        uint32_t firstCommand;
+        uint32_t maxDrawCount;
+    };
+
+    // Ahead of the draw counts in the count buffer: visible triangles, visible meshlets
+    static constexpr size_t COUNT_HEADER = 2;
+
+    ComputeShader m_shader;
+    std::vector<Group> m_groups;
+    std::vector<Job> m_jobs;
+    uint32_t m_commandCount = 0;
+    uint64_t m_testedMeshlets = 0;
+
+    GLuint m_jobBuffer = 0;
+    GLuint m_commandBuffer = 0;
+    GLuint m_countBuffer = 0;
+    size_t m_jobCapacity = 0;
+    size_t m_commandCapacity = 0;
+    size_t m_countCapacity = 0;
+
+    // Copy of the count header, read once its fence signals
+    GLuint m_readbackBuffer = 0;
+    GLsync m_readbackFence = nullptr;
+    uint32_t m_visibleMeshlets = 0;
+    uint64_t m_visibleTriangles = 0;
+
+    void reserveBuffer(GLuint buffer, size_t& capacity, size_t required, size_t elementSize);
+    void readStatistics();
+};
@@ -0,0 +1,132 @@
+#include "mipGenerator.h"
+#include "texture.h"
+#include "../debugging/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define MIP_GENERATOR_SSE2
+#endif
+
+namespace {
+    // 12 bits keep the round trip of every 8 bit sRGB value exact
+    constexpr int LINEAR_TO_SRGB_SIZE = 4096;
+
+    struct SRGBTables {
+        float toLinear[256];
+        uint8_t toSRGB[LINEAR_TO_SRGB_SIZE];
+
+        SRGBTables() {
+            for (int i = 0; i < 256; ++i) {
+                float c = i / 255.0f;
+                toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i < LINEAR_TO_SRGB_SIZE; ++i) {
+                float l = i / static_cast<float>(LINEAR_TO_SRGB_SIZE - 1);
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                toSRGB[i] = static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    };
+
+    const SRGBTables& getSRGBTables() {
+        static const SRGBTables tables;
+        return tables;
+    }
+}
+
+int MipGenerator::getLevelCount(int width, int height) {
+    int levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+void MipGenerator::downsample(const unsigned char* src, int srcWidth, int srcHeight, int channels,
+                              bool isSRGB, unsigned char* dst) {
+    const int dstWidth = std::max(1, srcWidth / 2);
+    const int dstHeight = std::max(1, srcHeight / 2);
+    const size_t srcStride = static_cast<size_t>(srcWidth) * channels;
+    const size_t dstStride = static_cast<size_t>(dstWidth) * channels;
+    const int alphaChannel = (channels == 2 || channels == 4) ? channels - 1 : -1;
+    const SRGBTables* tables = isSRGB ? &getSRGBTables() : nullptr;
+
+    for (int y = 0; y < dstHeight; ++y) {
+        const unsigned char* row0 = src + static_cast<size_t>(std::min(2 * y, srcHeight - 1)) * srcStride;
+        const unsigned char* row1 = src + static_cast<size_t>(std::min(2 * y + 1, srcHeight - 1)) * srcStride;
+        unsigned char* dstRow = dst + static_cast<size_t>(y) * dstStride;
+        int x = 0;
+
+#ifdef MIP_GENERATOR_SSE2
+        // RGBA in linear space, two output pixels from four source pixels per row
+        if (!isSRGB && channels == 4) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i rounding = _mm_set1_epi16(2);
+            for (; x + 2 <= dstWidth; x += 2) {
+                __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+                __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+
+                // Vertical sums, 16 bits per channel
+                __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+                // Horizontal pairs sit in the low and high halves
+                left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+                right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+
+                __m128i sum = _mm_unpacklo_epi64(left, right);
+                sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dstRow + x * 4), _mm_packus_epi16(sum, zero));
+            }
+        }
+#endif
+
+        for (; x < dstWidth; ++x) {
+            const size_t x0 = static_cast<size_t>(2 * x) * channels;
+            const size_t x1 = static_cast<size_t>(std::min(2 * x + 1, srcWidth - 1)) * channels;
+            unsigned char* out = dstRow + static_cast<size_t>(x) * channels;
+
+            for (int c = 0; c < channels; ++c) {
+                if (tables && c != alphaChannel) {
+                    float linear = (tables->toLinear[row0[x0 + c]] + tables->toLinear[row0[x1 + c]] +
+                                    tables->toLinear[row1[x0 + c]] + tables->toLinear[row1[x1 + c]]) * 0.25f;
+                    out[c] = tables->toSRGB[static_cast<int>(linear * (LINEAR_TO_SRGB_SIZE - 1) + 0.5f)];
+                } else {
+                    out[c] = static_cast<unsigned char>(
+                        (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+                }
+            }
+        }
+    }
+}
+
+void MipGenerator::generateMipChain(TextureImage& image) {
+    image.mipLevels.clear();
+    if (!image.isValid()) {
+        return;
+    }
+    PROFILE_SCOPE("MipGenerator::generateMipChain");
+
+    int width = image.width;
+    int height = image.height;
+    const unsigned char* src = image.pixels;
+
+    image.mipLevels.resize(getLevelCount(width, height) - 1);
+    for (std::vector<unsigned char>& level : image.mipLevels) {
+        int levelWidth = std::max(1, width / 2);
+        int levelHeight = std::max(1, height / 2);
+        level.resize(static_cast<size_t>(levelWidth) * levelHeight * image.channels);
+
+        downsample(src, width, height, image.channels, image.isSRGB, level.data());
+
+        src = level.data();
+        width = levelWidth;
+        height = levelHeight;
+    }
+}
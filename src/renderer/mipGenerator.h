@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+struct TextureImage;
+
+/*
+ * CPU mip chain generation, so textures can be decoded and filtered on job
+ * system workers and uploaded level by level instead of via glGenerateMipmap.
+ *
+ * Each level is a 2x2 box filter of the previous one. sRGB images (albedo,
+ * emissive) are averaged in linear space and re-encoded, alpha is always
+ * averaged as is. Odd sizes follow OpenGL's floor rule.
+ */
+namespace MipGenerator {
+    // Fills image.mipLevels with levels 1..n down to 1x1
+    void generateMipChain(TextureImage& image);
+
+    /*
+     * Downsamples one level.
+     * @param dst - Holds max(1, srcWidth / 2) * max(1, srcHeight / 2) * channels bytes.
+     */
+    void downsample(const unsigned char* src, int srcWidth, int srcHeight, int channels,
+                    bool isSRGB, unsigned char* dst);
+
+    // Number of levels including the base level
+    int getLevelCount(int width, int height);
+}
@@ -1,7 +1,10 @@
 #include "renderBatch.h"
 #include "renderer.h"
+#include "debugging/profiler.h"
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <tuple>
 
 RenderBatch::RenderBatch(size_t initialCapacity) {
     m_instances.reserve(initialCapacity);
@@ -19,65 +22,243 @@ void RenderBatch::addInstance(const RenderInstance& instance) {
     m_instances.push_back(instance);
 }
 
+void RenderBatch::addInstanceRange(const Mesh& mesh, const glm::mat4* matrices, const uint8_t* lodLevels, size_t count,
+                                   uint32_t permutation) {
+    if (count > 0) {
+        m_ranges.push_back({mesh, matrices, lodLevels, count, permutation});
+    }
+}
+
 void RenderBatch::prepare(Renderer& renderer) {
-    // Clear both command vectors
-    m_elementsCommands.clear();
-    m_arraysCommands.clear();
+    PROFILE_SCOPE("RenderBatch::prepare");
+
     m_objectData.clear();
+    m_triangleCount = 0;
+    m_lodInstances.fill(0);
+    m_impostorInstances = 0;
+    m_commandsRebuilt = false;
+    if (m_meshletCulling) {
+        m_meshletCuller->clear();
+    }
 
-    if (m_instances.empty()) return;
+    if (m_instances.empty() && m_ranges.empty()) {
+        m_drawGroups.clear();
+        m_permutations.clear();
+        m_runs.clear();
+        return;
+    }
 
-    // Group instances by mesh ID for batching
-    std::map<GLuint, std::vector<size_t>> meshGroups;
+    // Group instances by permutation, then by mesh ID and detail level for batching.
+    // Ranges join the groups of their levels whole instead of instance by instance.
+    struct MeshGroup {
+        const Mesh* mesh = nullptr;
+        std::vector<size_t> instances;
+        std::vector<size_t> ranges;
+        GLuint rangeInstances = 0;
+    };
+    std::map<GroupKey, MeshGroup> meshGroups;
     for (size_t i = 0; i < m_instances.size(); ++i) {
         GLuint meshId = static_cast<GLuint>(m_instances[i].mesh.id);
-        meshGroups[meshId].push_back(i);
+        uint32_t lod = std::min<uint32_t>(m_instances[i].lod, MESH_MAX_LODS - 1);
+        MeshGroup& group = meshGroups[{m_instances[i].permutation, meshId, lod}];
+        group.mesh = &m_instances[i].mesh;
+        group.instances.push_back(i);
     }
+    size_t instanceTotal = m_instances.size();
+    for (size_t r = 0; r < m_ranges.size(); ++r) {
+        const InstanceRange& range = m_ranges[r];
+        std::array<GLuint, IMPOSTOR_LEVEL + 1> levelCounts{};
+        if (range.lodLevels) {
+            for (size_t i = 0; i < range.count; ++i) {
+                levelCounts[getRangeLevel(range.lodLevels[i])]++;
+            }
+        } else {
+            levelCounts[0] = static_cast<GLuint>(range.count);
+        }
+        for (uint32_t level = 0; level <= IMPOSTOR_LEVEL; ++level) {
+            if (levelCounts[level] == 0) {
+                continue;
+            }
+            uint32_t permutation = level == IMPOSTOR_LEVEL ? IMPOSTOR_PERMUTATION : range.permutation;
+            MeshGroup& group = meshGroups[{permutation, static_cast<GLuint>(range.mesh.id), level}];
+            group.mesh = &range.mesh;
+            group.ranges.push_back(r);
+            group.rangeInstances += levelCounts[level];
+        }
+        instanceTotal += range.count;
+    }
+    m_objectData.reserve(instanceTotal);
 
-    // Build draw commands and object data for each mesh group
+    // The cached commands hold as long as the groups line up with the last build
+    bool rebuild = !m_commandsValid || m_meshVersion != renderer.getMeshVersion() || m_drawGroups.size() != meshGroups.size();
+    if (!rebuild) {
+        size_t groupIndex = 0;
+        for (const auto& [groupKey, group] : meshGroups) {
+            if (!matchesDrawGroup(m_drawGroups[groupIndex++], groupKey, *group.mesh)) {
+                rebuild = true;
+                break;
+            }
+        }
+    }
+    if (rebuild) {
+        m_elementsCommands.clear();
+        m_arraysCommands.clear();
+        m_drawGroups.clear();
+        m_permutations.clear();
+        m_meshVersion = renderer.getMeshVersion();
+        m_commandsValid = true;
+        m_commandsDirty = true;
+        m_commandsRebuilt = true;
+    }
+
+    // Patch instance ranges into the commands and gather object data for each mesh group
     GLuint currentBaseInstance = 0;
-    for (const auto& [meshId, instanceIndices] : meshGroups) {
-        const Mesh& mesh = m_instances[instanceIndices[0]].mesh;
-        GLuint instanceCount = static_cast<GLuint>(instanceIndices.size());
+    size_t groupIndex = 0;
+    for (const auto& [groupKey, group] : meshGroups) {
+        const Mesh& mesh = *group.mesh;
+        if (rebuild) {
+            uint32_t permutationKey = std::get<0>(groupKey);
+            if (m_permutations.empty() || m_permutations.back().key != permutationKey) {
+                size_t meshletGroups = m_meshletCulling ? m_meshletCuller->getGroupCount() : 0;
+                m_permutations.push_back({permutationKey, groupIndex, groupIndex, 0, 0, meshletGroups, meshletGroups});
+            }
+            m_drawGroups.push_back(buildDrawGroup(groupKey, mesh, renderer));
+            m_permutations.back().groupsEnd = groupIndex + 1;
+        }
+        const DrawGroup& drawGroup = m_drawGroups[groupIndex++];
+
+        uint32_t lod = std::get<2>(groupKey);
+        GLuint instanceCount = static_cast<GLuint>(group.instances.size()) + group.rangeInstances;
+        if (lod == IMPOSTOR_LEVEL) {
+            m_impostorInstances += instanceCount;
+        } else {
+            m_lodInstances[lod] += instanceCount;
+        }
+        m_triangleCount += static_cast<uint64_t>(drawGroup.trianglesPerInstance) * instanceCount;
 
-        // Build draw command with proper instance count
-        buildDrawCommand(mesh, renderer, currentBaseInstance, instanceCount);
+        if (drawGroup.type == DrawType::Elements) {
+            DrawElementsIndirectCommand& cmd = m_elementsCommands[drawGroup.command];
+            m_commandsDirty |= cmd.instanceCount != instanceCount || cmd.baseInstance != currentBaseInstance;
+            cmd.instanceCount = instanceCount;
+            cmd.baseInstance = currentBaseInstance;
+        } else if (drawGroup.type == DrawType::Arrays) {
+            DrawArraysIndirectCommand& cmd = m_arraysCommands[drawGroup.command];
+            m_commandsDirty |= cmd.instanceCount != instanceCount || cmd.baseInstance != currentBaseInstance;
+            cmd.instanceCount = instanceCount;
+            cmd.baseInstance = currentBaseInstance;
+        } else if (drawGroup.type == DrawType::Meshlets) {
+            // Jobs are per instance, the cull rebuilds its commands every frame anyway
+            m_meshletCuller->addGroup(mesh.id, currentBaseInstance, instanceCount, renderer);
+            if (rebuild) {
+                m_permutations.back().meshletGroupsEnd = m_meshletCuller->getGroupCount();
+            }
+        }
 
-        // Convert instances to GPU format
-        for (size_t instanceIdx : instanceIndices) {
+        // Convert instances to GPU format, range matrices are copied as they are
+        for (size_t instanceIdx : group.instances) {
             m_objectData.push_back(m_instances[instanceIdx].toGPUInstance());
         }
+        for (size_t r : group.ranges) {
+            const InstanceRange& range = m_ranges[r];
+            DrawInstance gpu;
+            gpu.uvScale = glm::vec2(1.0f);
+            gpu.materialId = range.mesh.materialIndex;
+            gpu.meshId = static_cast<uint32_t>(range.mesh.id);
+            for (size_t i = 0; i < range.count; ++i) {
+                if (range.lodLevels && getRangeLevel(range.lodLevels[i]) != lod) {
+                    continue;
+                }
+                gpu.modelMatrix = range.matrices[i];
+                m_objectData.push_back(gpu);
+            }
+        }
 
         currentBaseInstance += instanceCount;
     }
 
+    if (rebuild) {
+        buildRuns(renderer);
+    }
     updateBuffers();
 }
 
 void RenderBatch::render(Renderer& renderer) {
-    if (m_elementsCommands.empty() && m_arraysCommands.empty()) {
+    size_t meshletGroups = m_meshletCulling ? m_meshletCuller->getGroupCount() : 0;
+    if (m_runs.empty() && meshletGroups == 0) {
         return;
     }
 
-    // Bind SSBO once for the entire batch
+    // Bind SSBO once for the entire batch, mesh bounds dequantize compact positions
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_drawInstanceSSBO);
+    renderer.bindMeshBuffer(3);
 
-    // Render elements commands if any
-    if (!m_elementsCommands.empty()) {
-        renderer.executeIndirectDraw(m_elementsCommands, m_elementsIndirectBuffer);
+    renderer.executeIndirectDraw(m_runs, 0, m_runs.size(), m_elementsIndirectBuffer, m_arraysIndirectBuffer);
+    if (meshletGroups > 0) {
+        m_meshletCuller->draw(renderer, 0, meshletGroups, m_vertexStream);
     }
 
-    // Render arrays commands if any
-    if (!m_arraysCommands.empty()) {
-        renderer.executeIndirectDraw(m_arraysCommands, m_arraysIndirectBuffer);
+    // Unbind SSBO after rendering
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+}
+
+void RenderBatch::render(Renderer& renderer, size_t permutationIndex) {
+    const Permutation& permutation = m_permutations[permutationIndex];
+    if (permutation.runsBegin == permutation.runsEnd && permutation.meshletGroupsBegin == permutation.meshletGroupsEnd) {
+        return;
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_drawInstanceSSBO);
+    renderer.bindMeshBuffer(3);
+
+    renderer.executeIndirectDraw(m_runs, permutation.runsBegin, permutation.runsEnd, m_elementsIndirectBuffer,
+                                 m_arraysIndirectBuffer);
+    if (permutation.meshletGroupsBegin != permutation.meshletGroupsEnd) {
+        m_meshletCuller->draw(renderer, permutation.meshletGroupsBegin, permutation.meshletGroupsEnd, m_vertexStream);
     }
 
-    // Unbind SSBO after rendering
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
 }
 
+void RenderBatch::setVertexStream(MeshVertexStream stream) {
+    // The runs hold the VAOs of the stream
+    m_commandsValid &= stream == m_vertexStream;
+    m_vertexStream = stream;
+}
+
+void RenderBatch::setImpostors(bool enabled) {
+    m_commandsValid &= enabled == m_impostors;
+    m_impostors = enabled;
+}
+
+void RenderBatch::setMeshletCulling(bool enabled) {
+    if (enabled && !m_meshletCuller) {
+        m_meshletCuller = std::make_unique<MeshletCuller>();
+        m_meshletCuller->init();
+    }
+    bool culling = enabled && m_meshletCuller->isReady();
+    m_commandsValid &= culling == m_meshletCulling;
+    m_meshletCulling = culling;
+}
+
+void RenderBatch::cullMeshlets(Renderer& renderer, const glm::mat4& viewProjection, const glm::vec3& viewPosition) {
+    if (m_meshletCulling) {
+        m_meshletCuller->cull(renderer, m_drawInstanceSSBO, viewProjection, viewPosition);
+    }
+}
+
+bool RenderBatch::isMeshletCulled(const Mesh& mesh, uint32_t lod, Renderer& renderer) const {
+    // Meshlets cover the full detail level, so only draws of exactly that range qualify
+    if (!m_meshletCulling || renderer.getMeshletCount(mesh.id) == 0 || mesh.drawMode != GL_TRIANGLES ||
+        (lod > 0 && renderer.getMeshLodCount(mesh.id) > 1)) {
+        return false;
+    }
+    MeshLodRange fullDetail = renderer.getMeshLod(mesh.id, 0);
+    return mesh.firstIndex == fullDetail.firstIndex && mesh.baseVertex == 0 && (mesh.count == 0 || mesh.count == fullDetail.indexCount);
+}
+
 void RenderBatch::clear() {
     m_instances.clear();
+    m_ranges.clear();
 }
 
 void RenderBatch::initBuffers(size_t capacity) {
@@ -111,26 +292,8 @@ void RenderBatch::initBuffers(size_t capacity) {
 }
 
 void RenderBatch::updateBuffers() {
-    // Handle elements buffer resizing
-    if (m_elementsCommands.size() > m_elementsBufferCapacity) {
-        size_t newCapacity = m_elementsCommands.size() * 3 / 2;
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_elementsIndirectBuffer);
-        glBufferData(GL_DRAW_INDIRECT_BUFFER,
-                     newCapacity * sizeof(DrawElementsIndirectCommand),
-                     nullptr, GL_DYNAMIC_DRAW);
-        m_elementsBufferCapacity = newCapacity;
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
-    }
-
-    // Handle arrays buffer resizing
-    if (m_arraysCommands.size() > m_arraysBufferCapacity) {
-        size_t newCapacity = m_arraysCommands.size() * 3 / 2;
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_arraysIndirectBuffer);
-        glBufferData(GL_DRAW_INDIRECT_BUFFER,
-                     newCapacity * sizeof(DrawArraysIndirectCommand),
-                     nullptr, GL_DYNAMIC_DRAW);
-        m_arraysBufferCapacity = newCapacity;
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    if (m_commandsDirty) {
+        uploadCommands();
     }
 
     // Handle instance data buffer resizing
@@ -155,37 +318,122 @@ void RenderBatch::updateBuffers() {
     }
 }
 
-void RenderBatch::buildDrawCommand(const Mesh& mesh, Renderer& renderer, GLuint baseInstance, GLuint instanceCount) {
-    IndirectDrawCommand cmd;
-    cmd.meshId = static_cast<GLuint>(mesh.id);
-    cmd.useIndices = renderer.hasMeshIndices(mesh.id);
+void RenderBatch::uploadCommands() {
+    // Handle elements buffer resizing
+    if (m_elementsCommands.size() > m_elementsBufferCapacity) {
+        size_t newCapacity = m_elementsCommands.size() * 3 / 2;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_elementsIndirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                     newCapacity * sizeof(DrawElementsIndirectCommand),
+                     nullptr, GL_DYNAMIC_DRAW);
+        m_elementsBufferCapacity = newCapacity;
+    }
 
-    if (cmd.useIndices) {
+    // Handle arrays buffer resizing
+    if (m_arraysCommands.size() > m_arraysBufferCapacity) {
+        size_t newCapacity = m_arraysCommands.size() * 3 / 2;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_arraysIndirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                     newCapacity * sizeof(DrawArraysIndirectCommand),
+                     nullptr, GL_DYNAMIC_DRAW);
+        m_arraysBufferCapacity = newCapacity;
+    }
+
+    if (!m_elementsCommands.empty()) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_elementsIndirectBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+                        static_cast<GLsizeiptr>(m_elementsCommands.size() * sizeof(DrawElementsIndirectCommand)),
+                        m_elementsCommands.data());
+    }
+    if (!m_arraysCommands.empty()) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_arraysIndirectBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+                        static_cast<GLsizeiptr>(m_arraysCommands.size() * sizeof(DrawArraysIndirectCommand)),
+                        m_arraysCommands.data());
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    m_commandsDirty = false;
+}
+
+RenderBatch::DrawGroup RenderBatch::buildDrawGroup(const GroupKey& key, const Mesh& mesh, Renderer& renderer) {
+    DrawGroup group{key, mesh.count, mesh.firstIndex, mesh.baseVertex, DrawType::None, 0, 0};
+    uint32_t lod = std::get<2>(key);
+
+    if (lod == IMPOSTOR_LEVEL) {
+        // The quad comes from gl_VertexID, the mesh's VAO is bound along but none of its vertices are read
+        DrawArraysIndirectCommand cmd{6, 0, 0, 0};
+        group.type = DrawType::Arrays;
+        group.command = m_arraysCommands.size();
+        group.trianglesPerInstance = 2;
+        m_arraysCommands.push_back(cmd);
+    } else if (isMeshletCulled(mesh, lod, renderer)) {
+        group.type = DrawType::Meshlets;
+    } else if (renderer.hasMeshIndices(mesh.id)) {
         GLsizei actualIndexCount = renderer.getMeshIndexCount(mesh.id);
         if (actualIndexCount == 0) {
-            return;
+            return group;
         }
 
-        cmd.elements.count = (mesh.count > 0) ? mesh.count : actualIndexCount;
-        cmd.elements.instanceCount = instanceCount;
-        cmd.elements.firstIndex = mesh.firstIndex;
-        cmd.elements.baseVertex = mesh.baseVertex;
-        cmd.elements.baseInstance = baseInstance;
+        DrawElementsIndirectCommand cmd{};
+        cmd.count = (mesh.count > 0) ? mesh.count : actualIndexCount;
+        cmd.firstIndex = mesh.firstIndex;
+        cmd.baseVertex = mesh.baseVertex;
 
+        // Coarser levels replace the full detail range, meshes drawing a custom range keep it
+        if (lod > 0 && mesh.firstIndex == 0 && cmd.count == renderer.getMeshLod(mesh.id, 0).indexCount) {
+            MeshLodRange range = renderer.getMeshLod(mesh.id, lod);
+            cmd.firstIndex = range.firstIndex;
+            cmd.count = range.indexCount;
+        }
+
+        group.type = DrawType::Elements;
+        group.command = m_elementsCommands.size();
+        group.trianglesPerInstance = cmd.count / 3;
         m_elementsCommands.push_back(cmd);
     } else {
         GLsizei actualVertexCount = renderer.getMeshVertexCount(mesh.id);
         if (actualVertexCount == 0) {
-            return;
+            return group;
         }
 
-        cmd.arrays.count = (mesh.count > 0) ? mesh.count : actualVertexCount;
-        cmd.arrays.instanceCount = instanceCount;
-        cmd.arrays.first = mesh.firstIndex;
-        cmd.arrays.baseInstance = baseInstance;
+        DrawArraysIndirectCommand cmd{};
+        cmd.count = (mesh.count > 0) ? mesh.count : actualVertexCount;
+        cmd.first = mesh.firstIndex;
 
+        group.type = DrawType::Arrays;
+        group.command = m_arraysCommands.size();
+        group.trianglesPerInstance = cmd.count / 3;
         m_arraysCommands.push_back(cmd);
     }
+    return group;
+}
+
+void RenderBatch::buildRuns(Renderer& renderer) {
+    // A run draws a contiguous range of commands, skipped groups and VAO changes start a new one
+    m_runs.clear();
+    for (Permutation& permutation : m_permutations) {
+        permutation.runsBegin = m_runs.size();
+        for (DrawType type : {DrawType::Elements, DrawType::Arrays}) {
+            bool indexed = type == DrawType::Elements;
+            for (size_t i = permutation.groupsBegin; i < permutation.groupsEnd; ++i) {
+                const DrawGroup& group = m_drawGroups[i];
+                if (group.type != type) {
+                    continue;
+                }
+                GLuint vao = renderer.getMeshVAO(std::get<1>(group.key), m_vertexStream);
+                if (vao == 0) {
+                    continue;
+                }
+                IndirectDrawRun* run = m_runs.size() > permutation.runsBegin ? &m_runs.back() : nullptr;
+                if (run && run->vao == vao && run->indexed == indexed && run->first + run->count == group.command) {
+                    run->count++;
+                } else {
+                    m_runs.push_back({vao, indexed, group.command, 1});
+                }
+            }
+        }
+        permutation.runsEnd = m_runs.size();
+    }
 }
 
 void RenderBatch::cleanup() {
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "../components/mesh.h"
+#include "meshletCuller.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
 #include <memory>
+#include <tuple>
 #include <vector>
-#include <cstring>
 #include <iostream>
 
 // Forward declaration
@@ -26,17 +29,12 @@ struct DrawArraysIndirectCommand {
     GLuint baseInstance;
 };
 
-struct IndirectDrawCommand {
-    union {
-        DrawElementsIndirectCommand elements;
-        DrawArraysIndirectCommand arrays;
-    };
-    size_t meshId;
-    bool useIndices;
-
-    IndirectDrawCommand() : meshId(0), useIndices(false) {
-        std::memset(&elements, 0, sizeof(elements));
-    }
+// Consecutive commands of one type drawn from one VAO with a single multi-draw
+struct IndirectDrawRun {
+    GLuint vao;
+    bool indexed;   // Elements or arrays commands
+    size_t first;   // Into the indirect buffer of its type
+    size_t count;
 };
 
 // GPU-side instance data
@@ -44,7 +42,7 @@ struct DrawInstance {
     glm::mat4 modelMatrix;
     glm::vec2 uvScale;
     uint32_t materialId;
-    uint32_t padding;
+    uint32_t meshId;        // Index into the renderer's mesh bounds
 };
 
 // CPU-side instance data with conversion capability
@@ -52,6 +50,8 @@ struct RenderInstance {
     Mesh mesh;
     glm::mat4 modelMatrix;
     glm::vec2 uvScale;
+    uint32_t permutation = 0;  // Shader variant key, instances are grouped by it
+    uint32_t lod = 0;          // Detail level, every level of a mesh gets its own command
 
     // Constructor for easy creation
     RenderInstance(const Mesh& m, const glm::mat4& matrix, const glm::vec2& uv = glm::vec2(1.0f))
@@ -63,7 +63,7 @@ struct RenderInstance {
         gpu.modelMatrix = modelMatrix;
         gpu.uvScale = uvScale;
         gpu.materialId = mesh.materialIndex;
-        gpu.padding = 0;
+        gpu.meshId = static_cast<uint32_t>(mesh.id);
         return gpu;
     }
 };
@@ -74,17 +74,108 @@ public:
     ~RenderBatch();
 
     void addInstance(const RenderInstance& instance);
+    // count instances of mesh, lodLevels may be null for full detail. The arrays must stay valid until prepare().
+    void addInstanceRange(const Mesh& mesh, const glm::mat4* matrices, const uint8_t* lodLevels, size_t count,
+                          uint32_t permutation = 0);
     void prepare(Renderer& renderer);
     void render(Renderer& renderer);
     void clear();
 
+    // Commands are grouped by permutation, passes switching programs draw one group at a time
+    size_t getPermutationCount() const { return m_permutations.size(); }
+    uint32_t getPermutation(size_t index) const { return m_permutations[index].key; }
+    void render(Renderer& renderer, size_t permutationIndex);
+
+    // Depth-only batches draw from the meshes' position streams
+    void setVertexStream(MeshVertexStream stream);
+
+    /*
+     * Full detail draws of meshes with meshlets are culled per meshlet on
+     * the GPU instead, call cullMeshlets() between prepare() and render().
+     * Stays off when the GPU can't do it.
+     */
+    void setMeshletCulling(bool enabled);
+    void cullMeshlets(Renderer& renderer, const glm::mat4& viewProjection, const glm::vec3& viewPosition);
+
+    /*
+     * Range members at MESH_IMPOSTOR_LEVEL are drawn as impostor quads, all
+     * of them under IMPOSTOR_PERMUTATION after every material permutation.
+     * Off, they are drawn at the coarsest level of their mesh instead.
+     */
+    static constexpr uint32_t IMPOSTOR_PERMUTATION = 1u << 31;
+    void setImpostors(bool enabled);
+
+    // Of the last prepare(), without the meshlet culled draws
+    uint64_t getTriangleCount() const { return m_triangleCount; }
+    uint32_t getLodInstanceCount(uint32_t level) const { return m_lodInstances[level]; }
+    uint32_t getImpostorInstanceCount() const { return m_impostorInstances; }
+    // Null while meshlet culling is off, its visible counts trail by a frame or more
+    const MeshletCuller* getMeshletCuller() const { return m_meshletCulling ? m_meshletCuller.get() : nullptr; }
+    // Whether the last prepare() had to rebuild the commands instead of patching them
+    bool commandsRebuilt() const { return m_commandsRebuilt; }
+
 private:
+    MeshVertexStream m_vertexStream = MeshVertexStream::Full;
+
+    // Draw group ranges of one permutation and the runs drawing them
+    struct Permutation {
+        uint32_t key;
+        size_t groupsBegin, groupsEnd;
+        size_t runsBegin, runsEnd;
+        size_t meshletGroupsBegin, meshletGroupsEnd;
+    };
+    std::vector<Permutation> m_permutations;
+
+    /*
+     * Commands are only rebuilt when the structure of the batch changes: the
+     * groups (permutation, mesh, level) and the ranges of their meshes, the
+     * meshes the renderer holds or the batch's settings. Otherwise prepare()
+     * patches instance counts and base instances into the cached commands and
+     * uploads them only if one of those changed.
+     */
+    using GroupKey = std::tuple<uint32_t, GLuint, uint32_t>;
+    enum class DrawType : uint8_t { None, Elements, Arrays, Meshlets };
+    struct DrawGroup {
+        GroupKey key;
+        uint32_t count, firstIndex, baseVertex;     // Of the mesh
+        DrawType type;
+        size_t command;                             // Into the command vector of its type
+        uint32_t trianglesPerInstance;              // 0 for meshlet culled groups
+    };
+    std::vector<DrawGroup> m_drawGroups;
+    std::vector<IndirectDrawRun> m_runs;
+    uint64_t m_meshVersion = 0;     // Of the renderer when the commands were built
+    bool m_commandsValid = false;
+    bool m_commandsDirty = false;
+    bool m_commandsRebuilt = false;
+
+    uint64_t m_triangleCount = 0;
+    std::array<uint32_t, MESH_MAX_LODS> m_lodInstances{};
+    uint32_t m_impostorInstances = 0;
+
+    // Group level of impostors, one past the last LOD
+    static constexpr uint32_t IMPOSTOR_LEVEL = MESH_MAX_LODS;
+    bool m_impostors = false;
+
+    bool m_meshletCulling = false;
+    std::unique_ptr<MeshletCuller> m_meshletCuller;
+
     std::vector<RenderInstance> m_instances;    // CPU-side data
+
+    // Added with addInstanceRange, split by detail level in prepare()
+    struct InstanceRange {
+        Mesh mesh;
+        const glm::mat4* matrices;
+        const uint8_t* lodLevels;
+        size_t count;
+        uint32_t permutation;
+    };
+    std::vector<InstanceRange> m_ranges;
     std::vector<DrawInstance> m_objectData;     // GPU-side data for SSBO
 
     // Separate command vectors for different draw types
-    std::vector<IndirectDrawCommand> m_elementsCommands;
-    std::vector<IndirectDrawCommand> m_arraysCommands;
+    std::vector<DrawElementsIndirectCommand> m_elementsCommands;
+    std::vector<DrawArraysIndirectCommand> m_arraysCommands;
 
     // Separate buffers for different command types
     GLuint m_elementsIndirectBuffer = 0;
@@ -98,6 +189,19 @@ private:
 
     void initBuffers(size_t capacity);
     void updateBuffers();
-    void buildDrawCommand(const Mesh& mesh, Renderer& renderer, GLuint baseInstance, GLuint instanceCount);
+    void uploadCommands();
+    // Adds the group's command with no instances, prepare() patches them in
+    DrawGroup buildDrawGroup(const GroupKey& key, const Mesh& mesh, Renderer& renderer);
+    bool matchesDrawGroup(const DrawGroup& group, const GroupKey& key, const Mesh& mesh) const {
+        return group.key == key && group.count == mesh.count && group.firstIndex == mesh.firstIndex &&
+               group.baseVertex == mesh.baseVertex;
+    }
+    // Merges the commands of each permutation into runs, elements first, one per VAO
+    void buildRuns(Renderer& renderer);
+    // Group level of a range member
+    uint32_t getRangeLevel(uint8_t level) const {
+        return level == MESH_IMPOSTOR_LEVEL && m_impostors ? IMPOSTOR_LEVEL : std::min<uint32_t>(level, MESH_MAX_LODS - 1);
+    }
+    bool isMeshletCulled(const Mesh& mesh, uint32_t lod, Renderer& renderer) const;
     void cleanup();
 };
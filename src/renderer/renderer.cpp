@@ -1,7 +1,11 @@
 #include "renderer.h"
+#include "../resources/vertexQuantizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
-#define VERTEX_SIZE 8
+#define VERTEX_SIZE MESH_VERTEX_SIZE
 #define NUM_GATTACHMENTS 5
 
 Renderer::Renderer(config::GraphicsSettings settings) : config(settings) {
@@ -27,7 +31,7 @@ Renderer::~Renderer() {
 Mesh Renderer::initMeshBuffers(std::unique_ptr<RawMeshData>& rawData, bool isStatic) {
     static Mesh invalidMesh; // Return this for errors
 
-    if (rawData->uvs.empty() || rawData->packedTNBFrame.empty()) {
+    if (!rawData->isPacked() && (rawData->uvs.empty() || rawData->packedTNBFrame.empty())) {
         std::cerr << "[Error] Renderer::initMeshBuffers: UVs and tangent space must be provided.\n";
         return invalidMesh;
     }
@@ -36,71 +40,162 @@ Mesh Renderer::initMeshBuffers(std::unique_ptr<RawMeshData>& rawData, bool isSta
     glGenVertexArrays(1, &data.VAO);
     glBindVertexArray(data.VAO);
 
-    // Build mesh buffer data (VERTEX_SIZE = 8 floats per vertex)
+    // Cached meshes are uploaded straight from their mapping, others are packed first
+    size_t numVertices = rawData->getVertexCount();
+    const float* vertexData = rawData->packed.vertices;
     std::vector<float> bufferData;
-    size_t numVertices = rawData->vertices.size();
-    bufferData.reserve(numVertices * VERTEX_SIZE);
+    if (!rawData->isPacked()) {
+        bufferData.resize(numVertices * VERTEX_SIZE);
+        rawData->packVertices(bufferData.data());
+        vertexData = bufferData.data();
+    }
 
+    // Compact meshes are quantized from the float layout
+    MeshVertexFormat format = resolveVertexFormat(rawData->vertexFormat);
+    VertexQuantizer::Bounds bounds;
+    std::vector<uint8_t> compactData;
+    const void* uploadData = vertexData;
+    if (format == MeshVertexFormat::Compact) {
+        compactData.resize(numVertices * MESH_COMPACT_VERTEX_SIZE);
+        VertexQuantizer::Report report;
+        bounds = VertexQuantizer::pack(vertexData, numVertices, compactData.data(), &report);
+        uploadData = compactData.data();
+
+        // 16 bits keep ~1/65535 of the extent, more means the bounds are off
+        if (report.relativePositionError > 1.0f / 16384.0f || report.maxNormalError > 0.5f) {
+            std::cerr << "[Warning] Renderer::initMeshBuffers: Compact vertices lose precision, position error "
+                      << report.maxPositionError << " (" << report.relativePositionError * 100.0f << "% of the extent), normal error "
+                      << report.maxNormalError << " degrees\n";
+        }
+        m_vertexStats.maxRelativePositionError = std::max(m_vertexStats.maxRelativePositionError, report.relativePositionError);
+        m_vertexStats.maxNormalError = std::max(m_vertexStats.maxNormalError, report.maxNormalError);
+    }
+    size_t stride = getVertexStride(format);
+
+    // Bounding sphere for LOD selection, centered on the bounds
+    VertexQuantizer::Bounds sphereBounds = format == MeshVertexFormat::Compact ? bounds : VertexQuantizer::computeBounds(vertexData, numVertices);
+    glm::vec3 sphereCenter = sphereBounds.offset + sphereBounds.scale * 0.5f;
+    float sphereRadiusSquared = 0.0f;
     for (size_t i = 0; i < numVertices; ++i) {
-        // Positions (3 floats)
-        bufferData.push_back(rawData->vertices[i].x);
-        bufferData.push_back(rawData->vertices[i].y);
-        bufferData.push_back(rawData->vertices[i].z);
-
-        // Packed UVs (1 float)
-        uint32_t packedUV_fp16 = glm::packHalf2x16(rawData->uvs[i]);
-        float packedUV_float_bits;
-        // Perform bit-level copy from uint32_t to float
-        std::memcpy(&packedUV_float_bits, &packedUV_fp16, sizeof(uint32_t));
-        bufferData.push_back(packedUV_float_bits);
-
-        // Packed Normal & Tangent frame (4 floats)
-        bufferData.push_back(rawData->packedTNBFrame[i].x);
-        bufferData.push_back(rawData->packedTNBFrame[i].y);
-        bufferData.push_back(rawData->packedTNBFrame[i].z);
-        bufferData.push_back(rawData->packedTNBFrame[i].w);
+        const float* position = vertexData + i * VERTEX_SIZE;
+        glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - sphereCenter;
+        sphereRadiusSquared = std::max(sphereRadiusSquared, glm::dot(offset, offset));
     }
+    data.boundingSphere = glm::vec4(sphereCenter, std::sqrt(sphereRadiusSquared));
 
     Mesh newMesh;
 
     // Create and upload VBO
     glGenBuffers(1, &data.VBO);
     glBindBuffer(GL_ARRAY_BUFFER, data.VBO);
-    glBufferData(GL_ARRAY_BUFFER, bufferData.size() * sizeof(float),
-                 bufferData.data(), isStatic ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, numVertices * stride,
+                 uploadData, isStatic ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
 
     // Handle indices
-    if (!rawData->indices.empty()) {
+    size_t numIndices = rawData->getIndexCount();
+    if (numIndices > 0) {
+        const uint32_t* indexData = rawData->isPacked() ? rawData->packed.indices : rawData->indices.data();
         glGenBuffers(1, &data.EBO);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, rawData->indices.size() * sizeof(unsigned int),
-                     rawData->indices.data(), GL_STATIC_DRAW);
-        data.indexCount = static_cast<GLsizei>(rawData->indices.size());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned int),
+                     indexData, GL_STATIC_DRAW);
+        data.indexCount = static_cast<GLsizei>(numIndices);
         data.vertexCount = 0;
-        newMesh.count = static_cast<uint32_t>(data.indexCount);
+
+        // LOD chains share the buffer, the mesh itself draws the full detail range
+        data.lods[0] = {0, data.indexCount, 0.0f};
+        if (!rawData->lods.empty() && rawData->lods.size() <= MESH_MAX_LODS) {
+            std::copy(rawData->lods.begin(), rawData->lods.end(), data.lods.begin());
+            data.lodCount = static_cast<uint32_t>(rawData->lods.size());
+        }
+        newMesh.count = data.lods[0].indexCount;
+
+        // Meshlets go to the shared buffer, ranges must stay within LOD 0
+        bool meshletsValid = !rawData->meshlets.empty();
+        for (const Meshlet& meshlet : rawData->meshlets) {
+            meshletsValid &= meshlet.firstIndex >= data.lods[0].firstIndex &&
+                             meshlet.firstIndex + meshlet.indexCount <= data.lods[0].firstIndex + data.lods[0].indexCount;
+        }
+        if (meshletsValid) {
+            data.firstMeshlet = static_cast<uint32_t>(m_meshlets.size());
+            data.meshletCount = static_cast<uint32_t>(rawData->meshlets.size());
+            m_meshlets.insert(m_meshlets.end(), rawData->meshlets.begin(), rawData->meshlets.end());
+            m_meshletsDirty = true;
+        } else if (!rawData->meshlets.empty()) {
+            std::cerr << "[Warning] Renderer::initMeshBuffers: Meshlets outside of the index range, the mesh is drawn whole\n";
+        }
     } else {
         data.EBO = 0;
         data.indexCount = 0;
-        data.vertexCount = static_cast<GLsizei>(rawData->vertices.size());
+        data.vertexCount = static_cast<GLsizei>(numVertices);
         newMesh.count = static_cast<uint32_t>(data.vertexCount);
     }
 
-    // Attribute 0: Position (xyz) + Packed UVs (w) = 4 floats
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, VERTEX_SIZE * sizeof(float), (void*)0);
+    if (format == MeshVertexFormat::Compact) {
+        // Attribute 0: Position within the mesh bounds = 3 unorm16
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, static_cast<GLsizei>(stride), (void*)0);
 
-    // Attribute 1: Packed Normal & Tangent frame = 4 floats
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, VERTEX_SIZE * sizeof(float), (void*)(4 * sizeof(float)));
+        // Attribute 1: Packed Normal & Tangent frame = 4 snorm16
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_SHORT, GL_TRUE, static_cast<GLsizei>(stride), (void*)12);
+
+        // Attribute 2: Packed half UVs = 1 uint
+        glEnableVertexAttribArray(2);
+        glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, static_cast<GLsizei>(stride), (void*)8);
+    } else {
+        // Attribute 0: Position (xyz) = 3 floats
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(stride), (void*)0);
+
+        // Attribute 1: Packed Normal & Tangent frame = 4 floats
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(stride), (void*)(4 * sizeof(float)));
+
+        // Attribute 2: Packed half UVs, the bits of the position's w float
+        glEnableVertexAttribArray(2);
+        glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, static_cast<GLsizei>(stride), (void*)(3 * sizeof(float)));
+    }
 
     glBindVertexArray(0);
 
+    // Position stream: the leading position bytes of every vertex packed tight, so depth passes
+    // don't fetch UVs and tangent frames. Dynamic meshes skip it, it would go stale on their updates.
+    size_t positionStride = isStatic ? getPositionStride(format) : 0;
+    if (positionStride > 0) {
+        std::vector<uint8_t> positionData(numVertices * positionStride);
+        const uint8_t* src = static_cast<const uint8_t*>(uploadData);
+        for (size_t i = 0; i < numVertices; ++i) {
+            std::memcpy(&positionData[i * positionStride], src + i * stride, positionStride);
+        }
+
+        glGenVertexArrays(1, &data.positionVAO);
+        glBindVertexArray(data.positionVAO);
+        glGenBuffers(1, &data.positionVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, data.positionVBO);
+        glBufferData(GL_ARRAY_BUFFER, positionData.size(), positionData.data(), GL_STATIC_DRAW);
+
+        // Attribute 0 only, in the layout of the full stream
+        glEnableVertexAttribArray(0);
+        if (format == MeshVertexFormat::Compact) {
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, static_cast<GLsizei>(positionStride), (void*)0);
+        } else {
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(positionStride), (void*)0);
+        }
+        if (data.EBO) {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.EBO);
+        }
+        glBindVertexArray(0);
+    }
+
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
         std::cerr << "[Error] OpenGL error during mesh buffer creation: " << error << "\n";
         glDeleteVertexArrays(1, &data.VAO);
         if (data.VBO) glDeleteBuffers(1, &data.VBO);
         if (data.EBO) glDeleteBuffers(1, &data.EBO);
+        if (data.positionVAO) glDeleteVertexArrays(1, &data.positionVAO);
+        if (data.positionVBO) glDeleteBuffers(1, &data.positionVBO);
         return invalidMesh;
     }
 
@@ -120,6 +215,21 @@ Mesh Renderer::initMeshBuffers(std::unique_ptr<RawMeshData>& rawData, bool isSta
     }
 
     newMesh.id = assignedId;
+    m_meshVersion++;
+
+    m_meshBounds.resize(m_meshData.size());
+    m_meshBounds[assignedId] = {glm::vec4(bounds.offset, 0.0f), glm::vec4(bounds.scale, 0.0f)};
+    m_meshBoundsDirty = true;
+
+    size_t vertexBytes = numVertices * stride;
+    m_vertexStats.vertexBytes += vertexBytes + numVertices * positionStride;
+    m_vertexStats.positionStreamBytes += numVertices * positionStride;
+    if (format == MeshVertexFormat::Compact) {
+        m_vertexStats.compactMeshes++;
+        m_vertexStats.savedBytes += numVertices * VERTEX_SIZE * sizeof(float) - vertexBytes;
+    } else {
+        m_vertexStats.floatMeshes++;
+    }
 
     // Clear CPU data if static
     if (isStatic) {
@@ -128,9 +238,68 @@ Mesh Renderer::initMeshBuffers(std::unique_ptr<RawMeshData>& rawData, bool isSta
     return newMesh;
 }
 
-GLuint Renderer::getMeshVAO(size_t meshId) const {
+MeshVertexFormat Renderer::resolveVertexFormat(MeshVertexFormat format) const {
+    if (format == MeshVertexFormat::Default) {
+        return config.quality.compactVertices ? MeshVertexFormat::Compact : MeshVertexFormat::Float;
+    }
+    return format;
+}
+
+size_t Renderer::getVertexStride(MeshVertexFormat format) const {
+    return resolveVertexFormat(format) == MeshVertexFormat::Compact ? MESH_COMPACT_VERTEX_SIZE : VERTEX_SIZE * sizeof(float);
+}
+
+size_t Renderer::getPositionStride(MeshVertexFormat format) const {
+    if (!config.quality.positionStreams) {
+        return 0;
+    }
+    // Compact positions keep their padding so every vertex stays 4 byte aligned
+    return resolveVertexFormat(format) == MeshVertexFormat::Compact ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+}
+
+void Renderer::bindMeshBuffer(GLuint bindingPoint) {
+    if (m_meshBoundsSSBO == 0) {
+        glGenBuffers(1, &m_meshBoundsSSBO);
+    }
+
+    if (m_meshBoundsDirty && !m_meshBounds.empty()) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_meshBoundsSSBO);
+        if (m_meshBounds.size() > m_meshBoundsCapacity) {
+            m_meshBoundsCapacity = m_meshBounds.size() * 3 / 2 + 16;
+            glBufferData(GL_SHADER_STORAGE_BUFFER, m_meshBoundsCapacity * sizeof(MeshBounds), nullptr, GL_DYNAMIC_DRAW);
+        }
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_meshBounds.size() * sizeof(MeshBounds), m_meshBounds.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        m_meshBoundsDirty = false;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, m_meshBoundsSSBO);
+}
+
+void Renderer::bindMeshletBuffer(GLuint bindingPoint) {
+    if (m_meshletSSBO == 0) {
+        glGenBuffers(1, &m_meshletSSBO);
+    }
+
+    if (m_meshletsDirty && !m_meshlets.empty()) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_meshletSSBO);
+        if (m_meshlets.size() > m_meshletCapacity) {
+            m_meshletCapacity = m_meshlets.size() * 3 / 2 + 64;
+            glBufferData(GL_SHADER_STORAGE_BUFFER, m_meshletCapacity * sizeof(Meshlet), nullptr, GL_STATIC_DRAW);
+        }
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_meshlets.size() * sizeof(Meshlet), m_meshlets.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        m_meshletsDirty = false;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, m_meshletSSBO);
+}
+
+GLuint Renderer::getMeshVAO(size_t meshId, MeshVertexStream stream) const {
     if (meshId >= m_meshData.size()) return 0;
-    return m_meshData[meshId].VAO;
+    const MeshData& data = m_meshData[meshId];
+    if (stream == MeshVertexStream::Position && data.positionVAO != 0) {
+        return data.positionVAO;
+    }
+    return data.VAO;
 }
 
 bool Renderer::hasMeshIndices(size_t meshId) const {
@@ -138,6 +307,32 @@ bool Renderer::hasMeshIndices(size_t meshId) const {
     return m_meshData[meshId].EBO != 0;
 }
 
+uint32_t Renderer::getMeshLodCount(size_t meshId) const {
+    if (meshId >= m_meshData.size()) return 1;
+    return m_meshData[meshId].lodCount;
+}
+
+MeshLodRange Renderer::getMeshLod(size_t meshId, uint32_t level) const {
+    if (meshId >= m_meshData.size()) return MeshLodRange();
+    const MeshData& data = m_meshData[meshId];
+    return data.lods[std::min(level, data.lodCount - 1)];
+}
+
+uint32_t Renderer::getMeshletCount(size_t meshId) const {
+    if (meshId >= m_meshData.size()) return 0;
+    return m_meshData[meshId].meshletCount;
+}
+
+uint32_t Renderer::getFirstMeshlet(size_t meshId) const {
+    if (meshId >= m_meshData.size()) return 0;
+    return m_meshData[meshId].firstMeshlet;
+}
+
+glm::vec4 Renderer::getMeshBoundingSphere(size_t meshId) const {
+    if (meshId >= m_meshData.size()) return glm::vec4(0.0f);
+    return m_meshData[meshId].boundingSphere;
+}
+
 GLsizei Renderer::getMeshIndexCount(size_t meshId) const {
     if (meshId >= m_meshData.size()) return 0;
     return m_meshData[meshId].indexCount;
@@ -213,6 +408,21 @@ void Renderer::cleanup() {
         if (data.EBO) {
             glDeleteBuffers(1, &data.EBO);
         }
+        if (data.positionVAO) {
+            glDeleteVertexArrays(1, &data.positionVAO);
+        }
+        if (data.positionVBO) {
+            glDeleteBuffers(1, &data.positionVBO);
+        }
+    }
+
+    if (m_meshBoundsSSBO) {
+        glDeleteBuffers(1, &m_meshBoundsSSBO);
+        m_meshBoundsSSBO = 0;
+    }
+    if (m_meshletSSBO) {
+        glDeleteBuffers(1, &m_meshletSSBO);
+        m_meshletSSBO = 0;
     }
 
     // Clean up screen quad
@@ -250,83 +460,31 @@ bool Renderer::applySettings(const config::GraphicsSettings& settings) {
     return requiresRestart;
 }
 
-void Renderer::executeIndirectDraw(const std::vector<IndirectDrawCommand>& commands, GLuint indirectBuffer) {
-    if (commands.empty() || indirectBuffer == 0) {
+void Renderer::executeIndirectDraw(const std::vector<IndirectDrawRun>& runs, size_t begin, size_t end,
+                                   GLuint elementsBuffer, GLuint arraysBuffer) {
+    end = std::min(end, runs.size());
+    if (begin >= end) {
         return;
     }
 
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
-
-    // Since we now have separate buffers, all commands are the same type
-    bool isIndexed = commands[0].useIndices;
-
-    if (isIndexed) {
-        // Upload elements commands
-        std::vector<DrawElementsIndirectCommand> elementCommands;
-        elementCommands.reserve(commands.size());
-        for (const auto& cmd : commands) {
-            elementCommands.push_back(cmd.elements);
-        }
-
-        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
-                       elementCommands.size() * sizeof(DrawElementsIndirectCommand),
-                       elementCommands.data());
-
-        // Draw in batches by VAO
-        GLuint currentVAO = 0;
-        size_t batchStart = 0;
-
-        for (size_t i = 0; i <= commands.size(); ++i) {
-            GLuint nextVAO = (i < commands.size()) ? getMeshVAO(commands[i].meshId) : 0;
-
-            // Draw current batch if VAO changes or we're at the end
-            if ((nextVAO != currentVAO || i == commands.size()) && currentVAO != 0) {
-                glBindVertexArray(currentVAO);
-
-                size_t batchSize = i - batchStart;
-                size_t offsetBytes = batchStart * sizeof(DrawElementsIndirectCommand);
-
-                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
-                                          reinterpret_cast<const void*>(offsetBytes),
-                                          static_cast<GLsizei>(batchSize),
-                                          sizeof(DrawElementsIndirectCommand));
-                batchStart = i;
-            }
-            currentVAO = nextVAO;
+    GLuint boundBuffer = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const IndirectDrawRun& run = runs[i];
+        GLuint buffer = run.indexed ? elementsBuffer : arraysBuffer;
+        if (buffer != boundBuffer) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+            boundBuffer = buffer;
         }
-    } else {
-        // Upload arrays commands
-        std::vector<DrawArraysIndirectCommand> arrayCommands;
-        arrayCommands.reserve(commands.size());
-        for (const auto& cmd : commands) {
-            arrayCommands.push_back(cmd.arrays);
-        }
-
-        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
-                       arrayCommands.size() * sizeof(DrawArraysIndirectCommand),
-                       arrayCommands.data());
-
-        // Draw in batches by VAO
-        GLuint currentVAO = 0;
-        size_t batchStart = 0;
-
-        for (size_t i = 0; i <= commands.size(); ++i) {
-            GLuint nextVAO = (i < commands.size()) ? getMeshVAO(commands[i].meshId) : 0;
-
-            // Draw current batch if VAO changes or we're at the end
-            if ((nextVAO != currentVAO || i == commands.size()) && currentVAO != 0) {
-                glBindVertexArray(currentVAO);
-
-                size_t batchSize = i - batchStart;
-                size_t offsetBytes = batchStart * sizeof(DrawArraysIndirectCommand);
-
-                glMultiDrawArraysIndirect(GL_TRIANGLES,
-                                        reinterpret_cast<const void*>(offsetBytes),
-                                        static_cast<GLsizei>(batchSize),
-                                        sizeof(DrawArraysIndirectCommand));
-                batchStart = i;
-            }
-            currentVAO = nextVAO;
+        glBindVertexArray(run.vao);
+
+        if (run.indexed) {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                        reinterpret_cast<const void*>(run.first * sizeof(DrawElementsIndirectCommand)),
+                                        static_cast<GLsizei>(run.count), sizeof(DrawElementsIndirectCommand));
+        } else {
+            glMultiDrawArraysIndirect(GL_TRIANGLES,
+                                      reinterpret_cast<const void*>(run.first * sizeof(DrawArraysIndirectCommand)),
+                                      static_cast<GLsizei>(run.count), sizeof(DrawArraysIndirectCommand));
         }
     }
 
@@ -7,14 +7,14 @@
 #include "config/settings.h"
 
 #include <glad/glad.h>
+#include <array>
 #include <memory>
+#include <cstdint>
 #include <vector>
 #include <map>
 
 // Forward declarations
-struct IndirectDrawCommand;
-struct DrawElementsIndirectCommand;
-struct DrawArraysIndirectCommand;
+struct IndirectDrawRun;
 
 /*
  * The Renderer class is responsible for handling OpenGL rendering,
@@ -40,7 +40,9 @@ public:
     /*
      * Core Rendering Interface - What the renderer should focus on
      */
-    void executeIndirectDraw(const std::vector<IndirectDrawCommand>& commands, GLuint indirectBuffer);
+    // Draws runs [begin, end), their commands already uploaded to the indirect buffer of their type
+    void executeIndirectDraw(const std::vector<IndirectDrawRun>& runs, size_t begin, size_t end,
+                             GLuint elementsBuffer, GLuint arraysBuffer);
 
     /*
      * Direct mesh drawing (for your current render loop)
@@ -61,12 +63,51 @@ public:
      */
     Mesh initMeshBuffers(std::unique_ptr<RawMeshData>& rawData, bool isStatic = true);
     void deleteMeshBuffer(const Mesh& mesh);
+    // Changes whenever a mesh is added, draw commands built against an older version are stale
+    uint64_t getMeshVersion() const { return m_meshVersion; }
+
+    // Default resolves to the settings
+    MeshVertexFormat resolveVertexFormat(MeshVertexFormat format) const;
+    size_t getVertexStride(MeshVertexFormat format) const;
+    // Bytes per vertex of the position stream, 0 when meshes don't get one
+    size_t getPositionStride(MeshVertexFormat format) const;
+
+    /*
+     * Binds the per-mesh position dequantization (offset, scale), indexed by
+     * the mesh ID passed along with every instance. Uploads it first when
+     * meshes were added since the last call.
+     */
+    void bindMeshBuffer(GLuint bindingPoint);
+
+    // Binds the meshlets of every mesh, uploading the ones added since the last call
+    void bindMeshletBuffer(GLuint bindingPoint);
+
+    // Vertex memory of the uploaded meshes, savedBytes is what the float layout would have used on top
+    struct VertexStats {
+        uint32_t floatMeshes = 0;
+        uint32_t compactMeshes = 0;
+        size_t vertexBytes = 0;
+        size_t savedBytes = 0;
+        size_t positionStreamBytes = 0;         // Included in vertexBytes
+        float maxRelativePositionError = 0.0f;  // Worst compact mesh, see VertexQuantizer::Report
+        float maxNormalError = 0.0f;            // Degrees
+    };
+    const VertexStats& getVertexStats() const { return m_vertexStats; }
 
     /*
      * Query functions for indirect rendering
      */
-    GLuint getMeshVAO(size_t meshId) const;
+    // The position stream VAO falls back to the full one for meshes without it
+    GLuint getMeshVAO(size_t meshId, MeshVertexStream stream = MeshVertexStream::Full) const;
     bool hasMeshIndices(size_t meshId) const;
+    // 1 for meshes without a LOD chain, levels past the count fall back to the last one
+    uint32_t getMeshLodCount(size_t meshId) const;
+    MeshLodRange getMeshLod(size_t meshId, uint32_t level) const;
+    // Model space bounding sphere, xyz center and w radius
+    glm::vec4 getMeshBoundingSphere(size_t meshId) const;
+    // 0 for meshes culled whole, else their meshlets start at getFirstMeshlet in the meshlet buffer
+    uint32_t getMeshletCount(size_t meshId) const;
+    uint32_t getFirstMeshlet(size_t meshId) const;
     GLsizei getMeshIndexCount(size_t meshId) const;
     GLsizei getMeshVertexCount(size_t meshId) const;
 
@@ -89,10 +130,36 @@ private:
         GLuint VAO = 0;
         GLuint VBO = 0;
         GLuint EBO = 0;
+        GLuint positionVAO = 0;     // Position stream, shares the EBO
+        GLuint positionVBO = 0;
         uint32_t indexCount = 0;
         uint32_t vertexCount = 0;
+        std::array<MeshLodRange, MESH_MAX_LODS> lods{};
+        uint32_t lodCount = 1;
+        glm::vec4 boundingSphere = glm::vec4(0.0f);
+        uint32_t firstMeshlet = 0;
+        uint32_t meshletCount = 0;
     };
     std::vector<MeshData> m_meshData;
+    uint64_t m_meshVersion = 0;
+
+    // Position dequantization, parallel to m_meshData and uploaded as is
+    struct MeshBounds {
+        glm::vec4 offset;
+        glm::vec4 scale;
+    };
+    std::vector<MeshBounds> m_meshBounds;
+    GLuint m_meshBoundsSSBO = 0;
+    size_t m_meshBoundsCapacity = 0;
+    bool m_meshBoundsDirty = false;
+
+    // Meshlets of all meshes back to back, never compacted
+    std::vector<Meshlet> m_meshlets;
+    GLuint m_meshletSSBO = 0;
+    size_t m_meshletCapacity = 0;
+    bool m_meshletsDirty = false;
+
+    VertexStats m_vertexStats;
 
     /*
     * Material storage
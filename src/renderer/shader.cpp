@@ -1,80 +1,21 @@
 #include "shader.h"
-#include "../resources/resourceLoader.h"
+#include "shaderPreprocessor.h"
+#include "../resources/shaderCache.h"
+#include "../system/jobSystem.h"
+#include "../debugging/profiler.h"
 
+#include <chrono>
 #include <iostream>
-#include <sstream>
-#include <filesystem>
-#include <regex>
-#include <set>
+#include <thread>
 
 Shader::Shader() : m_ID(0) {}
 
-Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath) {
+Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath) : m_ID(0) {
     load(vertexPath, fragmentPath);
 }
 
 Shader::~Shader() {
-    if (glIsProgram(m_ID)) {
-        glDeleteProgram(m_ID);
-    }
-}
-
-/*
-* Process shader includes
-*/
-std::string Shader::processIncludes(const std::string& source, const std::string& shaderDirectory,
-                                    std::set<std::string>& includedFiles) {
-    std::istringstream stream(source);
-    std::ostringstream processedSource;
-    std::string line;
-    std::regex includeRegex("#include\\s+\"([^\"]+)\"");
-
-    while (std::getline(stream, line)) {
-        std::smatch match;
-        if (std::regex_search(line, match, includeRegex)) {
-            // Found an include directive
-            std::string includePath = match[1].str();
-
-            // Construct the full path starting from shader directory
-            std::filesystem::path fullPath = std::filesystem::path(shaderDirectory) / includePath;
-            std::string canonicalPath = std::filesystem::absolute(fullPath).string();
-
-            // Check if this file has already been included
-            if (includedFiles.find(canonicalPath) != includedFiles.end()) {
-                // File already included, add a comment instead
-                continue;
-            }
-
-            // Mark this file as included
-            includedFiles.insert(canonicalPath);
-
-            // Read the included file
-            std::string includedCode = ResourceLoader::readFile(canonicalPath);
-
-            if (includedCode.empty()) {
-                std::cerr << "[Error] Failed to include shader file: " << canonicalPath << "\n";
-            } else {
-                // The included file may also have includes, so process recursively
-                // Use the directory of the included file as the base for any nested includes
-                std::string includedFileDir = fullPath.parent_path().string();
-                std::string processedInclude = processIncludes(includedCode, includedFileDir, includedFiles);
-
-                // Add a comment to mark where the include happened and add the processed code
-                processedSource << processedInclude << "\n";
-            }
-        } else {
-            // Not an include line, just copy it
-            processedSource << line << "\n";
-        }
-    }
-
-    return processedSource.str();
-}
-
-// Public wrapper for processIncludes that initializes the tracking set
-std::string Shader::processIncludes(const std::string& source, const std::string& shaderDirectory) {
-    std::set<std::string> includedFiles;
-    return processIncludes(source, shaderDirectory, includedFiles);
+    reset();
 }
 
 /*
@@ -176,99 +117,208 @@ void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
 /*
 * Shader creation
 */
-bool Shader::load(const std::string& vertexPath, const std::string& fragmentPath) {
+namespace {
+    // KHR/ARB_parallel_shader_compile: compiles run on driver threads and GL_COMPLETION_STATUS can be polled
+    bool hasParallelCompile() {
+        static const bool supported = []() {
+            if (GLAD_GL_KHR_parallel_shader_compile && glMaxShaderCompilerThreadsKHR) {
+                glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // Let the driver pick
+                return true;
+            }
+            if (GLAD_GL_ARB_parallel_shader_compile && glMaxShaderCompilerThreadsARB) {
+                glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+                return true;
+            }
+            return false;
+        }();
+        return supported;
+    }
+}
+
+bool Shader::load(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines) {
+    PROFILE_SCOPE("Shader::load");
+    reset();
+
+    // Load shaders from files with their includes spliced in
+    PendingLoad pending;
+    pending.vertexPath = vertexPath;
+    pending.fragmentPath = fragmentPath;
+    if (!preprocess(vertexPath, fragmentPath, defines, pending.sources)) {
+        return false;
+    }
+
+    if (!startProgram(pending)) {
+        return finishProgram(pending);
+    }
+    return true;
+}
+
+void Shader::loadAsync(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines) {
+    reset();
+    hasParallelCompile();
+
+    m_pending = std::make_unique<PendingLoad>();
+    m_pending->vertexPath = vertexPath;
+    m_pending->fragmentPath = fragmentPath;
+    m_pending->preprocessed = JobSystem::getInstance().submit([vertexPath, fragmentPath, defines]() {
+        Sources sources;
+        preprocess(vertexPath, fragmentPath, defines, sources);
+        return sources;
+    });
+}
+
+bool Shader::poll() {
+    if (!m_pending) {
+        return true;
+    }
+    PROFILE_SCOPE("Shader::poll");
+    PendingLoad& pending = *m_pending;
+
+    // Worker still preprocessing
+    if (pending.preprocessed.valid()) {
+        if (pending.preprocessed.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        pending.sources = pending.preprocessed.get();
+        if (!pending.sources.valid || startProgram(pending)) {
+            m_pending.reset();
+            return true;
+        }
+    }
+
+    // Without the extension the status queries below wait for the driver
+    if (hasParallelCompile()) {
+        GLint complete = GL_FALSE;
+        glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &complete);
+        if (!complete) {
+            return false;
+        }
+    }
+
+    finishProgram(pending);
+    m_pending.reset();
+    return true;
+}
+
+bool Shader::wait() {
+    while (!poll()) {
+        std::this_thread::yield();
+    }
+    return m_ID != 0;
+}
+
+void Shader::reset() {
+    if (m_pending) {
+        // A preprocess still running owns its own copy of the sources, only GL objects need freeing
+        deleteStages(*m_pending);
+        if (m_pending->program != 0) {
+            glDeleteProgram(m_pending->program);
+        }
+        m_pending.reset();
+    }
+    if (m_ID != 0 && glIsProgram(m_ID)) {
+        glDeleteProgram(m_ID);
+    }
     m_ID = 0;
     // Clear the uniform location cache when loading a new shader
     m_UniformLocationCache.clear();
+}
 
-    // Extract the shader directory paths
-    std::filesystem::path vertexFsPath(vertexPath);
-    std::filesystem::path fragmentFsPath(fragmentPath);
-    std::string vertexDir = vertexFsPath.parent_path().string();
-    std::string fragmentDir = fragmentFsPath.parent_path().string();
-
-    // Load shaders from files
-    std::string vertexCode = ResourceLoader::readFile(vertexPath);
-    if (vertexCode.empty()) {
+bool Shader::preprocess(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines,
+                        Sources& sources) {
+    // Defines are part of the sources, so every variant gets its own program binary cache entry
+    if (!ShaderPreprocessor::process(vertexPath, sources.vertex, defines)) {
         std::cerr << "[Error] Shader::load: Failed to read vertex shader file: " << vertexPath << "\n";
         return false;
     }
-
-    std::string fragmentCode = ResourceLoader::readFile(fragmentPath);
-    if (fragmentCode.empty()) {
+    if (!ShaderPreprocessor::process(fragmentPath, sources.fragment, defines)) {
         std::cerr << "[Error] Shader::load: Failed to read fragment shader file: " << fragmentPath << "\n";
         return false;
     }
+    sources.valid = true;
+    return true;
+}
 
-    // Process includes in both shaders (each with its own tracking set)
-    vertexCode = processIncludes(vertexCode, vertexDir);
-    fragmentCode = processIncludes(fragmentCode, fragmentDir);
-
-    // Compile shaders
-    int compileStatus = 0;
-    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode.c_str(), &compileStatus);
-    if (compileStatus != 0) {
-        std::cerr << "[Error] Shader::load: Vertex shader compilation failed\n";
-        return false;
+bool Shader::startProgram(PendingLoad& pending) {
+    // A cached binary of the same sources skips compiling and linking
+    pending.cacheKey = ShaderCache::makeKey({&pending.sources.vertex, &pending.sources.fragment});
+    m_ID = ShaderCache::load(pending.cacheKey);
+    if (m_ID != 0) {
+        return true;
     }
 
-    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode.c_str(), &compileStatus);
-    if (compileStatus != 0) {
-        std::cerr << "[Error] Shader::load: Fragment shader compilation failed\n";
-        glDeleteShader(vertexShader);
-        return false;
+    // Queue both compiles and the link before asking for any status, so the driver can overlap them
+    PROFILE_SCOPE("Shader::startProgram");
+    pending.vertexShader = compileShader(GL_VERTEX_SHADER, pending.sources.vertex.c_str());
+    pending.fragmentShader = compileShader(GL_FRAGMENT_SHADER, pending.sources.fragment.c_str());
+
+    pending.program = glCreateProgram();
+    glAttachShader(pending.program, pending.vertexShader);
+    glAttachShader(pending.program, pending.fragmentShader);
+    if (ShaderCache::isEnabled()) {
+        glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     }
+    glLinkProgram(pending.program);
+    return false;
+}
 
-    // Link shaders into a program
-    int linkStatus = 0;
-    linkProgram(vertexShader, fragmentShader, &linkStatus);
-    if (linkStatus != 0) {
+bool Shader::finishProgram(PendingLoad& pending) {
+    PROFILE_SCOPE("Shader::finishProgram");
+    bool compiled = checkShader(pending.vertexShader, "Vertex", pending.vertexPath) &&
+                    checkShader(pending.fragmentShader, "Fragment", pending.fragmentPath);
+    deleteStages(pending);
+
+    // Link errors only mean something once both stages compiled
+    GLint linkStatus = GL_FALSE;
+    if (compiled) {
+        glGetProgramiv(pending.program, GL_LINK_STATUS, &linkStatus);
+        if (!linkStatus) {
+            char infoLog[512];
+            glGetProgramInfoLog(pending.program, 512, NULL, infoLog);
+            std::cerr << "[Error] Shader::linkProgram: Linking failed (" << pending.vertexPath << ", "
+                      << pending.fragmentPath << ")\n" << infoLog << "\n";
+        }
+    }
+    if (!linkStatus) {
         std::cerr << "[Error] Shader::load: Program linking failed\n";
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
+        glDeleteProgram(pending.program);
+        pending.program = 0;
         return false;
     }
 
-    // Clean up shaders after linking
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    m_ID = pending.program;
+    pending.program = 0;
+    ShaderCache::store(pending.cacheKey, m_ID);
     return true;
 }
 
-unsigned int Shader::compileShader(unsigned int type, const char* source, int* status) {
+unsigned int Shader::compileShader(unsigned int type, const char* source) {
     unsigned int shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, NULL);
     glCompileShader(shader);
+    return shader;
+}
 
+bool Shader::checkShader(unsigned int shader, const char* stage, const std::string& path) {
     int compileStatus;
     char infoLog[512];
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
     if (!compileStatus) {
         glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "[Error] Shader::compileShader: Compilation failed\n" << infoLog << "\n";
-        *status = -1;
-    } else {
-        *status = 0;
+        std::cerr << "[Error] Shader::compileShader: Compilation failed: " << path << "\n" << infoLog << "\n";
+        std::cerr << "[Error] Shader::load: " << stage << " shader compilation failed\n";
+        return false;
     }
-
-    return shader;
+    return true;
 }
 
-void Shader::linkProgram(unsigned int vertexShader, unsigned int fragmentShader, int* status) {
-    m_ID = glCreateProgram();
-    glAttachShader(m_ID, vertexShader);
-    glAttachShader(m_ID, fragmentShader);
-    glLinkProgram(m_ID);
-
-    int linkStatus;
-    char infoLog[512];
-    glGetProgramiv(m_ID, GL_LINK_STATUS, &linkStatus);
-    if (!linkStatus) {
-        glGetProgramInfoLog(m_ID, 512, NULL, infoLog);
-        std::cerr << "[Error] Shader::linkProgram: Linking failed\n" << infoLog << "\n";
-        *status = -1;
-        m_ID = 0;
-    } else {
-        *status = 0;
+void Shader::deleteStages(PendingLoad& pending) {
+    if (pending.vertexShader != 0) {
+        glDeleteShader(pending.vertexShader);
+        pending.vertexShader = 0;
+    }
+    if (pending.fragmentShader != 0) {
+        glDeleteShader(pending.fragmentShader);
+        pending.fragmentShader = 0;
     }
 }
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <future>
+#include <memory>
 #include <string>
 #include <unordered_map>
-#include <set>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -15,9 +17,25 @@ public:
     ~Shader();
 
     // Program operations
-    bool load(const std::string& vertexPath, const std::string& fragmentPath);
+    // defines are "#define NAME value" lines added to both stages, see ShaderPreprocessor::process
+    bool load(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines = "");
     void use() const;
 
+    /*
+     * Async load, the shader is its own handle. The sources are preprocessed
+     * on the job system, poll() then hands them to the driver and, with
+     * KHR_parallel_shader_compile, checks GL_COMPLETION_STATUS without
+     * blocking. Without the extension the compile finishes inside poll().
+     * Start every shader before polling any of them so the compiles overlap.
+     */
+    void loadAsync(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines = "");
+    // @return true once the load finished, isValid() tells whether it succeeded
+    bool poll();
+    // Polls until the load finished, @return isValid()
+    bool wait();
+    bool isLoading() const { return m_pending != nullptr; }
+    bool isValid() const { return m_ID != 0; }
+
     // Query functions
     bool hasUniform(const std::string& name) const;
 
@@ -37,14 +55,39 @@ private:
     // Cache for uniform locations
     mutable std::unordered_map<std::string, GLint> m_UniformLocationCache;
 
-    // Helper methods for compilation and linking
-    unsigned int compileShader(unsigned int type, const char* source, int* status);
-    void linkProgram(unsigned int vertexShader, unsigned int fragmentShader, int* status);
+    // Preprocessed stages
+    struct Sources {
+        std::string vertex;
+        std::string fragment;
+        bool valid = false;
+    };
+
+    // Program being built, vertex/fragment shaders and program stay 0 on a cache hit
+    struct PendingLoad {
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::future<Sources> preprocessed;  // Only for loadAsync()
+        Sources sources;
+        uint64_t cacheKey = 0;
+        unsigned int vertexShader = 0;
+        unsigned int fragmentShader = 0;
+        unsigned int program = 0;
+    };
+    std::unique_ptr<PendingLoad> m_pending;
 
-    // Process includes in shader source code
-    std::string processIncludes(const std::string& source, const std::string& shaderDirectory);
-    std::string processIncludes(const std::string& source, const std::string& shaderDirectory,
-                               std::set<std::string>& includedFiles);
+    // Deletes the program and any load in flight
+    void reset();
+
+    // Helper methods for compilation and linking
+    static bool preprocess(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines,
+                           Sources& sources);
+    // Loads the cached binary or queues the compiles and the link. @return true on a cache hit
+    bool startProgram(PendingLoad& pending);
+    // Reads the compile and link status, waits for the driver if it isn't done yet
+    bool finishProgram(PendingLoad& pending);
+    static unsigned int compileShader(unsigned int type, const char* source);
+    static bool checkShader(unsigned int shader, const char* stage, const std::string& path);
+    static void deleteStages(PendingLoad& pending);
 
     // Uniform location getter
     GLint getUniformLocation(const std::string& name) const;
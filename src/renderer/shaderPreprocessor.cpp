@@ -0,0 +1,122 @@
+#include "shaderPreprocessor.h"
+#include "../resources/cacheFile.h"
+#include "../resources/resourceLoader.h"
+#include "../debugging/profiler.h"
+
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::unordered_map<std::string, std::string> g_files;
+    std::mutex g_filesMutex;
+
+    // Contents of a file by its normalized path, read on first use. Null if it can't be read.
+    const std::string* readCached(const std::string& path) {
+        std::lock_guard<std::mutex> lock(g_filesMutex);
+        auto it = g_files.find(path);
+        if (it == g_files.end()) {
+            std::string contents = ResourceLoader::readFile(path);
+            if (contents.empty()) {
+                return nullptr;
+            }
+            it = g_files.emplace(path, std::move(contents)).first;
+        }
+        // Node based map, the string stays put while other files are added
+        return &it->second;
+    }
+
+    bool isBlank(char c) {
+        return c == ' ' || c == '\t';
+    }
+
+    /*
+     * Matches `#include "path"` at the start of [begin, end).
+     * @return false for any other line, includePath is left untouched.
+     */
+    bool parseInclude(const char* begin, const char* end, std::string& includePath) {
+        const char* c = begin;
+        while (c < end && isBlank(*c)) ++c;
+        if (c == end || *c != '#') {
+            return false;
+        }
+        ++c;
+        while (c < end && isBlank(*c)) ++c;
+
+        constexpr char KEYWORD[] = "include";
+        constexpr size_t KEYWORD_LENGTH = sizeof(KEYWORD) - 1;
+        if (static_cast<size_t>(end - c) < KEYWORD_LENGTH || std::char_traits<char>::compare(c, KEYWORD, KEYWORD_LENGTH) != 0) {
+            return false;
+        }
+        c += KEYWORD_LENGTH;
+        while (c < end && isBlank(*c)) ++c;
+
+        if (c == end || *c != '"') {
+            return false;
+        }
+        const char* pathBegin = ++c;
+        while (c < end && *c != '"') ++c;
+        if (c == end || c == pathBegin) {
+            return false;
+        }
+        includePath.assign(pathBegin, c);
+        return true;
+    }
+
+    bool append(const std::string& path, std::unordered_set<std::string>& includedFiles, std::string& output) {
+        const std::string* source = readCached(path);
+        if (!source) {
+            return false;
+        }
+
+        std::string includePath;
+        const char* c = source->data();
+        const char* end = c + source->size();
+        while (c < end) {
+            const char* lineEnd = c;
+            while (lineEnd < end && *lineEnd != '\n') ++lineEnd;
+
+            if (!parseInclude(c, lineEnd, includePath)) {
+                output.append(c, lineEnd);
+                output += '\n';
+            } else {
+                // Nested includes resolve against the directory of the file including them
+                std::string fullPath = (fs::path(path).parent_path() / includePath).lexically_normal().generic_string();
+                if (includedFiles.insert(fullPath).second && !append(fullPath, includedFiles, output)) {
+                    std::cerr << "[Error] ShaderPreprocessor::process: Failed to include " << fullPath << " from " << path << "\n";
+                    return false;
+                }
+            }
+            c = lineEnd + 1;
+        }
+        return true;
+    }
+}
+
+bool ShaderPreprocessor::process(const std::string& path, std::string& output, const std::string& defines) {
+    PROFILE_SCOPE("ShaderPreprocessor::process");
+    std::string fullPath = CacheFile::normalizePath(path);
+    std::unordered_set<std::string> includedFiles{fullPath};
+
+    output.clear();
+    if (!append(fullPath, includedFiles, output)) {
+        return false;
+    }
+
+    // #version has to stay the first directive, a source without one gets the defines on top
+    if (!defines.empty()) {
+        size_t version = output.find("#version");
+        size_t lineEnd = version == std::string::npos ? std::string::npos : output.find('\n', version);
+        output.insert(lineEnd == std::string::npos ? 0 : lineEnd + 1, defines);
+    }
+    return true;
+}
+
+void ShaderPreprocessor::clearFileCache() {
+    std::lock_guard<std::mutex> lock(g_filesMutex);
+    g_files.clear();
+}
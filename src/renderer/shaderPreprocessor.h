@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+/*
+ * Resolves #include "file" directives in GLSL sources.
+ *
+ * A directive must start its line (leading whitespace is fine), its path is
+ * relative to the including file and every file is spliced in at most once
+ * per shader. Files are read once and kept in memory, so the common includes
+ * of the passes are only read from disk for the first shader using them.
+ */
+namespace ShaderPreprocessor {
+    /*
+     * Reads the shader at path and splices in its includes. defines ("#define NAME value"
+     * lines) go right after the #version line, ahead of everything they can affect.
+     * @return false if the shader or one of its includes can't be read, the error is logged.
+     */
+    bool process(const std::string& path, std::string& output, const std::string& defines = "");
+
+    // Drops the cached file contents, call before reloading edited shaders
+    void clearFileCache();
+}
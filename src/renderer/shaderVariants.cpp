@@ -0,0 +1,79 @@
+#include "shaderVariants.h"
+
+#include <iostream>
+#include <thread>
+
+void ShaderVariants::loadAsync(const std::string& vertexPath, const std::string& fragmentPath, const std::string& keyDefine) {
+    m_vertexPath = vertexPath;
+    m_fragmentPath = fragmentPath;
+    m_keyDefine = keyDefine;
+    m_variants.clear();
+    m_genericDraws = 0;
+    m_generic.loadAsync(vertexPath, fragmentPath);
+}
+
+void ShaderVariants::wait() {
+    bool compiling = true;
+    while (compiling) {
+        compiling = false;
+        for (auto& [key, variant] : m_variants) {
+            compiling |= !variant.shader->poll();
+        }
+        if (compiling) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+Shader& ShaderVariants::get(uint32_t key) {
+    if (!m_enabled) {
+        m_genericDraws++;
+        return m_generic;
+    }
+
+    Variant& variant = m_variants[key];
+    if (!variant.shader) {
+        variant.shader = std::make_unique<Shader>();
+        variant.shader->loadAsync(m_vertexPath, m_fragmentPath, "#define " + m_keyDefine + " " + std::to_string(key) + "u\n");
+    }
+    if (variant.shader->poll() && variant.shader->isValid()) {
+        variant.draws++;
+        return *variant.shader;
+    }
+    m_genericDraws++;
+    return m_generic;
+}
+
+ShaderVariants::Stats ShaderVariants::getStats() const {
+    Stats stats;
+    for (const auto& [key, variant] : m_variants) {
+        if (variant.shader->isLoading()) {
+            stats.compiling++;
+        } else if (variant.shader->isValid()) {
+            stats.ready++;
+        } else {
+            stats.failed++;
+        }
+        stats.variantDraws += variant.draws;
+    }
+    stats.genericDraws = m_genericDraws;
+    return stats;
+}
+
+void ShaderVariants::resetStats() {
+    for (auto& [key, variant] : m_variants) {
+        variant.draws = 0;
+    }
+    m_genericDraws = 0;
+}
+
+void ShaderVariants::printStats() const {
+    Stats stats = getStats();
+    std::cout << "[Info] ShaderVariants " << m_fragmentPath << ": " << stats.ready << " ready, " << stats.compiling
+              << " compiling, " << stats.failed << " failed\n";
+    std::cout << "  generic: " << m_genericDraws << " draws\n";
+    for (const auto& [key, variant] : m_variants) {
+        std::cout << "  " << m_keyDefine << " 0x" << std::hex << key << std::dec << ": " << variant.draws << " draws"
+                  << (variant.shader->isLoading() ? " (compiling)" : variant.shader->isValid() ? "" : " (failed)") << "\n";
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "shader.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+/*
+ * Specialised programs of one shader, keyed by a bit mask.
+ *
+ * The generic program is built from the sources as they are and decides at
+ * runtime. A variant is the same sources with "#define <keyDefine> <key>u",
+ * so a shader testing its bits through the define folds the tests to
+ * constants. Variants are compiled in the background on first request and
+ * the generic program stands in until they are ready, or for good if one
+ * fails. Variants go through ShaderCache like any other program.
+ */
+class ShaderVariants {
+public:
+    struct Stats {
+        uint32_t ready = 0;
+        uint32_t compiling = 0;
+        uint32_t failed = 0;
+        uint32_t variantDraws = 0;  // get() calls answered by a variant since resetStats()
+        uint32_t genericDraws = 0;  // get() calls answered by the generic program
+    };
+
+    // Starts loading the generic program
+    void loadAsync(const std::string& vertexPath, const std::string& fragmentPath, const std::string& keyDefine);
+    // @return true once the generic program finished loading
+    bool poll() { return m_generic.poll(); }
+    // Polls every variant requested so far until none is compiling
+    void wait();
+
+    // Disabled, get() always returns the generic program and no variant is compiled
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled; }
+
+    Shader& getGeneric() { return m_generic; }
+    // Program to draw the key with, starts compiling its variant on the first request
+    Shader& get(uint32_t key);
+
+    Stats getStats() const;
+    void resetStats();
+    void printStats() const;
+
+private:
+    struct Variant {
+        std::unique_ptr<Shader> shader;
+        uint32_t draws = 0;
+    };
+
+    std::string m_vertexPath;
+    std::string m_fragmentPath;
+    std::string m_keyDefine;
+
+    Shader m_generic;
+    std::map<uint32_t, Variant> m_variants;
+    uint32_t m_genericDraws = 0;
+    bool m_enabled = true;
+};
@@ -1,10 +1,97 @@
 #include "texture.h"
+#include "mipGenerator.h"
 #include "../resources/resourceLoader.h"
+#include "../resources/blockCompression.h"
+#include "../resources/ddsFile.h"
+#include "../resources/textureCache.h"
+#include "../debugging/profiler.h"
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <utility>
 
-Texture::Texture(const std::string& filePath)
+TextureImage::~TextureImage() {
+    releasePixels();
+}
+
+void TextureImage::releasePixels() {
+    if (pixels) {
+        ResourceLoader::freeImage(pixels);
+        pixels = nullptr;
+    }
+    mipLevels.clear();
+}
+
+TextureImage::TextureImage(TextureImage&& other) noexcept {
+    *this = std::move(other);
+}
+
+TextureImage& TextureImage::operator=(TextureImage&& other) noexcept {
+    if (this != &other) {
+        std::swap(pixels, other.pixels);
+        std::swap(width, other.width);
+        std::swap(height, other.height);
+        std::swap(channels, other.channels);
+        std::swap(isSRGB, other.isSRGB);
+        std::swap(mipLevels, other.mipLevels);
+        std::swap(format, other.format);
+        std::swap(blockLevels, other.blockLevels);
+    }
+    return *this;
+}
+
+size_t TextureImage::getSize() const {
+    size_t size = pixels ? static_cast<size_t>(width) * height * channels : 0;
+    for (const std::vector<unsigned char>& level : mipLevels) {
+        size += level.size();
+    }
+    for (const std::vector<unsigned char>& level : blockLevels) {
+        size += level.size();
+    }
+    return size;
+}
+
+Texture::Texture(const std::string& filePath, TextureUsage usage)
+    : m_textureID(0), m_handle(0), m_isResident(false), m_filePath(filePath) {
+    createTexture(decode(filePath, usage));
+}
+
+Texture::Texture(const std::string& filePath, const TextureImage& image)
     : m_textureID(0), m_handle(0), m_isResident(false), m_filePath(filePath) {
-    createTexture(filePath);
+    createTexture(image);
+}
+
+Texture::Texture() : m_textureID(0), m_handle(0), m_isResident(false) {
+}
+
+TextureImage Texture::decode(const std::string& filePath, TextureUsage usage) {
+    PROFILE_SCOPE("Texture::decode");
+    TextureImage image;
+
+    // Precompressed files and cached imports already carry their mips
+    if (DDSFile::isDDSPath(filePath)) {
+        DDSFile::load(filePath, image);
+        return image;
+    }
+    if (TextureCache::load(filePath, usage, image)) {
+        return image;
+    }
+
+    image.pixels = ResourceLoader::loadImage(filePath, &image.width, &image.height, &image.channels);
+    image.isSRGB = usage == TextureUsage::Color;
+    MipGenerator::generateMipChain(image);
+    TextureCache::import(filePath, usage, image);
+    return image;
+}
+
+bool Texture::isFormatSupported(TextureFormat format) {
+    switch (format) {
+        case TextureFormat::BC1:
+        case TextureFormat::BC3:
+            return GLAD_GL_EXT_texture_compression_s3tc != 0;
+        default:
+            return true;
+    }
 }
 
 Texture::~Texture() {
@@ -16,90 +103,203 @@ Texture::~Texture() {
     }
 }
 
-void Texture::createTexture(const std::string& filePath) {
-    int width = 0, height = 0, nrChannels = 0;
-    // Use ResourceLoader to load image data
-    unsigned char* data = ResourceLoader::loadImage(filePath, &width, &height, &nrChannels);
-
-    if (data) {
-        // Determine the correct format based on the number of channels
-        GLenum format;
-        GLenum internalFormat;
-        bool isGrayscale = false;
-
-        if (nrChannels == 1) {
-            format = GL_RED;
-            internalFormat = GL_R8;
-            isGrayscale = true;
-        } else if (nrChannels == 3) {
-            format = GL_RGB;
-            internalFormat = GL_RGB8;
-        } else if (nrChannels == 4) {
-            format = GL_RGBA;
-            internalFormat = GL_RGBA8;
+void Texture::createTexture(const TextureImage& image) {
+    PROFILE_SCOPE("Texture::createTexture");
+    const std::string& filePath = m_filePath;
+    int width = image.width, height = image.height, nrChannels = image.channels;
+
+    if (!image.isValid()) {
+        std::cerr << "[Error] Texture::createTexture: Failed to load texture: " << filePath << "\n";
+        return;
+    }
+    if (!isFormatSupported(image.format)) {
+        std::cerr << "[Error] Texture::createTexture: " << BlockCompression::getFormatName(image.format)
+                  << " is not supported by the driver: " << filePath << "\n";
+        return;
+    }
+
+    // Determine the correct format based on the storage and number of channels
+    GLenum format = GL_RGB;
+    GLenum internalFormat = GL_RGB8;
+    switch (image.format) {
+        case TextureFormat::BC1: internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+        case TextureFormat::BC3: internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+        case TextureFormat::BC4: internalFormat = GL_COMPRESSED_RED_RGTC1; break;
+        case TextureFormat::BC5: internalFormat = GL_COMPRESSED_RG_RGTC2; break;
+        case TextureFormat::BC7: internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+        case TextureFormat::Uncompressed:
+            if (nrChannels == 1) {
+                format = GL_RED;
+                internalFormat = GL_R8;
+            } else if (nrChannels == 2) {
+                // Grayscale + alpha
+                format = GL_RG;
+                internalFormat = GL_RG8;
+            } else if (nrChannels == 3) {
+                format = GL_RGB;
+                internalFormat = GL_RGB8;
+            } else if (nrChannels == 4) {
+                format = GL_RGBA;
+                internalFormat = GL_RGBA8;
+            } else {
+                std::cerr << "[Error] Texture::createTexture: Unsupported number of channels: " << nrChannels << "\n";
+                return;
+            }
+            break;
+    }
+
+    // Generate an OpenGL texture
+    glGenTextures(1, &m_textureID);
+    glBindTexture(GL_TEXTURE_2D, m_textureID);
+
+    // Upload the texture data to the GPU, decoded rows are tightly packed
+    GLint level = 0;
+    m_format = image.format;
+    m_internalFormat = internalFormat;
+    m_width = width;
+    m_height = height;
+    m_channels = nrChannels;
+    m_memorySize = 0;
+    if (image.isCompressed()) {
+        for (const std::vector<unsigned char>& blocks : image.blockLevels) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level++, internalFormat, width, height, 0,
+                                   static_cast<GLsizei>(blocks.size()), blocks.data());
+            m_memorySize += blocks.size();
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+        m_levelCount = level;
+    } else {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+        m_memorySize = static_cast<size_t>(width) * height * nrChannels;
+
+        // Upload the CPU generated mip chain
+        for (const std::vector<unsigned char>& mip : image.mipLevels) {
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            glTexImage2D(GL_TEXTURE_2D, ++level, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, mip.data());
+            m_memorySize += mip.size();
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        // Images without a CPU mip chain get theirs from the driver
+        if (image.mipLevels.empty()) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            m_memorySize += m_memorySize / 3;
+            m_levelCount = MipGenerator::getLevelCount(m_width, m_height);
         } else {
-            std::cerr << "[Error] Texture::createTexture: Unsupported number of channels: " << nrChannels << "\n";
-            format = GL_RGB;
-            internalFormat = GL_RGB8;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+            m_levelCount = level + 1;
         }
+    }
 
-        // Generate an OpenGL texture
-        glGenTextures(1, &m_textureID);
-        glBindTexture(GL_TEXTURE_2D, m_textureID);
+    applySamplerState();
 
-        // Set texture parameters (repeat wrapping)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // Unbind the texture
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-        // Set texture filtering parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    createHandle();
+}
 
-        // Upload the texture data to the GPU
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+std::shared_ptr<Texture> Texture::createMipTail(int maxSize) const {
+    if (m_textureID == 0) {
+        return nullptr;
+    }
 
-        // If the texture is grayscale, set texture swizzle parameters to replicate the red channel to RGB
-        if (isGrayscale) {
-            GLint swizzleMask[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
-            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
-        }
+    // First level that fits, the tail keeps it and everything below
+    int firstLevel = 0;
+    int width = m_width;
+    int height = m_height;
+    while (firstLevel < m_levelCount - 1 && std::max(width, height) > maxSize) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        firstLevel++;
+    }
+    if (firstLevel == 0) {
+        return nullptr;
+    }
+    PROFILE_SCOPE("Texture::createMipTail");
 
-        // Generate mipmaps for the texture
-        glGenerateMipmap(GL_TEXTURE_2D);
+    std::shared_ptr<Texture> tail(new Texture());
+    tail->m_filePath = m_filePath;
+    tail->m_format = m_format;
+    tail->m_internalFormat = m_internalFormat;
+    tail->m_width = width;
+    tail->m_height = height;
+    tail->m_channels = m_channels;
+    tail->m_levelCount = m_levelCount - firstLevel;
 
-        // Apply anisotropic filtering if available
-        if (glTexParameterf) { // Check if function is loaded
-            GLfloat maxAniso = 0.0f;
-            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAniso);
-            if (maxAniso > 0.0f) {
-                glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, maxAniso);
-            }
-        }
+    glGenTextures(1, &tail->m_textureID);
+    glBindTexture(GL_TEXTURE_2D, tail->m_textureID);
+    glTexStorage2D(GL_TEXTURE_2D, tail->m_levelCount, m_internalFormat, width, height);
 
-        // Unbind the texture
-        glBindTexture(GL_TEXTURE_2D, 0);
+    // GPU side copy, compressed levels move as whole blocks
+    for (int level = 0; level < tail->m_levelCount; ++level) {
+        glCopyImageSubData(m_textureID, GL_TEXTURE_2D, firstLevel + level, 0, 0, 0,
+                           tail->m_textureID, GL_TEXTURE_2D, level, 0, 0, 0, width, height, 1);
+        tail->m_memorySize += m_format != TextureFormat::Uncompressed
+            ? BlockCompression::getLevelSize(m_format, width, height)
+            : static_cast<size_t>(width) * height * m_channels;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
 
-        // Create bindless handle
-        if (glGetTextureHandleARB) { // Check if bindless texture functions are loaded
-            m_handle = glGetTextureHandleARB(m_textureID);
-            if (m_handle == 0) {
-                std::cerr << "[Error] Texture::createTexture: Failed to create bindless handle for: " << filePath << "\n";
-            }
-        } else {
-            std::cerr << "[Warning] Texture::createTexture: Bindless textures not supported\n";
+    tail->applySamplerState();
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    tail->createHandle();
+    if (!tail->isValid()) {
+        return nullptr;
+    }
+    return tail;
+}
+
+void Texture::applySamplerState() {
+    // Set texture parameters (repeat wrapping)
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // Set texture filtering parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Single channel textures replicate red to RGB, grayscale + alpha puts green in alpha
+    if (m_channels == 1) {
+        GLint swizzleMask[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+    } else if (m_channels == 2 && m_format == TextureFormat::Uncompressed) {
+        GLint swizzleMask[] = {GL_RED, GL_RED, GL_RED, GL_GREEN};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+    }
+
+    // Apply anisotropic filtering if available
+    if (glTexParameterf) { // Check if function is loaded
+        GLfloat maxAniso = 0.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAniso);
+        if (maxAniso > 0.0f) {
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, maxAniso);
         }
+    }
+}
 
-        // Error checking
-        GLenum error = glGetError();
-        if (error != GL_NO_ERROR) {
-            std::cerr << "[Error] Texture::createTexture: OpenGL error during texture creation: " << error << "\n";
+void Texture::createHandle() {
+    // Create bindless handle
+    if (glGetTextureHandleARB) { // Check if bindless texture functions are loaded
+        m_handle = glGetTextureHandleARB(m_textureID);
+        if (m_handle == 0) {
+            std::cerr << "[Error] Texture::createHandle: Failed to create bindless handle for: " << m_filePath << "\n";
         }
     } else {
-        std::cerr << "[Error] Texture::createTexture: Failed to load texture: " << filePath << "\n";
+        std::cerr << "[Warning] Texture::createHandle: Bindless textures not supported\n";
     }
 
-    // Free image data after uploading to the GPU
-    ResourceLoader::freeImage(data);
+    // Error checking
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        std::cerr << "[Error] Texture::createHandle: OpenGL error during texture creation: " << error << "\n";
+    }
 }
 
 void Texture::makeResident() {
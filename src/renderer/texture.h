@@ -1,18 +1,101 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
+
+// Storage of a TextureImage, Uncompressed uses channels to pick R8/RG8/RGB8/RGBA8
+enum class TextureFormat : uint32_t {
+    Uncompressed = 0,
+    BC1,    // RGB, 4 bpp
+    BC3,    // RGBA, 8 bpp
+    BC4,    // R, 4 bpp
+    BC5,    // RG, 8 bpp
+    BC7,    // RGBA, 8 bpp
+};
+
+// What a material samples the texture as, decides mip filtering and block compression
+enum class TextureUsage : uint32_t {
+    Color = 0,  // Albedo, emissive: sRGB encoded
+    Data,       // Metallic/roughness and other linear channels
+    Normal,     // Tangent space normals, only X/Y are kept when compressed
+    Height,     // Single channel
+};
+
+/*
+* Decoded pixels of a texture file. Decoding doesn't touch OpenGL, so it can
+* run on a job system worker while the upload stays on the main thread.
+*/
+struct TextureImage {
+    unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    bool isSRGB = false; // Color data, mips are filtered in linear space
+
+    // Levels 1..n from MipGenerator, level 0 is pixels. Empty falls back to glGenerateMipmap.
+    std::vector<std::vector<unsigned char>> mipLevels;
+
+    // Block compressed levels 0..n, replace pixels and mipLevels when format isn't Uncompressed
+    TextureFormat format = TextureFormat::Uncompressed;
+    std::vector<std::vector<unsigned char>> blockLevels;
+
+    TextureImage() = default;
+    ~TextureImage();
+    TextureImage(TextureImage&& other) noexcept;
+    TextureImage& operator=(TextureImage&& other) noexcept;
+    TextureImage(const TextureImage&) = delete;
+    TextureImage& operator=(const TextureImage&) = delete;
+
+    bool isValid() const { return pixels != nullptr || !blockLevels.empty(); }
+    bool isCompressed() const { return format != TextureFormat::Uncompressed; }
+    // Frees pixels and mipLevels, once they are block compressed
+    void releasePixels();
+    // Bytes of every level
+    size_t getSize() const;
+};
 
 class Texture {
 public:
-    Texture(const std::string& filePath);
+    Texture(const std::string& filePath, TextureUsage usage = TextureUsage::Data);
+    // Uploads an image decoded elsewhere, filePath is only kept for reference
+    Texture(const std::string& filePath, const TextureImage& image);
     ~Texture();
 
+    /*
+     * Decodes the file and builds its mip chain on the CPU. With the
+     * TextureCache enabled the image is block compressed for its usage and
+     * later decodes load the cached .dds instead. .dds files load directly.
+     * Thread safe, the result is invalid (and the error logged) if the file
+     * can't be decoded.
+     */
+    static TextureImage decode(const std::string& filePath, TextureUsage usage = TextureUsage::Data);
+
+    // BC1/BC3 need EXT_texture_compression_s3tc, the rest is core in OpenGL 4.2
+    static bool isFormatSupported(TextureFormat format);
+
     // Bindless texture methods
     GLuint64 getHandle() const { return m_handle; }
     GLuint getTextureID() const { return m_textureID; }
     bool isValid() const { return m_handle != 0; }
     const std::string& getFilePath() const { return m_filePath; }
+    TextureFormat getFormat() const { return m_format; }
+    // GPU memory of every level
+    size_t getMemorySize() const { return m_memorySize; }
+
+    /*
+     * GPU copy of the smallest mip levels, at most maxSize texels on a side.
+     * Stands in for the texture while it is evicted, see MaterialManager::updateResidency.
+     * @return nullptr if the texture already fits.
+     */
+    std::shared_ptr<Texture> createMipTail(int maxSize) const;
+    // Whether createMipTail(maxSize) has levels to keep
+    bool hasMipTail(int maxSize) const {
+        return m_textureID != 0 && m_levelCount > 1 && (m_width > maxSize || m_height > maxSize);
+    }
 
     void makeResident();
     void makeNonResident();
@@ -22,6 +105,19 @@ private:
     GLuint64 m_handle;
     bool m_isResident;
     std::string m_filePath;
+    TextureFormat m_format = TextureFormat::Uncompressed;
+    GLenum m_internalFormat = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_channels = 0;
+    int m_levelCount = 0;
+    size_t m_memorySize = 0;
+
+    // Empty texture for createMipTail() to fill
+    Texture();
 
-    void createTexture(const std::string& filePath);
+    void createTexture(const TextureImage& image);
+    // Wrapping, filtering and swizzle of the bound texture
+    void applySamplerState();
+    void createHandle();
 };
@@ -0,0 +1,166 @@
+#include "assetStreamer.h"
+#include "resourceLoader.h"
+
+#include "../renderer/renderer.h"
+#include "../scene/scene.h"
+#include "../system/jobSystem.h"
+#include "../debugging/profiler.h"
+
+#include <iostream>
+
+AssetStreamer::AssetStreamer(Renderer& renderer, entt::registry& registry)
+    : m_renderer(renderer), m_registry(registry) {}
+
+void AssetStreamer::streamScene(Scene& scene) {
+    MaterialManager::getInstance().setAsyncTextureLoading(true);
+
+    for (EntityMeshDefinition& meshDef : scene.meshEntityPairs) {
+        streamMesh(meshDef);
+    }
+    for (InstancedMeshGroup& instanceGroup : scene.instancedMeshGroups) {
+        streamInstancedGroup(instanceGroup);
+    }
+
+    // Uploaded meshes are owned by the renderer now
+    scene.meshEntityPairs.clear();
+}
+
+void AssetStreamer::streamMesh(EntityMeshDefinition& meshDef) {
+    PendingMesh pending;
+    pending.entities.push_back(meshDef.entity);
+    pending.sourcePath = meshDef.sourcePath;
+    if (!pending.sourcePath.empty()) {
+        std::string path = pending.sourcePath;
+        pending.decode = JobSystem::getInstance().submit([path]() {
+            return std::unique_ptr<RawMeshData>(ResourceLoader::loadMesh(path));
+        });
+    } else {
+        pending.data = std::move(meshDef.rawMeshData);
+    }
+    queue(std::move(pending), *meshDef.materialDef);
+}
+
+void AssetStreamer::streamInstancedGroup(InstancedMeshGroup& instanceGroup) {
+    PendingMesh pending;
+    pending.group = SceneUtils::createInstancedMesh(m_registry, instanceGroup.entities, Mesh());
+    pending.data = std::move(instanceGroup.meshData);
+    queue(std::move(pending), *instanceGroup.materialDef);
+}
+
+void AssetStreamer::queue(PendingMesh&& pending, const MaterialDefinition& materialDef) {
+    if (m_idle) {
+        m_startTime = std::chrono::steady_clock::now();
+        m_frames = 0;
+        m_idle = false;
+    }
+
+    // Materials exist right away, their textures arrive through the MaterialManager
+    pending.materialIndex = MaterialManager::getInstance().getMaterialIndex(materialDef);
+
+    Mesh placeholder;
+    placeholder.materialIndex = pending.materialIndex;
+    for (entt::entity entity : pending.entities) {
+        m_registry.emplace_or_replace<Mesh>(entity, placeholder);
+    }
+    if (InstancedMesh* group = m_registry.try_get<InstancedMesh>(pending.group)) {
+        group->mesh = placeholder;
+    }
+
+    if (pending.decode.valid()) {
+        m_decoding.push_back(std::move(pending));
+    } else {
+        m_uploads.push_back(std::move(pending));
+    }
+}
+
+size_t AssetStreamer::uploadMesh(PendingMesh& pending) {
+    MeshVertexFormat format = pending.data->vertexFormat;
+    size_t uploadedBytes = pending.data->getVertexCount() * (m_renderer.getVertexStride(format) + m_renderer.getPositionStride(format)) +
+                           pending.data->getIndexCount() * sizeof(uint32_t);
+
+    Mesh mesh = m_renderer.initMeshBuffers(pending.data);
+    mesh.materialIndex = pending.materialIndex;
+    if (mesh.id == SIZE_MAX) {
+        // Error already logged, the entities keep drawing nothing
+        return uploadedBytes;
+    }
+
+    // Groups keep their members' levels themselves
+    if (InstancedMesh* group = m_registry.try_get<InstancedMesh>(pending.group)) {
+        group->mesh = mesh;
+    }
+
+    bool hasLods = m_renderer.getMeshLodCount(mesh.id) > 1;
+    for (entt::entity entity : pending.entities) {
+        if (m_registry.valid(entity)) {
+            m_registry.emplace_or_replace<Mesh>(entity, mesh);
+            if (hasLods && !m_registry.all_of<LOD>(entity)) {
+                m_registry.emplace<LOD>(entity);
+            }
+        }
+    }
+    return uploadedBytes;
+}
+
+void AssetStreamer::update() {
+    if (m_idle) {
+        return;
+    }
+    PROFILE_SCOPE("AssetStreamer::update");
+    MaterialManager& matManager = MaterialManager::getInstance();
+    m_frames++;
+
+    // Collect finished decodes
+    for (size_t i = 0; i < m_decoding.size();) {
+        PendingMesh& pending = m_decoding[i];
+        if (pending.decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++i;
+            continue;
+        }
+
+        pending.data = pending.decode.get();
+        if (pending.data) {
+            m_uploads.push_back(std::move(pending));
+        } else {
+            std::cerr << "[Error] AssetStreamer::update: Failed to load mesh: " << pending.sourcePath << "\n";
+        }
+        if (i + 1 != m_decoding.size()) {
+            m_decoding[i] = std::move(m_decoding.back());
+        }
+        m_decoding.pop_back();
+    }
+
+    // Uploads, meshes first so geometry shows up before its textures
+    auto start = std::chrono::steady_clock::now();
+    size_t uploadedBytes = 0;
+    size_t uploadCount = 0;
+    auto hasBudget = [&]() {
+        float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return uploadCount == 0 || (elapsedMs < m_budget.uploadMs && uploadedBytes < m_budget.uploadBytes);
+    };
+
+    while (!m_uploads.empty() && hasBudget()) {
+        uploadedBytes += uploadMesh(m_uploads.front());
+        uploadCount++;
+        m_uploads.pop_front();
+    }
+    while (matManager.hasPendingTextures() && hasBudget()) {
+        size_t textureBytes = matManager.uploadNextTexture();
+        if (textureBytes == 0) {
+            break; // Nothing decoded yet
+        }
+        uploadedBytes += textureBytes;
+        uploadCount++;
+    }
+    matManager.updateMaterialBuffer();
+
+    if (isIdle()) {
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+        std::cout << "[Info] AssetStreamer: All assets resident after " << totalMs << " ms (" << m_frames << " frames)\n";
+        m_idle = true;
+    }
+}
+
+bool AssetStreamer::isIdle() const {
+    return m_decoding.empty() && m_uploads.empty() && !MaterialManager::getInstance().hasPendingTextures();
+}
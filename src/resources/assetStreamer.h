@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../components/mesh.h"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+
+class Renderer;
+class Scene;
+
+// Main thread work per frame, at least one upload always goes through
+struct StreamingBudget {
+    float uploadMs = 2.0f;
+    size_t uploadBytes = 64 * 1024 * 1024;
+};
+
+/*
+ * Streams a scene's meshes and textures in after the first frame.
+ *
+ * Mesh files (EntityMeshDefinition::sourcePath) and textures are decoded on
+ * the job system, the OpenGL uploads run in update() on the main thread
+ * within a per frame budget. Entities hold a placeholder Mesh, which draws
+ * nothing, until their data is uploaded. Instanced groups become an
+ * InstancedMesh right away, with the placeholder as its mesh.
+ */
+class AssetStreamer {
+public:
+    AssetStreamer(Renderer& renderer, entt::registry& registry);
+
+    void setBudget(const StreamingBudget& budget) { m_budget = budget; }
+
+    /*
+     * Takes over the scene's meshEntityPairs and instancedMeshGroups and turns
+     * on async texture loading in the MaterialManager.
+     */
+    void streamScene(Scene& scene);
+
+    void streamMesh(EntityMeshDefinition& meshDef);
+    void streamInstancedGroup(InstancedMeshGroup& instanceGroup);
+
+    // Main thread, once per frame
+    void update();
+
+    bool isIdle() const;
+    size_t getPendingCount() const { return m_decoding.size() + m_uploads.size(); }
+
+private:
+    struct PendingMesh {
+        std::vector<entt::entity> entities;
+        entt::entity group = entt::null;    // InstancedMesh drawing the mesh, its members are not in entities
+        uint32_t materialIndex = 0;
+        std::unique_ptr<RawMeshData> data;
+        std::future<std::unique_ptr<RawMeshData>> decode; // Valid while the file is decoding
+        std::string sourcePath;
+    };
+
+    void queue(PendingMesh&& pending, const MaterialDefinition& materialDef);
+    size_t uploadMesh(PendingMesh& pending);
+
+    Renderer& m_renderer;
+    entt::registry& m_registry;
+    StreamingBudget m_budget;
+
+    std::vector<PendingMesh> m_decoding;
+    std::deque<PendingMesh> m_uploads;
+
+    // Start of the current streaming burst, reported once everything is resident
+    std::chrono::steady_clock::time_point m_startTime;
+    uint32_t m_frames = 0;
+    bool m_idle = true;
+};
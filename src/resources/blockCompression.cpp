@@ -0,0 +1,763 @@
+#include "blockCompression.h"
+
+#include "../system/jobSystem.h"
+#include "../debugging/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace {
+    // Blocks per level above which encode() splits block rows across the job system
+    constexpr size_t PARALLEL_BLOCK_COUNT = 1024;
+
+    // BC7 4 bit index interpolation weights, out of 64
+    constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    /*
+     * Block access
+     */
+
+    // 4x4 RGBA texels at block (blockX, blockY), gray sources are replicated into RGB
+    void fetchBlock(const unsigned char* pixels, int width, int height, int channels,
+                    int blockX, int blockY, uint8_t block[16][4]) {
+        for (int y = 0; y < 4; ++y) {
+            int sy = std::min(blockY * 4 + y, height - 1);
+            for (int x = 0; x < 4; ++x) {
+                int sx = std::min(blockX * 4 + x, width - 1);
+                const unsigned char* p = pixels + (static_cast<size_t>(sy) * width + sx) * channels;
+                uint8_t* texel = block[y * 4 + x];
+                switch (channels) {
+                    case 1: texel[0] = texel[1] = texel[2] = p[0]; texel[3] = 255; break;
+                    case 2: texel[0] = texel[1] = texel[2] = p[0]; texel[3] = p[1]; break;
+                    case 3: texel[0] = p[0]; texel[1] = p[1]; texel[2] = p[2]; texel[3] = 255; break;
+                    default: std::memcpy(texel, p, 4); break;
+                }
+            }
+        }
+    }
+
+    void storeBlock(const uint8_t block[16][4], int blockX, int blockY, int width, int height, unsigned char* rgba) {
+        for (int y = 0; y < 4 && blockY * 4 + y < height; ++y) {
+            for (int x = 0; x < 4 && blockX * 4 + x < width; ++x) {
+                size_t offset = (static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x) * 4;
+                std::memcpy(rgba + offset, block[y * 4 + x], 4);
+            }
+        }
+    }
+
+    // Mean and dominant direction (unit length, or zero for a flat block) of the first N channels
+    template <int N>
+    void fitLine(const uint8_t block[16][4], float mean[4], float axis[4]) {
+        for (int c = 0; c < N; ++c) {
+            float sum = 0.0f;
+            for (int i = 0; i < 16; ++i) {
+                sum += block[i][c];
+            }
+            mean[c] = sum / 16.0f;
+        }
+
+        float covariance[N][N] = {};
+        for (int i = 0; i < 16; ++i) {
+            float d[N];
+            for (int c = 0; c < N; ++c) {
+                d[c] = block[i][c] - mean[c];
+            }
+            for (int r = 0; r < N; ++r) {
+                for (int c = 0; c < N; ++c) {
+                    covariance[r][c] += d[r] * d[c];
+                }
+            }
+        }
+
+        // Power iteration, starting from the row of the channel with the most variance
+        int start = 0;
+        for (int c = 1; c < N; ++c) {
+            if (covariance[c][c] > covariance[start][start]) {
+                start = c;
+            }
+        }
+        float v[N];
+        for (int c = 0; c < N; ++c) {
+            v[c] = covariance[start][c];
+        }
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            float next[N] = {};
+            float largest = 0.0f;
+            for (int r = 0; r < N; ++r) {
+                for (int c = 0; c < N; ++c) {
+                    next[r] += covariance[r][c] * v[c];
+                }
+                largest = std::max(largest, std::fabs(next[r]));
+            }
+            if (largest < 1e-6f) {
+                break;
+            }
+            for (int c = 0; c < N; ++c) {
+                v[c] = next[c] / largest;
+            }
+        }
+
+        float length = 0.0f;
+        for (int c = 0; c < N; ++c) {
+            length += v[c] * v[c];
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < N; ++c) {
+            axis[c] = length > 1e-6f ? v[c] / length : 0.0f;
+        }
+    }
+
+    // Endpoints on the fitted line spanning the block's projections
+    template <int N>
+    void fitEndpoints(const uint8_t block[16][4], float low[4], float high[4]) {
+        float mean[4], axis[4];
+        fitLine<N>(block, mean, axis);
+
+        float minT = std::numeric_limits<float>::max();
+        float maxT = -std::numeric_limits<float>::max();
+        for (int i = 0; i < 16; ++i) {
+            float t = 0.0f;
+            for (int c = 0; c < N; ++c) {
+                t += (block[i][c] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        for (int c = 0; c < N; ++c) {
+            low[c] = std::clamp(mean[c] + minT * axis[c], 0.0f, 255.0f);
+            high[c] = std::clamp(mean[c] + maxT * axis[c], 0.0f, 255.0f);
+        }
+    }
+
+    /*
+     * Least squares endpoints for fixed interpolation weights.
+     * weights[i] is the share of endpoint a for texel i.
+     * @return false if the system is singular (all texels on one weight).
+     */
+    template <int N>
+    bool solveEndpoints(const uint8_t block[16][4], const float weights[16], float a[4], float b[4]) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (int i = 0; i < 16; ++i) {
+            float wa = weights[i];
+            float wb = 1.0f - wa;
+            aa += wa * wa;
+            ab += wa * wb;
+            bb += wb * wb;
+            for (int c = 0; c < N; ++c) {
+                ax[c] += wa * block[i][c];
+                bx[c] += wb * block[i][c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f) {
+            return false;
+        }
+        for (int c = 0; c < N; ++c) {
+            a[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+            b[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    struct BitWriter {
+        uint8_t* out;
+        int position = 0;
+
+        void write(uint32_t value, int count) {
+            for (int i = 0; i < count; ++i, ++position) {
+                if ((value >> i) & 1u) {
+                    out[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+                }
+            }
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* data;
+        int position = 0;
+
+        uint32_t read(int count) {
+            uint32_t value = 0;
+            for (int i = 0; i < count; ++i, ++position) {
+                value |= static_cast<uint32_t>((data[position >> 3] >> (position & 7)) & 1u) << i;
+            }
+            return value;
+        }
+    };
+
+    /*
+     * BC1 (and the color half of BC3), always in 4 color mode
+     */
+    uint16_t packRGB565(const float color[4]) {
+        int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+        int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+        int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((std::clamp(r, 0, 31) << 11) | (std::clamp(g, 0, 63) << 5) | std::clamp(b, 0, 31));
+    }
+
+    void unpackRGB565(uint16_t color, int rgb[3]) {
+        int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    void colorPalette(uint16_t color0, uint16_t color1, bool fourColors, int palette[4][4]) {
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            if (fourColors) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            } else {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[0][3] = palette[1][3] = palette[2][3] = 255;
+        palette[3][3] = fourColors ? 255 : 0;
+    }
+
+    int pickColorIndices(const uint8_t block[16][4], uint16_t color0, uint16_t color1, uint8_t indices[16]) {
+        int palette[4][4];
+        colorPalette(color0, color1, true, palette);
+
+        int totalError = 0;
+        for (int i = 0; i < 16; ++i) {
+            int bestError = std::numeric_limits<int>::max();
+            for (int p = 0; p < 4; ++p) {
+                int error = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = block[i][c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    indices[i] = static_cast<uint8_t>(p);
+                }
+            }
+            totalError += bestError;
+        }
+        return totalError;
+    }
+
+    void encodeColorBlock(const uint8_t block[16][4], uint8_t* out) {
+        float low[4], high[4];
+        fitEndpoints<3>(block, low, high);
+
+        uint16_t color0 = packRGB565(high);
+        uint16_t color1 = packRGB565(low);
+        uint8_t indices[16];
+        int bestError = pickColorIndices(block, color0, color1, indices);
+
+        static const float COLOR_WEIGHTS[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        for (int iteration = 0; iteration < 2 && bestError > 0; ++iteration) {
+            float weights[16];
+            for (int i = 0; i < 16; ++i) {
+                weights[i] = COLOR_WEIGHTS[indices[i]];
+            }
+            float a[4], b[4];
+            if (!solveEndpoints<3>(block, weights, a, b)) {
+                break;
+            }
+
+            uint16_t refined0 = packRGB565(a);
+            uint16_t refined1 = packRGB565(b);
+            uint8_t refinedIndices[16];
+            int error = pickColorIndices(block, refined0, refined1, refinedIndices);
+            if (error >= bestError) {
+                break;
+            }
+            bestError = error;
+            color0 = refined0;
+            color1 = refined1;
+            std::memcpy(indices, refinedIndices, sizeof(indices));
+        }
+
+        // 4 color mode needs color0 > color1, swapping maps indices 0<->1 and 2<->3
+        if (color0 < color1) {
+            std::swap(color0, color1);
+            for (uint8_t& index : indices) {
+                index ^= 1;
+            }
+        } else if (color0 == color1) {
+            std::memset(indices, 0, sizeof(indices));
+        }
+
+        uint32_t packedIndices = 0;
+        for (int i = 0; i < 16; ++i) {
+            packedIndices |= static_cast<uint32_t>(indices[i]) << (2 * i);
+        }
+        std::memcpy(out, &color0, 2);
+        std::memcpy(out + 2, &color1, 2);
+        std::memcpy(out + 4, &packedIndices, 4);
+    }
+
+    void decodeColorBlock(const uint8_t* data, bool allowThreeColors, uint8_t block[16][4]) {
+        uint16_t color0, color1;
+        uint32_t packedIndices;
+        std::memcpy(&color0, data, 2);
+        std::memcpy(&color1, data + 2, 2);
+        std::memcpy(&packedIndices, data + 4, 4);
+
+        int palette[4][4];
+        colorPalette(color0, color1, !allowThreeColors || color0 > color1, palette);
+        for (int i = 0; i < 16; ++i) {
+            const int* color = palette[(packedIndices >> (2 * i)) & 3];
+            for (int c = 0; c < 4; ++c) {
+                block[i][c] = static_cast<uint8_t>(color[c]);
+            }
+        }
+    }
+
+    /*
+     * BC4 (and the alpha half of BC3, both halves of BC5), 8 value mode
+     */
+    void encodeChannelBlock(const uint8_t block[16][4], int channel, uint8_t* out) {
+        int low = 255, high = 0;
+        for (int i = 0; i < 16; ++i) {
+            low = std::min<int>(low, block[i][channel]);
+            high = std::max<int>(high, block[i][channel]);
+        }
+
+        out[0] = static_cast<uint8_t>(high);
+        out[1] = static_cast<uint8_t>(low);
+        std::memset(out + 2, 0, 6);
+        if (high == low) {
+            return;
+        }
+
+        int palette[8] = {high, low};
+        for (int i = 2; i < 8; ++i) {
+            palette[i] = ((8 - i) * high + (i - 1) * low + 3) / 7;
+        }
+
+        uint64_t packedIndices = 0;
+        for (int i = 0; i < 16; ++i) {
+            int bestIndex = 0;
+            int bestError = std::numeric_limits<int>::max();
+            for (int p = 0; p < 8; ++p) {
+                int error = std::abs(block[i][channel] - palette[p]);
+                if (error < bestError) {
+                    bestError = error;
+                    bestIndex = p;
+                }
+            }
+            packedIndices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+        }
+        std::memcpy(out + 2, &packedIndices, 6);
+    }
+
+    void decodeChannelBlock(const uint8_t* data, int channel, uint8_t block[16][4]) {
+        int palette[8] = {data[0], data[1]};
+        if (palette[0] > palette[1]) {
+            for (int i = 2; i < 8; ++i) {
+                palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1] + 3) / 7;
+            }
+        } else {
+            for (int i = 2; i < 6; ++i) {
+                palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1] + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t packedIndices = 0;
+        std::memcpy(&packedIndices, data + 2, 6);
+        for (int i = 0; i < 16; ++i) {
+            block[i][channel] = static_cast<uint8_t>(palette[(packedIndices >> (3 * i)) & 7]);
+        }
+    }
+
+    /*
+     * BC7 mode 6: RGBA 7 bit endpoints with a p-bit each, 4 bit indices
+     */
+    struct Mode6Endpoints {
+        int quantized[2][4];  // 7 bit
+        int pBits[2];
+
+        int value(int endpoint, int channel) const {
+            return (quantized[endpoint][channel] << 1) | pBits[endpoint];
+        }
+    };
+
+    Mode6Endpoints quantizeMode6(const float a[4], const float b[4], int pBit0, int pBit1) {
+        Mode6Endpoints endpoints;
+        endpoints.pBits[0] = pBit0;
+        endpoints.pBits[1] = pBit1;
+        for (int c = 0; c < 4; ++c) {
+            endpoints.quantized[0][c] = std::clamp(static_cast<int>((a[c] - pBit0) * 0.5f + 0.5f), 0, 127);
+            endpoints.quantized[1][c] = std::clamp(static_cast<int>((b[c] - pBit1) * 0.5f + 0.5f), 0, 127);
+        }
+        return endpoints;
+    }
+
+    int pickMode6Indices(const uint8_t block[16][4], const Mode6Endpoints& endpoints, uint8_t indices[16]) {
+        int palette[16][4];
+        for (int p = 0; p < 16; ++p) {
+            for (int c = 0; c < 4; ++c) {
+                palette[p][c] = ((64 - BC7_WEIGHTS[p]) * endpoints.value(0, c) + BC7_WEIGHTS[p] * endpoints.value(1, c) + 32) >> 6;
+            }
+        }
+
+        // The palette lies on a line, only the entries next to each texel's projection are tested
+        int direction[4];
+        int lengthSquared = 0;
+        for (int c = 0; c < 4; ++c) {
+            direction[c] = palette[15][c] - palette[0][c];
+            lengthSquared += direction[c] * direction[c];
+        }
+        const float scale = lengthSquared > 0 ? 15.0f / lengthSquared : 0.0f;
+
+        int totalError = 0;
+        for (int i = 0; i < 16; ++i) {
+            int projection = 0;
+            for (int c = 0; c < 4; ++c) {
+                projection += (block[i][c] - palette[0][c]) * direction[c];
+            }
+            int nearest = std::clamp(static_cast<int>(projection * scale + 0.5f), 0, 15);
+
+            int bestError = std::numeric_limits<int>::max();
+            for (int p = std::max(nearest - 1, 0); p <= std::min(nearest + 1, 15); ++p) {
+                int error = 0;
+                for (int c = 0; c < 4; ++c) {
+                    int d = block[i][c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    indices[i] = static_cast<uint8_t>(p);
+                }
+            }
+            totalError += bestError;
+        }
+        return totalError;
+    }
+
+    // Best of the four p-bit combinations for a pair of float endpoints
+    int fitMode6(const uint8_t block[16][4], const float a[4], const float b[4],
+                 Mode6Endpoints& best, uint8_t indices[16]) {
+        int bestError = std::numeric_limits<int>::max();
+        for (int pBits = 0; pBits < 4; ++pBits) {
+            Mode6Endpoints endpoints = quantizeMode6(a, b, pBits & 1, pBits >> 1);
+            uint8_t candidate[16];
+            int error = pickMode6Indices(block, endpoints, candidate);
+            if (error < bestError) {
+                bestError = error;
+                best = endpoints;
+                std::memcpy(indices, candidate, 16);
+            }
+        }
+        return bestError;
+    }
+
+    void encodeBC7Block(const uint8_t block[16][4], uint8_t* out) {
+        float low[4], high[4];
+        fitEndpoints<4>(block, low, high);
+
+        Mode6Endpoints endpoints;
+        uint8_t indices[16];
+        int bestError = fitMode6(block, low, high, endpoints, indices);
+
+        for (int iteration = 0; iteration < 2 && bestError > 0; ++iteration) {
+            float weights[16];
+            for (int i = 0; i < 16; ++i) {
+                weights[i] = 1.0f - BC7_WEIGHTS[indices[i]] / 64.0f;
+            }
+            float a[4], b[4];
+            if (!solveEndpoints<4>(block, weights, a, b)) {
+                break;
+            }
+
+            Mode6Endpoints refined;
+            uint8_t refinedIndices[16];
+            int error = fitMode6(block, a, b, refined, refinedIndices);
+            if (error >= bestError) {
+                break;
+            }
+            bestError = error;
+            endpoints = refined;
+            std::memcpy(indices, refinedIndices, sizeof(indices));
+        }
+
+        // The anchor (texel 0) index is stored without its top bit
+        if (indices[0] & 8) {
+            std::swap(endpoints.quantized[0], endpoints.quantized[1]);
+            std::swap(endpoints.pBits[0], endpoints.pBits[1]);
+            for (uint8_t& index : indices) {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter writer{out};
+        writer.write(1u << 6, 7);
+        for (int c = 0; c < 4; ++c) {
+            writer.write(endpoints.quantized[0][c], 7);
+            writer.write(endpoints.quantized[1][c], 7);
+        }
+        writer.write(endpoints.pBits[0], 1);
+        writer.write(endpoints.pBits[1], 1);
+        for (int i = 0; i < 16; ++i) {
+            writer.write(indices[i], i == 0 ? 3 : 4);
+        }
+    }
+
+    void decodeBC7Block(const uint8_t* data, uint8_t block[16][4]) {
+        if ((data[0] & 0x7F) != 0x40) {
+            for (int i = 0; i < 16; ++i) {
+                block[i][0] = 255; block[i][1] = 0; block[i][2] = 255; block[i][3] = 255;
+            }
+            return;
+        }
+
+        BitReader reader{data, 7};
+        Mode6Endpoints endpoints;
+        for (int c = 0; c < 4; ++c) {
+            endpoints.quantized[0][c] = static_cast<int>(reader.read(7));
+            endpoints.quantized[1][c] = static_cast<int>(reader.read(7));
+        }
+        endpoints.pBits[0] = static_cast<int>(reader.read(1));
+        endpoints.pBits[1] = static_cast<int>(reader.read(1));
+        for (int i = 0; i < 16; ++i) {
+            int weight = BC7_WEIGHTS[reader.read(i == 0 ? 3 : 4)];
+            for (int c = 0; c < 4; ++c) {
+                block[i][c] = static_cast<uint8_t>(
+                    ((64 - weight) * endpoints.value(0, c) + weight * endpoints.value(1, c) + 32) >> 6);
+            }
+        }
+    }
+
+    void encodeBlock(const uint8_t block[16][4], TextureFormat format, uint8_t* out) {
+        switch (format) {
+            case TextureFormat::BC1:
+                encodeColorBlock(block, out);
+                break;
+            case TextureFormat::BC3:
+                encodeChannelBlock(block, 3, out);
+                encodeColorBlock(block, out + 8);
+                break;
+            case TextureFormat::BC4:
+                encodeChannelBlock(block, 0, out);
+                break;
+            case TextureFormat::BC5:
+                encodeChannelBlock(block, 0, out);
+                encodeChannelBlock(block, 1, out + 8);
+                break;
+            case TextureFormat::BC7:
+                encodeBC7Block(block, out);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void decodeBlock(const uint8_t* data, TextureFormat format, uint8_t block[16][4]) {
+        std::memset(block, 0, 16 * 4);
+        for (int i = 0; i < 16; ++i) {
+            block[i][3] = 255;
+        }
+        switch (format) {
+            case TextureFormat::BC1:
+                decodeColorBlock(data, true, block);
+                break;
+            case TextureFormat::BC3:
+                decodeColorBlock(data + 8, false, block);
+                decodeChannelBlock(data, 3, block);
+                break;
+            case TextureFormat::BC4:
+                decodeChannelBlock(data, 0, block);
+                break;
+            case TextureFormat::BC5:
+                decodeChannelBlock(data, 0, block);
+                decodeChannelBlock(data + 8, 1, block);
+                break;
+            case TextureFormat::BC7:
+                decodeBC7Block(data, block);
+                break;
+            default:
+                break;
+        }
+    }
+
+    bool hasTranslucentTexels(const TextureImage& image) {
+        if (image.channels != 2 && image.channels != 4) {
+            return false;
+        }
+        size_t texelCount = static_cast<size_t>(image.width) * image.height;
+        for (size_t i = 0; i < texelCount; ++i) {
+            if (image.pixels[i * image.channels + image.channels - 1] != 255) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+size_t BlockCompression::getBlockSize(TextureFormat format) {
+    switch (format) {
+        case TextureFormat::BC1:
+        case TextureFormat::BC4:
+            return 8;
+        case TextureFormat::BC3:
+        case TextureFormat::BC5:
+        case TextureFormat::BC7:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+size_t BlockCompression::getLevelSize(TextureFormat format, int width, int height) {
+    size_t blocksX = static_cast<size_t>(std::max(1, (width + 3) / 4));
+    size_t blocksY = static_cast<size_t>(std::max(1, (height + 3) / 4));
+    return blocksX * blocksY * getBlockSize(format);
+}
+
+int BlockCompression::getChannelCount(TextureFormat format) {
+    switch (format) {
+        case TextureFormat::BC1: return 3;
+        case TextureFormat::BC4: return 1;
+        case TextureFormat::BC5: return 2;
+        case TextureFormat::BC3:
+        case TextureFormat::BC7: return 4;
+        default: return 0;
+    }
+}
+
+const char* BlockCompression::getFormatName(TextureFormat format) {
+    switch (format) {
+        case TextureFormat::BC1: return "BC1";
+        case TextureFormat::BC3: return "BC3";
+        case TextureFormat::BC4: return "BC4";
+        case TextureFormat::BC5: return "BC5";
+        case TextureFormat::BC7: return "BC7";
+        default: return "Uncompressed";
+    }
+}
+
+TextureFormat BlockCompression::chooseFormat(TextureUsage usage, const TextureImage& image, Quality quality) {
+    if (!image.pixels || image.channels < 1 || image.channels > 4) {
+        return TextureFormat::Uncompressed;
+    }
+    if (usage == TextureUsage::Normal && image.channels >= 2) {
+        return TextureFormat::BC5;
+    }
+    if (usage == TextureUsage::Height || usage == TextureUsage::Normal || image.channels == 1) {
+        return TextureFormat::BC4;
+    }
+    if (quality == Quality::High) {
+        return TextureFormat::BC7;
+    }
+    return hasTranslucentTexels(image) ? TextureFormat::BC3 : TextureFormat::BC1;
+}
+
+std::vector<unsigned char> BlockCompression::encode(const unsigned char* pixels, int width, int height, int channels,
+                                                    TextureFormat format) {
+    const int blocksX = std::max(1, (width + 3) / 4);
+    const int blocksY = std::max(1, (height + 3) / 4);
+    const size_t blockSize = getBlockSize(format);
+    std::vector<unsigned char> blocks(static_cast<size_t>(blocksX) * blocksY * blockSize);
+    if (blockSize == 0 || !pixels) {
+        return blocks;
+    }
+
+    auto encodeRow = [&](size_t blockY) {
+        uint8_t block[16][4];
+        unsigned char* out = blocks.data() + blockY * blocksX * blockSize;
+        for (int blockX = 0; blockX < blocksX; ++blockX, out += blockSize) {
+            fetchBlock(pixels, width, height, channels, blockX, static_cast<int>(blockY), block);
+            encodeBlock(block, format, out);
+        }
+    };
+
+    if (static_cast<size_t>(blocksX) * blocksY >= PARALLEL_BLOCK_COUNT) {
+        JobSystem::getInstance().parallelFor(blocksY, encodeRow);
+    } else {
+        for (int blockY = 0; blockY < blocksY; ++blockY) {
+            encodeRow(blockY);
+        }
+    }
+    return blocks;
+}
+
+std::vector<unsigned char> BlockCompression::decode(const unsigned char* blocks, int width, int height, TextureFormat format) {
+    std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+    const size_t blockSize = getBlockSize(format);
+    if (blockSize == 0) {
+        return rgba;
+    }
+
+    const int blocksX = std::max(1, (width + 3) / 4);
+    const int blocksY = std::max(1, (height + 3) / 4);
+    uint8_t block[16][4];
+    for (int blockY = 0; blockY < blocksY; ++blockY) {
+        for (int blockX = 0; blockX < blocksX; ++blockX, blocks += blockSize) {
+            decodeBlock(blocks, format, block);
+            storeBlock(block, blockX, blockY, width, height, rgba.data());
+        }
+    }
+    return rgba;
+}
+
+double BlockCompression::measurePSNR(const unsigned char* pixels, int width, int height, int channels,
+                                     const unsigned char* blocks, TextureFormat format) {
+    std::vector<unsigned char> decoded = decode(blocks, width, height, format);
+    const int comparedChannels = format == TextureFormat::BC1 ? 3 : getChannelCount(format);
+
+    const int blocksX = std::max(1, (width + 3) / 4);
+    const int blocksY = std::max(1, (height + 3) / 4);
+    uint8_t source[16][4];
+    double squaredError = 0.0;
+    for (int blockY = 0; blockY < blocksY; ++blockY) {
+        for (int blockX = 0; blockX < blocksX; ++blockX) {
+            fetchBlock(pixels, width, height, channels, blockX, blockY, source);
+            for (int y = 0; y < 4 && blockY * 4 + y < height; ++y) {
+                for (int x = 0; x < 4 && blockX * 4 + x < width; ++x) {
+                    const unsigned char* texel = decoded.data() + (static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x) * 4;
+                    for (int c = 0; c < comparedChannels; ++c) {
+                        double d = static_cast<double>(source[y * 4 + x][c]) - texel[c];
+                        squaredError += d * d;
+                    }
+                }
+            }
+        }
+    }
+
+    double meanSquaredError = squaredError / (static_cast<double>(width) * height * comparedChannels);
+    if (meanSquaredError <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+bool BlockCompression::compress(TextureImage& image, TextureFormat format) {
+    if (!image.pixels || image.isCompressed() || getBlockSize(format) == 0) {
+        return false;
+    }
+    PROFILE_SCOPE("BlockCompression::compress");
+
+    std::vector<std::vector<unsigned char>> blockLevels;
+    blockLevels.reserve(image.mipLevels.size() + 1);
+    blockLevels.push_back(encode(image.pixels, image.width, image.height, image.channels, format));
+
+    int width = image.width;
+    int height = image.height;
+    for (const std::vector<unsigned char>& level : image.mipLevels) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        blockLevels.push_back(encode(level.data(), width, height, image.channels, format));
+    }
+
+    image.releasePixels();
+    image.blockLevels = std::move(blockLevels);
+    image.format = format;
+    image.channels = getChannelCount(format);
+    return true;
+}
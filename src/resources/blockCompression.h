@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../renderer/texture.h"
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * CPU block compression for the texture import step (see TextureCache).
+ *
+ * Endpoints come from the principal axis of each 4x4 block and are refined
+ * with a least squares pass over the chosen indices. BC7 is encoded in mode 6
+ * only (one RGBA subset, 4 bit indices), which every BC7 decoder handles.
+ * Blocks at the right/bottom edge repeat the last row and column.
+ */
+namespace BlockCompression {
+    enum class Quality {
+        Fast,   // BC1 (opaque) / BC3 (alpha) for color and data maps
+        High,   // BC7 for color and data maps
+    };
+
+    size_t getBlockSize(TextureFormat format);
+    size_t getLevelSize(TextureFormat format, int width, int height);
+    // Channels the format stores, what TextureImage::channels becomes after compress()
+    int getChannelCount(TextureFormat format);
+    const char* getFormatName(TextureFormat format);
+
+    /*
+     * Normal maps go to BC5, height and single channel maps to BC4, color and
+     * data maps to BC1/BC3 or BC7 depending on quality and alpha.
+     */
+    TextureFormat chooseFormat(TextureUsage usage, const TextureImage& image, Quality quality);
+
+    // Encodes one level, pixels are tightly packed with 1-4 channels
+    std::vector<unsigned char> encode(const unsigned char* pixels, int width, int height, int channels, TextureFormat format);
+
+    // Back to tightly packed RGBA8, missing channels read 0 (alpha 255). BC7 blocks other than mode 6 decode to magenta.
+    std::vector<unsigned char> decode(const unsigned char* blocks, int width, int height, TextureFormat format);
+
+    /*
+     * PSNR in dB of the encoded level against its source, over the channels the format keeps.
+     * @return Infinity for a lossless result.
+     */
+    double measurePSNR(const unsigned char* pixels, int width, int height, int channels,
+                       const unsigned char* blocks, TextureFormat format);
+
+    // Encodes level 0 and every mip level, pixels and mipLevels are released
+    bool compress(TextureImage& image, TextureFormat format);
+}
@@ -0,0 +1,107 @@
+#include "cacheFile.h"
+#include "mappedFile.h"
+
+#include "../debugging/profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+uint64_t CacheFile::hashBytes(const uint8_t* data, size_t size, uint64_t hash) {
+    constexpr uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+    auto mix = [](uint64_t value) {
+        value ^= value >> 32;
+        value *= 0xD6E8FEB86659FD93ull;
+        return value ^ (value >> 32);
+    };
+
+    hash ^= size * PRIME;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ mix(word)) * PRIME;
+    }
+
+    uint64_t tail = 0;
+    if (i < size) {
+        std::memcpy(&tail, data + i, size - i);
+    }
+    return mix((hash ^ mix(tail)) * PRIME);
+}
+
+uint64_t CacheFile::hashString(const std::string& value) {
+    return hashBytes(reinterpret_cast<const uint8_t*>(value.data()), value.size(), 0);
+}
+
+uint64_t CacheFile::hashFiles(const std::vector<std::string>& paths) {
+    PROFILE_SCOPE("CacheFile::hashFiles");
+    uint64_t hash = 0;
+    for (const std::string& path : paths) {
+        MappedFile file;
+        if (!file.open(path)) {
+            return 0;
+        }
+        hash = hashBytes(file.data(), file.size(), hash);
+    }
+    return hash;
+}
+
+std::string CacheFile::normalizePath(const std::string& path) {
+    std::error_code error;
+    fs::path absolutePath = fs::absolute(path, error);
+    return (error ? fs::path(path) : absolutePath).lexically_normal().generic_string();
+}
+
+std::string CacheFile::entryPath(const std::string& directory, const std::string& normalizedSource, const char* extension) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hashString(normalizedSource)));
+    return (fs::path(directory) / (std::string(name) + extension)).string();
+}
+
+bool CacheFile::querySource(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code error;
+    size = fs::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    mtime = static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+    return !error;
+}
+
+bool CacheFile::writeAtomic(const std::string& path, const void* data, size_t size) {
+    std::error_code error;
+    fs::create_directories(fs::path(path).parent_path(), error);
+
+    std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    // Closed explicitly, a flush that fails (disk full) must not rename a truncated file over the entry
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    file.close();
+    if (file.fail()) {
+        std::cerr << "[Error] CacheFile::writeAtomic: Failed to write " << tempPath << "\n";
+        fs::remove(tempPath, error);
+        return false;
+    }
+    fs::rename(tempPath, path, error);
+    if (error) {
+        std::cerr << "[Error] CacheFile::writeAtomic: Failed to replace " << path << ": " << error.message() << "\n";
+        fs::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+void CacheFile::clearDirectory(const std::string& directory, const char* extension) {
+    std::error_code error;
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory, error)) {
+        if (entry.path().extension() == extension) {
+            fs::remove(entry.path(), error);
+        }
+    }
+}
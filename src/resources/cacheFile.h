@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Helpers shared by the on-disk import caches (MeshCache, TextureCache):
+ * path keys, source validation and atomic writes.
+ */
+namespace CacheFile {
+    // 64 bit multiply-xorshift hash, 8 bytes per step
+    uint64_t hashBytes(const uint8_t* data, size_t size, uint64_t hash);
+    uint64_t hashString(const std::string& value);
+
+    // Content hash over every file in order, 0 when one can't be read
+    uint64_t hashFiles(const std::vector<std::string>& paths);
+
+    // Absolute, lexically normal path with forward slashes
+    std::string normalizePath(const std::string& path);
+
+    // <directory>/<hash of normalizedSource><extension>
+    std::string entryPath(const std::string& directory, const std::string& normalizedSource, const char* extension);
+
+    bool querySource(const std::string& path, uint64_t& size, int64_t& mtime);
+
+    /*
+     * Writes next to the target and renames, readers never see a partial file.
+     * The temp name is per thread since two jobs can import the same source at once.
+     */
+    bool writeAtomic(const std::string& path, const void* data, size_t size);
+
+    // Deletes every file with the extension in directory
+    void clearDirectory(const std::string& directory, const char* extension);
+}
@@ -0,0 +1,299 @@
+#include "ddsFile.h"
+#include "blockCompression.h"
+#include "mappedFile.h"
+
+#include "../renderer/mipGenerator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    constexpr uint32_t makeFourCC(char a, char b, char c, char d) {
+        return static_cast<uint32_t>(static_cast<uint8_t>(a)) | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+               (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+    }
+
+    constexpr uint32_t DDS_MAGIC = makeFourCC('D', 'D', 'S', ' ');
+
+    constexpr uint32_t DDSD_CAPS = 0x1;
+    constexpr uint32_t DDSD_HEIGHT = 0x2;
+    constexpr uint32_t DDSD_WIDTH = 0x4;
+    constexpr uint32_t DDSD_PIXELFORMAT = 0x1000;
+    constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    constexpr uint32_t DDSD_LINEARSIZE = 0x80000;
+    constexpr uint32_t DDPF_FOURCC = 0x4;
+    constexpr uint32_t DDSCAPS_COMPLEX = 0x8;
+    constexpr uint32_t DDSCAPS_TEXTURE = 0x1000;
+    constexpr uint32_t DDSCAPS_MIPMAP = 0x400000;
+    constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+    // DXGI_FORMAT values
+    constexpr uint32_t DXGI_BC1_UNORM = 71, DXGI_BC1_UNORM_SRGB = 72;
+    constexpr uint32_t DXGI_BC3_UNORM = 77, DXGI_BC3_UNORM_SRGB = 78;
+    constexpr uint32_t DXGI_BC4_UNORM = 80;
+    constexpr uint32_t DXGI_BC5_UNORM = 83;
+    constexpr uint32_t DXGI_BC7_UNORM = 98, DXGI_BC7_UNORM_SRGB = 99;
+
+    struct PixelFormat {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t rgbBitCount;
+        uint32_t masks[4];
+    };
+
+    struct Header {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        PixelFormat pixelFormat;
+        uint32_t caps[4];
+        uint32_t reserved2;
+    };
+    static_assert(sizeof(Header) == 124, "DDS header layout");
+
+    struct HeaderDX10 {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    TextureFormat formatFromFourCC(uint32_t fourCC) {
+        switch (fourCC) {
+            case makeFourCC('D', 'X', 'T', '1'): return TextureFormat::BC1;
+            case makeFourCC('D', 'X', 'T', '5'): return TextureFormat::BC3;
+            case makeFourCC('A', 'T', 'I', '1'):
+            case makeFourCC('B', 'C', '4', 'U'): return TextureFormat::BC4;
+            case makeFourCC('A', 'T', 'I', '2'):
+            case makeFourCC('B', 'C', '5', 'U'): return TextureFormat::BC5;
+            default: return TextureFormat::Uncompressed;
+        }
+    }
+
+    TextureFormat formatFromDXGI(uint32_t dxgiFormat) {
+        switch (dxgiFormat) {
+            case DXGI_BC1_UNORM: case DXGI_BC1_UNORM_SRGB: return TextureFormat::BC1;
+            case DXGI_BC3_UNORM: case DXGI_BC3_UNORM_SRGB: return TextureFormat::BC3;
+            case DXGI_BC4_UNORM: return TextureFormat::BC4;
+            case DXGI_BC5_UNORM: return TextureFormat::BC5;
+            case DXGI_BC7_UNORM: case DXGI_BC7_UNORM_SRGB: return TextureFormat::BC7;
+            default: return TextureFormat::Uncompressed;
+        }
+    }
+
+    uint32_t formatToDXGI(TextureFormat format) {
+        switch (format) {
+            case TextureFormat::BC1: return DXGI_BC1_UNORM;
+            case TextureFormat::BC3: return DXGI_BC3_UNORM;
+            case TextureFormat::BC4: return DXGI_BC4_UNORM;
+            case TextureFormat::BC5: return DXGI_BC5_UNORM;
+            case TextureFormat::BC7: return DXGI_BC7_UNORM;
+            default: return 0;
+        }
+    }
+
+    // Reverses the first rows texel rows of a BC1 color block, one index byte per row after the endpoints
+    void flipColorBlock(uint8_t* block, int rows) {
+        std::reverse(block + 4, block + 4 + rows);
+    }
+
+    // Same for a BC4 block (also BC3 alpha and BC5 channels), 12 index bits per row after the endpoints
+    void flipChannelBlock(uint8_t* block, int rows) {
+        uint64_t indices = 0;
+        std::memcpy(&indices, block + 2, 6);
+        uint64_t flipped = indices;
+        for (int row = 0; row < rows; ++row) {
+            uint64_t bits = (indices >> (12 * row)) & 0xFFF;
+            int target = rows - 1 - row;
+            flipped = (flipped & ~(0xFFFull << (12 * target))) | (bits << (12 * target));
+        }
+        std::memcpy(block + 2, &flipped, 6);
+    }
+
+    /*
+     * D3D stores rows top-down, uploads go bottom row first. Blocks only move
+     * whole, so levels taller than a block must be a multiple of 4 high. BC7
+     * partitions and anchors don't survive a flip without re-encoding.
+     */
+    bool flipToUploadOrder(TextureImage& image) {
+        if (image.format == TextureFormat::BC7) {
+            return false;
+        }
+        size_t blockSize = BlockCompression::getBlockSize(image.format);
+        int levelWidth = image.width;
+        int levelHeight = image.height;
+        for (std::vector<unsigned char>& level : image.blockLevels) {
+            if (levelHeight > 4 && levelHeight % 4 != 0) {
+                return false;
+            }
+            size_t rowBytes = static_cast<size_t>((levelWidth + 3) / 4) * blockSize;
+            size_t blockRows = static_cast<size_t>((levelHeight + 3) / 4);
+            for (size_t row = 0; row < blockRows / 2; ++row) {
+                std::swap_ranges(level.begin() + row * rowBytes, level.begin() + (row + 1) * rowBytes,
+                                 level.begin() + (blockRows - 1 - row) * rowBytes);
+            }
+
+            int rows = std::min(levelHeight, 4);
+            for (size_t offset = 0; offset + blockSize <= level.size(); offset += blockSize) {
+                uint8_t* block = level.data() + offset;
+                switch (image.format) {
+                    case TextureFormat::BC1: flipColorBlock(block, rows); break;
+                    case TextureFormat::BC3: flipChannelBlock(block, rows); flipColorBlock(block + 8, rows); break;
+                    case TextureFormat::BC4: flipChannelBlock(block, rows); break;
+                    case TextureFormat::BC5: flipChannelBlock(block, rows); flipChannelBlock(block + 8, rows); break;
+                    default: return false;
+                }
+            }
+            levelWidth = std::max(1, levelWidth / 2);
+            levelHeight = std::max(1, levelHeight / 2);
+        }
+        return true;
+    }
+}
+
+bool DDSFile::isDDSPath(const std::string& path) {
+    if (path.size() < 4) {
+        return false;
+    }
+    std::string extension = path.substr(path.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension == ".dds";
+}
+
+bool DDSFile::load(const std::string& filePath, TextureImage& image, Reserved* reserved) {
+    MappedFile file;
+    if (!file.open(filePath)) {
+        std::cerr << "[Error] DDSFile::load: Failed to open " << filePath << "\n";
+        return false;
+    }
+    if (!parse(file.data(), file.size(), image, reserved)) {
+        std::cerr << "[Error] DDSFile::load: Unsupported or corrupt DDS file " << filePath << "\n";
+        return false;
+    }
+    if (!flipToUploadOrder(image)) {
+        std::cerr << "[Error] DDSFile::load: Can't flip " << filePath
+                  << " to upload order, BC7 and levels not a multiple of 4 high aren't supported\n";
+        image.blockLevels.clear();
+        image.format = TextureFormat::Uncompressed;
+        return false;
+    }
+    return true;
+}
+
+bool DDSFile::parse(const uint8_t* data, size_t size, TextureImage& image, Reserved* reserved) {
+    uint32_t magic;
+    Header header;
+    if (size < sizeof(magic) + sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&magic, data, sizeof(magic));
+    std::memcpy(&header, data + sizeof(magic), sizeof(header));
+    size_t offset = sizeof(magic) + sizeof(header);
+    if (magic != DDS_MAGIC || header.size != sizeof(Header) || header.width == 0 || header.height == 0 ||
+        header.width > 65536 || header.height > 65536) {
+        return false;
+    }
+
+    TextureFormat format = TextureFormat::Uncompressed;
+    if ((header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == makeFourCC('D', 'X', '1', '0')) {
+        HeaderDX10 headerDX10;
+        if (size - offset < sizeof(headerDX10)) {
+            return false;
+        }
+        std::memcpy(&headerDX10, data + offset, sizeof(headerDX10));
+        offset += sizeof(headerDX10);
+        if (headerDX10.resourceDimension != DDS_DIMENSION_TEXTURE2D || headerDX10.arraySize > 1) {
+            return false;
+        }
+        format = formatFromDXGI(headerDX10.dxgiFormat);
+    } else if (header.pixelFormat.flags & DDPF_FOURCC) {
+        format = formatFromFourCC(header.pixelFormat.fourCC);
+    }
+    if (format == TextureFormat::Uncompressed) {
+        return false;
+    }
+
+    int width = static_cast<int>(header.width);
+    int height = static_cast<int>(header.height);
+    int levelCount = std::clamp(static_cast<int>(header.mipMapCount), 1, MipGenerator::getLevelCount(width, height));
+
+    std::vector<std::vector<unsigned char>> blockLevels(levelCount);
+    int levelWidth = width;
+    int levelHeight = height;
+    for (std::vector<unsigned char>& level : blockLevels) {
+        size_t levelSize = BlockCompression::getLevelSize(format, levelWidth, levelHeight);
+        if (levelSize > size - offset) {
+            return false;
+        }
+        level.assign(data + offset, data + offset + levelSize);
+        offset += levelSize;
+        levelWidth = std::max(1, levelWidth / 2);
+        levelHeight = std::max(1, levelHeight / 2);
+    }
+
+    image.releasePixels();
+    image.width = width;
+    image.height = height;
+    image.format = format;
+    image.channels = BlockCompression::getChannelCount(format);
+    image.blockLevels = std::move(blockLevels);
+    if (reserved) {
+        std::copy(std::begin(header.reserved1), std::end(header.reserved1), reserved->begin());
+    }
+    return true;
+}
+
+std::vector<uint8_t> DDSFile::serialize(const TextureImage& image, const Reserved* reserved) {
+    uint32_t dxgiFormat = formatToDXGI(image.format);
+    if (dxgiFormat == 0 || image.blockLevels.empty()) {
+        return {};
+    }
+
+    Header header{};
+    header.size = sizeof(Header);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.height = static_cast<uint32_t>(image.height);
+    header.width = static_cast<uint32_t>(image.width);
+    header.pitchOrLinearSize = static_cast<uint32_t>(image.blockLevels[0].size());
+    header.mipMapCount = static_cast<uint32_t>(image.blockLevels.size());
+    if (reserved) {
+        std::copy(reserved->begin(), reserved->end(), header.reserved1);
+    }
+    header.pixelFormat.size = sizeof(PixelFormat);
+    header.pixelFormat.flags = DDPF_FOURCC;
+    header.pixelFormat.fourCC = makeFourCC('D', 'X', '1', '0');
+    header.caps[0] = DDSCAPS_TEXTURE | (image.blockLevels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+    HeaderDX10 headerDX10{};
+    headerDX10.dxgiFormat = dxgiFormat;
+    headerDX10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+    headerDX10.arraySize = 1;
+
+    size_t dataSize = 0;
+    for (const std::vector<unsigned char>& level : image.blockLevels) {
+        dataSize += level.size();
+    }
+
+    std::vector<uint8_t> bytes;
+    bytes.reserve(sizeof(DDS_MAGIC) + sizeof(header) + sizeof(headerDX10) + dataSize);
+    auto append = [&bytes](const void* data, size_t size) {
+        const uint8_t* src = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), src, src + size);
+    };
+    append(&DDS_MAGIC, sizeof(DDS_MAGIC));
+    append(&header, sizeof(header));
+    append(&headerDX10, sizeof(headerDX10));
+    for (const std::vector<unsigned char>& level : image.blockLevels) {
+        append(level.data(), level.size());
+    }
+    return bytes;
+}
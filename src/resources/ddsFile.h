@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../renderer/texture.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * DDS container for block compressed 2D textures with their mip chains.
+ *
+ * Reads DX10 headers (BC1/BC3/BC4/BC5/BC7) and the legacy DXT1, DXT5,
+ * ATI1/BC4U and ATI2/BC5U FourCCs, writes DX10 headers. Files on disk are
+ * top-down like D3D authors them, load() flips them to upload order (bottom
+ * row first, like the flipped stb_image decodes). parse() and serialize()
+ * keep upload order for the TextureCache, which only reads its own files.
+ */
+namespace DDSFile {
+    // The header's reserved words, free for the writer. TextureCache keeps its validation data here.
+    using Reserved = std::array<uint32_t, 11>;
+
+    bool isDDSPath(const std::string& path);
+
+    // Fills image.format, width, height, channels and blockLevels in upload order, errors are logged.
+    // BC7 and levels that aren't a multiple of 4 high can't be flipped and fail.
+    bool load(const std::string& filePath, TextureImage& image, Reserved* reserved = nullptr);
+
+    // Same as load() on bytes in memory without the flip, fails quietly so caches can treat it as a miss
+    bool parse(const uint8_t* data, size_t size, TextureImage& image, Reserved* reserved = nullptr);
+
+    // Empty if the image isn't block compressed
+    std::vector<uint8_t> serialize(const TextureImage& image, const Reserved* reserved = nullptr);
+}
@@ -0,0 +1,137 @@
+#include "mappedFile.h"
+
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_isEmptyFile, other.m_isEmptyFile);
+#ifdef _WIN32
+        std::swap(m_file, other.m_file);
+        std::swap(m_mapping, other.m_mapping);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "[Error] MappedFile::open: Failed to open file: " << path << "\n";
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        std::cerr << "[Error] MappedFile::open: Failed to query size of: " << path << "\n";
+        CloseHandle(file);
+        return false;
+    }
+
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    if (m_size == 0) {
+        CloseHandle(file);
+        m_isEmptyFile = true;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        std::cerr << "[Error] MappedFile::open: Failed to map file: " << path << "\n";
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        m_size = 0;
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const uint8_t*>(view);
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(static_cast<HANDLE>(m_mapping));
+    if (m_file) CloseHandle(static_cast<HANDLE>(m_file));
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+    m_isEmptyFile = false;
+}
+#else
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[Error] MappedFile::open: Failed to open file: " << path << "\n";
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        std::cerr << "[Error] MappedFile::open: Failed to query size of: " << path << "\n";
+        ::close(fd);
+        return false;
+    }
+
+    m_size = static_cast<size_t>(fileStat.st_size);
+    if (m_size == 0) {
+        ::close(fd);
+        m_isEmptyFile = true;
+        return true;
+    }
+
+    void* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        std::cerr << "[Error] MappedFile::open: Failed to map file: " << path << "\n";
+        m_size = 0;
+        return false;
+    }
+
+    // Assets are decoded front to back
+    madvise(view, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const uint8_t*>(view);
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_isEmptyFile = false;
+}
+#endif
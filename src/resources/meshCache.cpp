@@ -0,0 +1,434 @@
+#include "meshCache.h"
+#include "mappedFile.h"
+#include "cacheFile.h"
+
+#include "../debugging/profiler.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifndef MESH_CACHE_DIR
+#define MESH_CACHE_DIR "cache/meshes/"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    /*
+     * File layout, native endianness:
+     *   header, source path, sources {path, size, mtime},
+     *   meshes {present, drawMode, vertexCount, indexCount, lods, meshlets, 16 byte aligned vertices, indices},
+     *   materials {present, paths, properties}, nodes {name, transform, children, meshIndex}
+     *
+     * Bump the version whenever the layout or the importers' output changes.
+     */
+    constexpr uint32_t CACHE_MAGIC = 0x434D4746;  // "FGMC"
+    constexpr uint32_t CACHE_VERSION = 4;
+    constexpr const char* CACHE_EXTENSION = ".fgmesh";
+    constexpr size_t DATA_ALIGNMENT = 16;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexSize;
+        uint32_t sourceCount;
+        uint32_t meshCount;
+        uint32_t materialCount;
+        uint32_t nodeCount;
+        uint32_t _padding;
+        uint64_t contentHash;
+    };
+
+    std::string g_directory = MESH_CACHE_DIR;
+    bool g_enabled = true;
+
+    std::atomic<uint32_t> g_hits{0};
+    std::atomic<uint32_t> g_misses{0};
+    std::atomic<uint32_t> g_writes{0};
+    std::atomic<uint64_t> g_bytesMapped{0};
+    std::atomic<uint64_t> g_bytesWritten{0};
+
+    /*
+     * Serialization
+     */
+    struct Writer {
+        std::vector<uint8_t> bytes;
+
+        void write(const void* data, size_t size) {
+            const uint8_t* src = static_cast<const uint8_t*>(data);
+            bytes.insert(bytes.end(), src, src + size);
+        }
+
+        template <typename T>
+        void put(const T& value) { write(&value, sizeof(T)); }
+
+        void putString(const std::string& value) {
+            put(static_cast<uint32_t>(value.size()));
+            write(value.data(), value.size());
+        }
+
+        void align() { bytes.resize((bytes.size() + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1), 0); }
+    };
+
+    // Bounds checked view of the mapping, every read fails once one overruns
+    struct Reader {
+        const uint8_t* base;
+        size_t size;
+        size_t offset = 0;
+        bool ok = true;
+
+        const uint8_t* take(size_t count) {
+            if (!ok || count > size - offset) {
+                ok = false;
+                return nullptr;
+            }
+            const uint8_t* data = base + offset;
+            offset += count;
+            return data;
+        }
+
+        template <typename T>
+        T get() {
+            T value{};
+            if (const uint8_t* data = take(sizeof(T))) {
+                std::memcpy(&value, data, sizeof(T));
+            }
+            return value;
+        }
+
+        std::string getString() {
+            uint32_t length = get<uint32_t>();
+            const uint8_t* data = take(length);
+            return data ? std::string(reinterpret_cast<const char*>(data), length) : std::string();
+        }
+
+        void align() {
+            size_t aligned = (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+            take(aligned - offset);
+        }
+    };
+
+    void writeMaterial(Writer& writer, const MaterialDefinition& material) {
+        writer.putString(material.vertexShaderPath);
+        writer.putString(material.fragmentShaderPath);
+        writer.putString(material.albedoMapPath);
+        writer.putString(material.normalMapPath);
+        writer.putString(material.metallicRoughnessMapPath);
+        writer.putString(material.emissiveMapPath);
+        writer.putString(material.heightMapPath);
+        writer.put(material.albedoColor);
+        writer.put(material.emissiveColor);
+        writer.put(material.uvScale);
+        writer.put(material.heightScale);
+        writer.put(material.occlusionStrength);
+        writer.put(material.shininess);
+        writer.put(material.time);
+        writer.put(static_cast<uint8_t>(material.isDeferred));
+    }
+
+    void readMaterial(Reader& reader, MaterialDefinition& material) {
+        material.vertexShaderPath = reader.getString();
+        material.fragmentShaderPath = reader.getString();
+        material.albedoMapPath = reader.getString();
+        material.normalMapPath = reader.getString();
+        material.metallicRoughnessMapPath = reader.getString();
+        material.emissiveMapPath = reader.getString();
+        material.heightMapPath = reader.getString();
+        material.albedoColor = reader.get<glm::vec4>();
+        material.emissiveColor = reader.get<glm::vec3>();
+        material.uvScale = reader.get<glm::vec2>();
+        material.heightScale = reader.get<float>();
+        material.occlusionStrength = reader.get<float>();
+        material.shininess = reader.get<float>();
+        material.time = reader.get<float>();
+        material.isDeferred = reader.get<uint8_t>() != 0;
+    }
+}
+
+void MeshCache::setDirectory(const std::string& directory) {
+    g_directory = directory;
+}
+
+const std::string& MeshCache::getDirectory() {
+    return g_directory;
+}
+
+void MeshCache::setEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+bool MeshCache::isEnabled() {
+    return g_enabled && !g_directory.empty();
+}
+
+void MeshCache::clear() {
+    CacheFile::clearDirectory(g_directory, CACHE_EXTENSION);
+}
+
+bool MeshCache::load(const std::string& sourcePath,
+                     std::vector<std::unique_ptr<RawMeshData>>& meshes,
+                     std::vector<std::unique_ptr<MaterialDefinition>>& materialDefs,
+                     std::vector<SceneData>& nodeData) {
+    if (!isEnabled()) {
+        return false;
+    }
+    PROFILE_SCOPE("MeshCache::load");
+
+    std::string normalizedSource = CacheFile::normalizePath(sourcePath);
+    std::string cachePath = CacheFile::entryPath(g_directory, normalizedSource, CACHE_EXTENSION);
+
+    std::error_code error;
+    if (!fs::exists(cachePath, error)) {
+        g_misses++;
+        return false;
+    }
+
+    auto mapping = std::make_shared<MappedFile>();
+    if (!mapping->open(cachePath)) {
+        g_misses++;
+        return false;
+    }
+
+    Reader reader{mapping->data(), mapping->size()};
+    CacheHeader header = reader.get<CacheHeader>();
+    if (!reader.ok || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+        header.vertexSize != MESH_VERTEX_SIZE || reader.getString() != normalizedSource) {
+        g_misses++;
+        return false;
+    }
+
+    // Sources: sizes must match, a changed mtime falls back to the content hash
+    std::vector<std::string> sourceFiles(header.sourceCount);
+    bool mtimeChanged = false;
+    for (std::string& path : sourceFiles) {
+        path = reader.getString();
+        uint64_t recordedSize = reader.get<uint64_t>();
+        int64_t recordedMtime = reader.get<int64_t>();
+
+        uint64_t size;
+        int64_t mtime;
+        if (!reader.ok || !CacheFile::querySource(path, size, mtime) || size != recordedSize) {
+            g_misses++;
+            return false;
+        }
+        mtimeChanged |= mtime != recordedMtime;
+    }
+    if (mtimeChanged && CacheFile::hashFiles(sourceFiles) != header.contentHash) {
+        g_misses++;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<RawMeshData>> cachedMeshes(header.meshCount);
+    for (std::unique_ptr<RawMeshData>& mesh : cachedMeshes) {
+        if (reader.get<uint8_t>() == 0) {
+            continue;
+        }
+
+        mesh = std::make_unique<RawMeshData>();
+        mesh->drawMode = reader.get<int32_t>();
+        uint64_t vertexCount = reader.get<uint64_t>();
+        uint64_t indexCount = reader.get<uint64_t>();
+        uint32_t lodCount = reader.get<uint32_t>();
+        if (lodCount > MESH_MAX_LODS) {
+            reader.ok = false;
+            break;
+        }
+        mesh->lods.resize(lodCount);
+        for (MeshLodRange& lod : mesh->lods) {
+            lod.firstIndex = reader.get<uint32_t>();
+            lod.indexCount = reader.get<uint32_t>();
+            lod.error = reader.get<float>();
+            if (static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > indexCount) {
+                reader.ok = false;
+            }
+        }
+        uint32_t meshletCount = reader.get<uint32_t>();
+        if (meshletCount > reader.size / sizeof(Meshlet)) {
+            reader.ok = false;
+            break;
+        }
+        mesh->meshlets.resize(meshletCount);
+        for (Meshlet& meshlet : mesh->meshlets) {
+            meshlet = reader.get<Meshlet>();
+            if (static_cast<uint64_t>(meshlet.firstIndex) + meshlet.indexCount > indexCount) {
+                reader.ok = false;
+            }
+        }
+        reader.align();
+
+        // Counts are validated against the file size before anything is multiplied out
+        if (vertexCount > reader.size / (MESH_VERTEX_SIZE * sizeof(float)) || indexCount > reader.size / sizeof(uint32_t)) {
+            reader.ok = false;
+            break;
+        }
+        mesh->packed.vertices = reinterpret_cast<const float*>(reader.take(vertexCount * MESH_VERTEX_SIZE * sizeof(float)));
+        mesh->packed.indices = reinterpret_cast<const uint32_t*>(reader.take(indexCount * sizeof(uint32_t)));
+        mesh->packed.vertexCount = vertexCount;
+        mesh->packed.indexCount = indexCount;
+        mesh->packed.mapping = mapping;
+    }
+
+    std::vector<std::unique_ptr<MaterialDefinition>> cachedMaterials(header.materialCount);
+    for (std::unique_ptr<MaterialDefinition>& material : cachedMaterials) {
+        if (reader.get<uint8_t>() != 0) {
+            material = std::make_unique<MaterialDefinition>();
+            readMaterial(reader, *material);
+        }
+    }
+
+    std::vector<SceneData> cachedNodes(header.nodeCount);
+    for (SceneData& node : cachedNodes) {
+        node.name = reader.getString();
+        node.position = reader.get<glm::vec3>();
+        node.scale = reader.get<glm::vec3>();
+        node.eulerAngles = reader.get<glm::vec3>();
+
+        uint32_t childCount = reader.get<uint32_t>();
+        if (childCount > reader.size / sizeof(uint64_t)) {
+            reader.ok = false;
+            break;
+        }
+        node.children.resize(childCount);
+        for (size_t& child : node.children) {
+            child = static_cast<size_t>(reader.get<uint64_t>());
+        }
+        node.meshIndex = reader.get<int32_t>();
+    }
+
+    if (!reader.ok) {
+        std::cerr << "[Warning] MeshCache::load: Corrupt cache file " << cachePath << " for " << sourcePath << ", reimporting\n";
+        g_misses++;
+        return false;
+    }
+
+    meshes = std::move(cachedMeshes);
+    materialDefs = std::move(cachedMaterials);
+    nodeData = std::move(cachedNodes);
+    g_hits++;
+    g_bytesMapped += mapping->size();
+    return true;
+}
+
+bool MeshCache::store(const std::string& sourcePath,
+                      const std::vector<std::string>& sourceFiles,
+                      const std::vector<std::unique_ptr<RawMeshData>>& meshes,
+                      const std::vector<std::unique_ptr<MaterialDefinition>>& materialDefs,
+                      const std::vector<SceneData>& nodeData) {
+    if (!isEnabled()) {
+        return false;
+    }
+    PROFILE_SCOPE("MeshCache::store");
+
+    for (const std::unique_ptr<RawMeshData>& mesh : meshes) {
+        if (mesh && !mesh->isPacked() &&
+            (mesh->uvs.size() != mesh->vertices.size() || mesh->packedTNBFrame.size() != mesh->vertices.size())) {
+            // Renderer::initMeshBuffers rejects these too, keep parsing them so the error shows up
+            return false;
+        }
+    }
+
+    std::string normalizedSource = CacheFile::normalizePath(sourcePath);
+
+    CacheHeader header{};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.vertexSize = MESH_VERTEX_SIZE;
+    header.sourceCount = static_cast<uint32_t>(sourceFiles.size());
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.materialCount = static_cast<uint32_t>(materialDefs.size());
+    header.nodeCount = static_cast<uint32_t>(nodeData.size());
+    header.contentHash = CacheFile::hashFiles(sourceFiles);
+
+    Writer writer;
+    writer.put(header);
+    writer.putString(normalizedSource);
+
+    for (const std::string& path : sourceFiles) {
+        uint64_t size;
+        int64_t mtime;
+        if (!CacheFile::querySource(path, size, mtime)) {
+            return false;
+        }
+        writer.putString(path);
+        writer.put(size);
+        writer.put(mtime);
+    }
+
+    for (const std::unique_ptr<RawMeshData>& mesh : meshes) {
+        writer.put(static_cast<uint8_t>(mesh != nullptr));
+        if (!mesh) {
+            continue;
+        }
+
+        uint64_t vertexCount = mesh->getVertexCount();
+        uint64_t indexCount = mesh->getIndexCount();
+        writer.put(static_cast<int32_t>(mesh->drawMode));
+        writer.put(vertexCount);
+        writer.put(indexCount);
+        writer.put(static_cast<uint32_t>(mesh->lods.size()));
+        for (const MeshLodRange& lod : mesh->lods) {
+            writer.put(lod.firstIndex);
+            writer.put(lod.indexCount);
+            writer.put(lod.error);
+        }
+        writer.put(static_cast<uint32_t>(mesh->meshlets.size()));
+        for (const Meshlet& meshlet : mesh->meshlets) {
+            writer.put(meshlet);
+        }
+        writer.align();
+
+        // Packed in place, the same bytes initMeshBuffers would upload
+        size_t vertexOffset = writer.bytes.size();
+        writer.bytes.resize(vertexOffset + vertexCount * MESH_VERTEX_SIZE * sizeof(float));
+        mesh->packVertices(reinterpret_cast<float*>(writer.bytes.data() + vertexOffset));
+        writer.write(mesh->isPacked() ? mesh->packed.indices : mesh->indices.data(), indexCount * sizeof(uint32_t));
+    }
+
+    for (const std::unique_ptr<MaterialDefinition>& material : materialDefs) {
+        writer.put(static_cast<uint8_t>(material != nullptr));
+        if (material) {
+            writeMaterial(writer, *material);
+        }
+    }
+
+    for (const SceneData& node : nodeData) {
+        writer.putString(node.name);
+        writer.put(node.position);
+        writer.put(node.scale);
+        writer.put(node.eulerAngles);
+        writer.put(static_cast<uint32_t>(node.children.size()));
+        for (size_t child : node.children) {
+            writer.put(static_cast<uint64_t>(child));
+        }
+        writer.put(static_cast<int32_t>(node.meshIndex));
+    }
+
+    std::string cachePath = CacheFile::entryPath(g_directory, normalizedSource, CACHE_EXTENSION);
+    if (!CacheFile::writeAtomic(cachePath, writer.bytes.data(), writer.bytes.size())) {
+        return false;
+    }
+
+    g_writes++;
+    g_bytesWritten += writer.bytes.size();
+    return true;
+}
+
+MeshCache::Stats MeshCache::getStats() {
+    Stats stats;
+    stats.hits = g_hits.load();
+    stats.misses = g_misses.load();
+    stats.writes = g_writes.load();
+    stats.bytesMapped = g_bytesMapped.load();
+    stats.bytesWritten = g_bytesWritten.load();
+    return stats;
+}
+
+void MeshCache::resetStats() {
+    g_hits = 0;
+    g_misses = 0;
+    g_writes = 0;
+    g_bytesMapped = 0;
+    g_bytesWritten = 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../components/mesh.h"
+#include "scene/sceneData.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Engine-native cache of imported meshes.
+ *
+ * The first import of a model writes its meshes in the exact vertex layout
+ * Renderer::initMeshBuffers uploads, plus material definitions and glTF
+ * nodes. Later loads map the cache file and hand the renderer pointers into
+ * the mapping, so parsing, tangent generation and TBN packing are skipped.
+ *
+ * Entries are keyed by the source path. An entry is used while every file it
+ * was built from keeps its size and either its mtime or, if only the mtime
+ * changed (fresh checkout, touch), its content hash.
+ */
+namespace MeshCache {
+    struct Stats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;     // Missing or stale entries
+        uint32_t writes = 0;
+        uint64_t bytesMapped = 0;
+        uint64_t bytesWritten = 0;
+    };
+
+    // Defaults to MESH_CACHE_DIR (the build directory), changes must happen before loading
+    void setDirectory(const std::string& directory);
+    const std::string& getDirectory();
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    // Deletes every cache file in the directory
+    void clear();
+
+    /*
+     * Loads the cached import of sourcePath. Meshes come back packed (see PackedMeshData).
+     * @return false on a miss or a stale/corrupt entry, the outputs are left untouched.
+     */
+    bool load(const std::string& sourcePath,
+              std::vector<std::unique_ptr<RawMeshData>>& meshes,
+              std::vector<std::unique_ptr<MaterialDefinition>>& materialDefs,
+              std::vector<SceneData>& nodeData);
+
+    /*
+     * Writes the import of sourcePath, meshes must still hold their CPU data.
+     * @param sourceFiles - Every file the import was read from.
+     */
+    bool store(const std::string& sourcePath,
+               const std::vector<std::string>& sourceFiles,
+               const std::vector<std::unique_ptr<RawMeshData>>& meshes,
+               const std::vector<std::unique_ptr<MaterialDefinition>>& materialDefs,
+               const std::vector<SceneData>& nodeData);
+
+    Stats getStats();
+    void resetStats();
+}
@@ -0,0 +1,255 @@
+#include "meshOptimizer.h"
+
+#include "../debugging/profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+    constexpr uint32_t UNUSED = UINT32_MAX;
+
+    // Tipsify's fallback: the most recent vertex with triangles left, else the next one in input order
+    int64_t skipDeadEnd(const std::vector<uint32_t>& liveTriangles, std::vector<uint32_t>& deadEnd, size_t& cursor) {
+        while (!deadEnd.empty()) {
+            uint32_t vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                return vertex;
+            }
+        }
+        for (; cursor < liveTriangles.size(); ++cursor) {
+            if (liveTriangles[cursor] > 0) {
+                return static_cast<int64_t>(cursor);
+            }
+        }
+        return -1;
+    }
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    CacheStats stats;
+    stats.triangles = static_cast<uint32_t>(indexCount / 3);
+
+    // A vertex is still cached while fewer than CACHE_SIZE misses happened since it was loaded
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t time = CACHE_SIZE + 1;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t vertex = indices[i];
+        if (time - loadedAt[vertex] > CACHE_SIZE) {
+            loadedAt[vertex] = time++;
+            stats.misses++;
+        }
+        if (!referenced[vertex]) {
+            referenced[vertex] = 1;
+            stats.vertices++;
+        }
+    }
+    return stats;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters) {
+    PROFILE_SCOPE("MeshOptimizer::optimizeVertexCache");
+    size_t triangleCount = indices.size() / 3;
+
+    // Triangles of every vertex
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t index : indices) {
+        offsets[index + 1]++;
+    }
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        liveTriangles[vertex] = offsets[vertex + 1] - offsets[vertex];
+    }
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    if (clusters) {
+        clusters->assign(1, 0);
+    }
+
+    uint32_t time = CACHE_SIZE + 1;
+    size_t cursor = 0;
+    int64_t fanning = indices.empty() ? -1 : indices[0];
+    while (fanning >= 0) {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a) {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (size_t corner = 0; corner < 3; ++corner) {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if (time - cacheTime[vertex] > CACHE_SIZE) {
+                    cacheTime[vertex] = time++;
+                }
+            }
+            emitted[triangle] = 1;
+        }
+
+        // Next fan: the oldest candidate that is still cached after its own fan is emitted
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= CACHE_SIZE) {
+                priority = time - cacheTime[vertex];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        // Dead end, the next fan starts cold and so does a new cluster
+        if (next < 0) {
+            next = skipDeadEnd(liveTriangles, deadEnd, cursor);
+            if (clusters && next >= 0 && clusters->back() != output.size()) {
+                clusters->push_back(static_cast<uint32_t>(output.size()));
+            }
+        }
+        fanning = next;
+    }
+    indices.swap(output);
+}
+
+bool MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+                                     const std::vector<uint32_t>& clusters) {
+    if (clusters.size() < 2) {
+        return false;
+    }
+    PROFILE_SCOPE("MeshOptimizer::optimizeOverdraw");
+
+    struct Cluster {
+        uint32_t begin;
+        uint32_t end;
+        glm::vec3 centroid;  // Area weighted
+        glm::vec3 normal;
+        float area;
+        float sortKey;
+    };
+    std::vector<Cluster> sorted;
+    sorted.reserve(clusters.size());
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Cluster cluster{clusters[c], c + 1 < clusters.size() ? clusters[c + 1] : static_cast<uint32_t>(indices.size()),
+                        glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, 0.0f};
+        for (uint32_t i = cluster.begin; i < cluster.end; i += 3) {
+            const glm::vec3& a = positions[indices[i]];
+            const glm::vec3& b = positions[indices[i + 1]];
+            const glm::vec3& p = positions[indices[i + 2]];
+            glm::vec3 normal = glm::cross(b - a, p - a);
+            float area = glm::length(normal);
+            cluster.centroid += (a + b + p) * (area / 3.0f);
+            cluster.normal += normal;
+            cluster.area += area;
+        }
+        meshCentroid += cluster.centroid;
+        meshArea += cluster.area;
+        if (cluster.area > 0.0f) {
+            cluster.centroid /= cluster.area;
+        }
+        sorted.push_back(cluster);
+    }
+    if (meshArea <= 0.0f) {
+        return false;
+    }
+    meshCentroid /= meshArea;
+
+    // Outward facing clusters far from the center first
+    for (Cluster& cluster : sorted) {
+        float length = glm::length(cluster.normal);
+        cluster.sortKey = length > 0.0f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / length) : 0.0f;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const Cluster& cluster : sorted) {
+        output.insert(output.end(), indices.begin() + cluster.begin, indices.begin() + cluster.end);
+    }
+
+    // Cluster borders are cold already, but reordering can still lose the reuse across some of them
+    CacheStats baseline = analyzeVertexCache(indices.data(), indices.size(), positions.size());
+    CacheStats result = analyzeVertexCache(output.data(), output.size(), positions.size());
+    if (result.misses > baseline.misses * OVERDRAW_THRESHOLD) {
+        return false;
+    }
+    indices.swap(output);
+    return true;
+}
+
+void MeshOptimizer::optimizeVertexFetch(RawMeshData& mesh) {
+    PROFILE_SCOPE("MeshOptimizer::optimizeVertexFetch");
+    size_t vertexCount = mesh.vertices.size();
+    std::vector<uint32_t> remap(vertexCount, UNUSED);
+    uint32_t nextVertex = 0;
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+
+    auto reorder = [&remap, vertexCount, nextVertex](auto& attribute) {
+        if (attribute.size() != vertexCount) {
+            return;
+        }
+        std::remove_reference_t<decltype(attribute)> reordered(nextVertex);
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+            if (remap[vertex] != UNUSED) {
+                reordered[remap[vertex]] = attribute[vertex];
+            }
+        }
+        attribute.swap(reordered);
+    };
+    reorder(mesh.vertices);
+    reorder(mesh.uvs);
+    reorder(mesh.packedTNBFrame);
+}
+
+MeshOptimizer::Report MeshOptimizer::optimize(RawMeshData& mesh) {
+    Report report;
+    size_t vertexCount = mesh.vertices.size();
+    if (mesh.isPacked() || !mesh.lods.empty() || mesh.drawMode != GL_TRIANGLES || mesh.indices.size() < 3 || mesh.indices.size() % 3 != 0 ||
+        mesh.uvs.size() != vertexCount || mesh.packedTNBFrame.size() != vertexCount ||
+        *std::max_element(mesh.indices.begin(), mesh.indices.end()) >= vertexCount) {
+        return report;
+    }
+    PROFILE_SCOPE("MeshOptimizer::optimize");
+
+    report.before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount);
+
+    std::vector<uint32_t> clusters;
+    optimizeVertexCache(mesh.indices, vertexCount, &clusters);
+    report.clusters = static_cast<uint32_t>(clusters.size());
+    report.overdrawSorted = optimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+    optimizeVertexFetch(mesh);
+
+    report.after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    report.optimized = true;
+    return report;
+}
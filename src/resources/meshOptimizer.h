@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../components/mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Import-time reordering of indexed triangle meshes, the output is what
+ * MeshCache stores:
+ *
+ *   1. Vertex cache: Tipsify (Sander et al. 2007) orders triangles to
+ *      reuse recently transformed vertices, and splits them into clusters
+ *      where it had to jump to a cold part of the mesh.
+ *   2. Overdraw: clusters facing away from the mesh center are drawn first,
+ *      they tend to occlude the rest. Kept only while the cache efficiency
+ *      stays within OVERDRAW_THRESHOLD of step 1.
+ *   3. Vertex fetch: vertices are renumbered in order of first use, so the
+ *      fetches walk the vertex buffer forward. Unused vertices are dropped.
+ *
+ * Efficiency is measured on a FIFO post-transform cache of CACHE_SIZE entries.
+ */
+namespace MeshOptimizer {
+    constexpr size_t CACHE_SIZE = 16;
+    constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+    struct CacheStats {
+        uint32_t triangles = 0;
+        uint32_t vertices = 0;  // Referenced by the indices
+        uint32_t misses = 0;    // Vertex shader invocations
+
+        // Average cache miss ratio, misses per triangle (0.5 is ideal for large grids, 3 is no reuse)
+        float getACMR() const { return triangles ? static_cast<float>(misses) / triangles : 0.0f; }
+        // Average transformed vertex ratio, misses per vertex (1 is ideal)
+        float getATVR() const { return vertices ? static_cast<float>(misses) / vertices : 0.0f; }
+
+        CacheStats& operator+=(const CacheStats& other) {
+            triangles += other.triangles;
+            vertices += other.vertices;
+            misses += other.misses;
+            return *this;
+        }
+    };
+
+    struct Report {
+        CacheStats before;
+        CacheStats after;
+        uint32_t clusters = 0;
+        bool overdrawSorted = false;
+        bool optimized = false;     // False for meshes that aren't indexed triangle lists or already have LODs
+    };
+
+    CacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+    /*
+     * Tipsify, reorders the triangles of indices in place.
+     * @param clusters - Receives the first index of every cluster, may be null.
+     */
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters = nullptr);
+
+    // Sorts the clusters from optimizeVertexCache, @return false if it cost too much cache efficiency and was undone
+    bool optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+                          const std::vector<uint32_t>& clusters);
+
+    // Renumbers vertices by first use and reorders every per-vertex array of the mesh to match
+    void optimizeVertexFetch(RawMeshData& mesh);
+
+    // All three steps, the mesh must still hold its CPU data. Runs before MeshSimplifier::generateLods.
+    Report optimize(RawMeshData& mesh);
+}
@@ -0,0 +1,312 @@
+#include "meshSimplifier.h"
+#include "meshOptimizer.h"
+
+#include "../debugging/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+    constexpr uint32_t NONE = UINT32_MAX;
+
+    // Sum of squared distances to a set of planes, weighted by triangle area
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        static Quadric fromPlane(const glm::dvec3& normal, double distance, double weight) {
+            Quadric q;
+            q.a00 = weight * normal.x * normal.x;
+            q.a01 = weight * normal.x * normal.y;
+            q.a02 = weight * normal.x * normal.z;
+            q.a11 = weight * normal.y * normal.y;
+            q.a12 = weight * normal.y * normal.z;
+            q.a22 = weight * normal.z * normal.z;
+            q.b0 = weight * normal.x * distance;
+            q.b1 = weight * normal.y * distance;
+            q.b2 = weight * normal.z * distance;
+            q.c = weight * distance * distance;
+            q.weight = weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& other) {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+            return *this;
+        }
+
+        double evaluate(const glm::dvec3& p) const {
+            double result = a00 * p.x * p.x + 2.0 * a01 * p.x * p.y + 2.0 * a02 * p.x * p.z +
+                            a11 * p.y * p.y + 2.0 * a12 * p.y * p.z + a22 * p.z * p.z +
+                            2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return std::max(result, 0.0);
+        }
+    };
+
+    struct Collapse {
+        uint32_t source;
+        uint32_t target;
+        float error;  // RMS distance to the planes of both vertices
+    };
+
+    struct PositionHash {
+        size_t operator()(const glm::vec3& p) const {
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+
+    glm::dvec3 triangleNormal(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c) {
+        return glm::cross(b - a, c - a);
+    }
+}
+
+float MeshSimplifier::simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+                               float maxError, std::vector<uint32_t>& output) {
+    PROFILE_SCOPE("MeshSimplifier::simplify");
+    output = indices;
+    size_t vertexCount = positions.size();
+    if (vertexCount == 0 || indices.size() <= targetIndexCount) {
+        return 0.0f;
+    }
+
+    // Errors come out relative to the largest extent
+    glm::vec3 minimum(std::numeric_limits<float>::max());
+    glm::vec3 maximum(std::numeric_limits<float>::lowest());
+    for (const glm::vec3& position : positions) {
+        minimum = glm::min(minimum, position);
+        maximum = glm::max(maximum, position);
+    }
+    glm::vec3 size = maximum - minimum;
+    double extent = std::max({size.x, size.y, size.z});
+    if (extent <= 0.0) {
+        return 0.0f;
+    }
+    std::vector<glm::dvec3> points(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        points[v] = glm::dvec3(positions[v] - minimum) / extent;
+    }
+
+    // Weld by position, seams split vertices that are one point of the surface
+    std::vector<uint32_t> weld(vertexCount);
+    std::vector<uint32_t> weldSize(vertexCount, 0);
+    {
+        std::unordered_map<glm::vec3, uint32_t, PositionHash> firstAt;
+        firstAt.reserve(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            weld[v] = firstAt.emplace(positions[v], static_cast<uint32_t>(v)).first->second;
+            weldSize[weld[v]]++;
+        }
+    }
+
+    // Borders are edges without a twin in the welded mesh
+    std::vector<uint8_t> locked(vertexCount, 0);
+    {
+        std::unordered_map<uint64_t, uint32_t> edges;
+        edges.reserve(indices.size());
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (size_t e = 0; e < 3; ++e) {
+                uint64_t a = weld[indices[i + e]];
+                uint64_t b = weld[indices[i + (e + 1) % 3]];
+                edges[(a << 32) | b]++;
+            }
+        }
+        for (const auto& [edge, count] : edges) {
+            uint32_t a = static_cast<uint32_t>(edge >> 32);
+            uint32_t b = static_cast<uint32_t>(edge & 0xFFFFFFFFu);
+            auto twin = edges.find((static_cast<uint64_t>(b) << 32) | a);
+            if (count != 1 || twin == edges.end() || twin->second != 1) {
+                locked[a] = 1;
+                locked[b] = 1;
+            }
+        }
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (weldSize[weld[v]] > 1 || locked[weld[v]]) {
+            locked[v] = 1;
+        }
+    }
+
+    // Quadrics live on the welded vertex
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const glm::dvec3& a = points[indices[i]];
+        glm::dvec3 normal = triangleNormal(a, points[indices[i + 1]], points[indices[i + 2]]);
+        double area = glm::length(normal);
+        if (area <= 0.0) {
+            continue;
+        }
+        normal /= area;
+        Quadric plane = Quadric::fromPlane(normal, -glm::dot(normal, a), area);
+        for (size_t corner = 0; corner < 3; ++corner) {
+            quadrics[weld[indices[i + corner]]] += plane;
+        }
+    }
+
+    std::vector<uint32_t> offsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapseTarget(vertexCount, NONE);
+    std::vector<uint8_t> touched(vertexCount);
+    float resultError = 0.0f;
+
+    while (output.size() > targetIndexCount) {
+        // Triangles of every vertex
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (uint32_t index : output) {
+            offsets[index + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        adjacency.resize(output.size());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < output.size(); ++i) {
+            adjacency[fill[output[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        // Both directions of every edge, cheapest first
+        collapses.clear();
+        for (size_t i = 0; i < output.size(); i += 3) {
+            for (size_t e = 0; e < 3; ++e) {
+                uint32_t a = output[i + e];
+                uint32_t b = output[i + (e + 1) % 3];
+                for (int direction = 0; direction < 2; ++direction, std::swap(a, b)) {
+                    if (locked[a]) {
+                        continue;
+                    }
+                    Quadric combined = quadrics[a];
+                    combined += quadrics[weld[b]];
+                    float error = static_cast<float>(std::sqrt(combined.evaluate(points[b]) / std::max(combined.weight, 1e-12)));
+                    collapses.push_back({a, b, error});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+        // Independent collapses only, so the flip checks below see the final neighbourhood
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t trianglesToRemove = (output.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses) {
+            if (collapse.error > maxError || removed >= trianglesToRemove) {
+                break;
+            }
+            uint32_t a = collapse.source;
+            uint32_t targetWeld = weld[collapse.target];
+            if (touched[a] || touched[targetWeld]) {
+                continue;
+            }
+
+            // Triangles that stay must not flip or fold over
+            bool valid = true;
+            size_t collapsed = 0;
+            for (uint32_t k = offsets[a]; k < offsets[a + 1] && valid; ++k) {
+                const uint32_t* triangle = &output[adjacency[k] * 3];
+                if (weld[triangle[0]] == targetWeld || weld[triangle[1]] == targetWeld || weld[triangle[2]] == targetWeld) {
+                    collapsed++;
+                    continue;
+                }
+                glm::dvec3 corners[3];
+                for (size_t corner = 0; corner < 3; ++corner) {
+                    corners[corner] = points[triangle[corner]];
+                }
+                glm::dvec3 before = triangleNormal(corners[0], corners[1], corners[2]);
+                for (size_t corner = 0; corner < 3; ++corner) {
+                    if (triangle[corner] == a) {
+                        corners[corner] = points[collapse.target];
+                    }
+                }
+                glm::dvec3 after = triangleNormal(corners[0], corners[1], corners[2]);
+                valid = glm::dot(before, after) > 0.25 * glm::length(before) * glm::length(after);
+            }
+            if (!valid || collapsed == 0) {
+                continue;
+            }
+
+            collapseTarget[a] = collapse.target;
+            quadrics[targetWeld] += quadrics[a];
+            for (uint32_t k = offsets[a]; k < offsets[a + 1]; ++k) {
+                const uint32_t* triangle = &output[adjacency[k] * 3];
+                for (size_t corner = 0; corner < 3; ++corner) {
+                    touched[weld[triangle[corner]]] = 1;
+                }
+            }
+            removed += collapsed;
+            applied++;
+            resultError = std::max(resultError, collapse.error);
+        }
+        if (applied == 0) {
+            break;
+        }
+
+        // Rewrite, dropping triangles that lost an edge
+        size_t write = 0;
+        for (size_t i = 0; i < output.size(); i += 3) {
+            uint32_t triangle[3];
+            for (size_t corner = 0; corner < 3; ++corner) {
+                uint32_t vertex = output[i + corner];
+                triangle[corner] = collapseTarget[vertex] != NONE ? collapseTarget[vertex] : vertex;
+            }
+            if (weld[triangle[0]] == weld[triangle[1]] || weld[triangle[1]] == weld[triangle[2]] ||
+                weld[triangle[0]] == weld[triangle[2]]) {
+                continue;
+            }
+            output[write++] = triangle[0];
+            output[write++] = triangle[1];
+            output[write++] = triangle[2];
+        }
+        output.resize(write);
+        for (uint32_t& target : collapseTarget) {
+            target = NONE;
+        }
+    }
+    return resultError;
+}
+
+size_t MeshSimplifier::generateLods(RawMeshData& mesh) {
+    if (mesh.isPacked() || !mesh.lods.empty() || mesh.drawMode != GL_TRIANGLES || mesh.indices.size() % 3 != 0 ||
+        mesh.indices.size() < MIN_TRIANGLES * 3 * 2) {
+        return 1;
+    }
+    PROFILE_SCOPE("MeshSimplifier::generateLods");
+
+    // Every level starts from the full mesh, so its error is measured against it
+    std::vector<uint32_t> fullDetail = mesh.indices;
+    std::vector<MeshLodRange> lods = {{0, static_cast<uint32_t>(fullDetail.size()), 0.0f}};
+    std::vector<uint32_t> level;
+    while (lods.size() < MESH_MAX_LODS) {
+        size_t previousCount = lods.back().indexCount;
+        size_t targetCount = previousCount / 6 * 3;
+        if (targetCount < MIN_TRIANGLES * 3) {
+            break;
+        }
+
+        float error = simplify(mesh.vertices, fullDetail, targetCount, MAX_ERROR, level);
+
+        // Stuck on locked vertices or the error bound, a level this close to the last one isn't worth it
+        if (level.size() > previousCount * 3 / 4) {
+            break;
+        }
+        MeshOptimizer::optimizeVertexCache(level, mesh.vertices.size());
+
+        lods.push_back({static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(level.size()), error});
+        mesh.indices.insert(mesh.indices.end(), level.begin(), level.end());
+    }
+
+    if (lods.size() > 1) {
+        mesh.lods = std::move(lods);
+    }
+    return std::max<size_t>(mesh.lods.size(), 1);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../components/mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Quadric error simplification (Garland & Heckbert 1997) for the LOD chain.
+ *
+ * Vertices are collapsed into a neighbour instead of a new optimal position,
+ * so every level indexes the vertices of the full mesh and only needs its own
+ * index range. Vertices are welded by position first: ones on a border or an
+ * attribute seam (several vertices at one position) are never moved, which
+ * keeps the outline and the UVs intact.
+ */
+namespace MeshSimplifier {
+    // Levels stop once a collapse would cost more, relative to the largest extent of the mesh
+    constexpr float MAX_ERROR = 0.05f;
+    // Levels smaller than this aren't worth a draw range
+    constexpr size_t MIN_TRIANGLES = 32;
+
+    /*
+     * Simplifies an indexed triangle list towards targetIndexCount.
+     * @param output - Receives the simplified indices, into the same positions.
+     * @return Worst error of the collapses made, relative to the largest extent.
+     */
+    float simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+                   float maxError, std::vector<uint32_t>& output);
+
+    /*
+     * Appends levels of about half the triangles of the previous one to
+     * mesh.indices, up to MESH_MAX_LODS levels, and fills mesh.lods.
+     * @return The number of levels, 1 when the mesh can't be simplified.
+     */
+    size_t generateLods(RawMeshData& mesh);
+}
@@ -0,0 +1,116 @@
+#include "meshletBuilder.h"
+
+#include "../debugging/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr uint32_t NONE = UINT32_MAX;
+
+    // Normals spreading further than acos(MIN_CONE_DOT) from the axis can't all face away
+    constexpr float MIN_CONE_DOT = 0.1f;
+
+    void computeBounds(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+                       const std::vector<uint32_t>& vertices, Meshlet& meshlet) {
+        glm::vec3 minimum(std::numeric_limits<float>::max());
+        glm::vec3 maximum(std::numeric_limits<float>::lowest());
+        for (uint32_t vertex : vertices) {
+            minimum = glm::min(minimum, positions[vertex]);
+            maximum = glm::max(maximum, positions[vertex]);
+        }
+        glm::vec3 center = (minimum + maximum) * 0.5f;
+        float radiusSquared = 0.0f;
+        for (uint32_t vertex : vertices) {
+            glm::vec3 offset = positions[vertex] - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        meshlet.boundingSphere = glm::vec4(center, std::sqrt(radiusSquared));
+
+        // Unit normals, so a few large triangles don't hide the small ones turned away
+        std::vector<glm::vec3> normals;
+        normals.reserve(meshlet.indexCount / 3);
+        glm::vec3 axis(0.0f);
+        for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3) {
+            const glm::vec3& a = positions[indices[i]];
+            glm::vec3 normal = glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+            float length = glm::length(normal);
+            if (length > 0.0f) {
+                normals.push_back(normal / length);
+                axis += normals.back();
+            }
+        }
+
+        float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength <= 0.0f) {
+            meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+            return;
+        }
+        axis /= axisLength;
+        float minimumDot = 1.0f;
+        for (const glm::vec3& normal : normals) {
+            minimumDot = std::min(minimumDot, glm::dot(axis, normal));
+        }
+        float cutoff = minimumDot <= MIN_CONE_DOT ? 1.0f : std::sqrt(1.0f - minimumDot * minimumDot);
+        meshlet.cone = glm::vec4(axis, cutoff);
+    }
+}
+
+void MeshletBuilder::build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, uint32_t firstIndex,
+                           uint32_t indexCount, std::vector<Meshlet>& output) {
+    std::vector<uint32_t> lastMeshlet(positions.size(), NONE);
+    std::vector<uint32_t> vertices;
+    vertices.reserve(MAX_VERTICES);
+
+    Meshlet meshlet;
+    meshlet.firstIndex = firstIndex;
+    uint32_t meshletId = static_cast<uint32_t>(output.size());
+    uint32_t end = firstIndex + indexCount;
+    for (uint32_t i = firstIndex; i < end; i += 3) {
+        uint32_t a = indices[i];
+        uint32_t b = indices[i + 1];
+        uint32_t c = indices[i + 2];
+        size_t newVertices = (lastMeshlet[a] != meshletId) + (b != a && lastMeshlet[b] != meshletId) +
+                             (c != a && c != b && lastMeshlet[c] != meshletId);
+
+        // Full, close it and start the next one at this triangle
+        if (vertices.size() + newVertices > MAX_VERTICES || meshlet.indexCount / 3 >= MAX_TRIANGLES) {
+            computeBounds(positions, indices, vertices, meshlet);
+            output.push_back(meshlet);
+            meshlet = Meshlet();
+            meshlet.firstIndex = i;
+            meshletId++;
+            vertices.clear();
+        }
+
+        for (uint32_t vertex : {a, b, c}) {
+            if (lastMeshlet[vertex] != meshletId) {
+                lastMeshlet[vertex] = meshletId;
+                vertices.push_back(vertex);
+            }
+        }
+        meshlet.indexCount += 3;
+    }
+
+    if (meshlet.indexCount > 0) {
+        computeBounds(positions, indices, vertices, meshlet);
+        output.push_back(meshlet);
+    }
+}
+
+size_t MeshletBuilder::generateMeshlets(RawMeshData& mesh) {
+    size_t indexCount = mesh.getLod0IndexCount();
+    if (mesh.isPacked() || !mesh.meshlets.empty() || mesh.drawMode != GL_TRIANGLES || indexCount % 3 != 0 ||
+        indexCount < MIN_MESHLETS * MAX_TRIANGLES * 3) {
+        return 0;
+    }
+    PROFILE_SCOPE("MeshletBuilder::generateMeshlets");
+
+    uint32_t firstIndex = mesh.lods.empty() ? 0 : mesh.lods[0].firstIndex;
+    build(mesh.vertices, mesh.indices, firstIndex, static_cast<uint32_t>(indexCount), mesh.meshlets);
+    if (mesh.meshlets.size() < MIN_MESHLETS) {
+        mesh.meshlets.clear();
+    }
+    return mesh.meshlets.size();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../components/mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Splits the full detail level of large meshes into meshlets for GPU
+ * culling (see MeshletCuller).
+ *
+ * Triangles are taken in index order, which MeshOptimizer already grouped
+ * into tight fans, and a meshlet is closed once the next triangle would
+ * exceed MAX_VERTICES or MAX_TRIANGLES. The indices aren't touched, every
+ * meshlet is a contiguous index range and together they cover LOD 0.
+ *
+ * Bounds are a sphere around the meshlet's vertices and a normal cone: the
+ * average triangle normal and the sine of the largest angle any normal makes
+ * with it. Meshlets whose normals spread more than about 84 degrees never
+ * face away as a whole and get a cutoff of 1.
+ */
+namespace MeshletBuilder {
+    constexpr size_t MAX_VERTICES = 64;
+    constexpr size_t MAX_TRIANGLES = 124;
+    // Smaller meshes are cheaper to cull whole
+    constexpr size_t MIN_MESHLETS = 8;
+
+    // Meshlets of indices [firstIndex, firstIndex + indexCount), appended to output
+    void build(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, uint32_t firstIndex,
+               uint32_t indexCount, std::vector<Meshlet>& output);
+
+    /*
+     * Fills mesh.meshlets for the full detail level, run after
+     * MeshOptimizer::optimize and MeshSimplifier::generateLods.
+     * @return The number of meshlets, 0 when the mesh is drawn whole.
+     */
+    size_t generateMeshlets(RawMeshData& mesh);
+}
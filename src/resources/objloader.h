@@ -1,20 +1,50 @@
 #pragma once
 
 #include "../components/mesh.h"
+#include "../system/jobSystem.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <iostream>
-#include <sstream>
-#include <unordered_map>
 
 namespace ObjLoader {
 
 /*
-*  Struct and Hashing
+*  Chunk parsing
+*
+*  The file is split at line boundaries and every chunk is parsed on its own
+*  job. Faces keep their raw indices plus how many v/vt lines preceded them,
+*  so the serial merge validates and dedups exactly like a front to back parse.
+*/
+struct OBJFaceCorner {
+    unsigned int vertex_idx;  // 1-based as written, 0 when unreadable
+    int uv_idx, normal_idx;   // 1-based as written, <= 0 when absent
+};
+
+struct OBJFace {
+    uint32_t firstCorner;
+    uint32_t cornerCount;
+    uint32_t verticesBefore;  // v lines earlier in the same chunk
+    uint32_t uvsBefore;       // vt lines earlier in the same chunk
+};
+
+struct OBJChunk {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> uvs;
+    std::vector<OBJFaceCorner> corners;
+    std::vector<OBJFace> faces;
+};
+
+constexpr size_t OBJ_MIN_CHUNK_BYTES = 64 * 1024;
+
+/*
+*  Vertex dedup, open addressing with linear probing on a 64 bit mixed key
 */
 struct VertexIdx {
     unsigned int vertex_idx;
@@ -27,55 +57,114 @@ struct VertexIdx {
     }
 };
 
-struct VertexIdxHash {
-    size_t operator()(const VertexIdx& vi) const {
-        return ((std::hash<unsigned int>()(vi.vertex_idx) ^
-                (std::hash<int>()(vi.uv_idx) << 1)) >> 1) ^
-               (std::hash<int>()(vi.normal_idx) << 1);
+class OBJVertexTable {
+public:
+    explicit OBJVertexTable(size_t expectedVertices) {
+        size_t capacity = 16;
+        while (capacity < expectedVertices * 2) {
+            capacity <<= 1;
+        }
+        m_slots.assign(capacity, Slot{});
     }
-};
 
-/*
-* Parsing context that holds temporary data and maps for OBJ parsing
-*/
-struct OBJParseContext {
-    RawMeshData& mesh;
-    std::vector<glm::vec3> temp_vertices;
-    std::vector<glm::vec2> temp_uvs;
-    std::vector<glm::vec3> temp_normals;
-    std::unordered_map<VertexIdx, unsigned int, VertexIdxHash> vertexMap;
-
-    OBJParseContext(RawMeshData& m)
-        : mesh(m) {}
+    // Returns the index stored for vi, or inserts newIndex and returns it
+    unsigned int findOrInsert(const VertexIdx& vi, unsigned int newIndex, bool& inserted) {
+        if ((m_size + 1) * 2 > m_slots.size()) {
+            grow();
+        }
+
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = hash(vi) & mask;; i = (i + 1) & mask) {
+            Slot& slot = m_slots[i];
+            if (slot.index == EMPTY) {
+                slot.key = vi;
+                slot.index = newIndex;
+                ++m_size;
+                inserted = true;
+                return newIndex;
+            }
+            if (slot.key == vi) {
+                inserted = false;
+                return slot.index;
+            }
+        }
+    }
+
+private:
+    static constexpr unsigned int EMPTY = 0xFFFFFFFFu;
+
+    struct Slot {
+        VertexIdx key{0, 0, 0};
+        unsigned int index = EMPTY;
+    };
+
+    std::vector<Slot> m_slots;
+    size_t m_size = 0;
+
+    static size_t hash(const VertexIdx& vi) {
+        // splitmix64 finaliser over all three indices
+        uint64_t h = static_cast<uint64_t>(vi.vertex_idx) * 0x9E3779B97F4A7C15ull;
+        h ^= (static_cast<uint64_t>(static_cast<uint32_t>(vi.uv_idx)) << 32) | static_cast<uint32_t>(vi.normal_idx);
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBull;
+        h ^= h >> 31;
+        return static_cast<size_t>(h);
+    }
+
+    void grow() {
+        std::vector<Slot> old = std::move(m_slots);
+        m_slots.assign(old.size() * 2, Slot{});
+        size_t mask = m_slots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.index == EMPTY) continue;
+            size_t i = hash(slot.key) & mask;
+            while (m_slots[i].index != EMPTY) {
+                i = (i + 1) & mask;
+            }
+            m_slots[i] = slot;
+        }
+    }
 };
 
 /*
 *  Forward Declarations - FIXED: All should use RawMeshData*
 */
-static void parseVertexString(const std::string& vertex_string, unsigned int& vertex_idx, int& uv_idx, int& normal_idx);
-static unsigned int processVertex(VertexIdx& vi, OBJParseContext& ctx);
-static void parseOBJLine(const std::string& line, OBJParseContext& ctx);
+static void parseOBJChunk(const char* begin, const char* end, OBJChunk& chunk);
+static void mergeOBJChunks(const std::vector<OBJChunk>& chunks, RawMeshData& mesh);
 inline void generateUVs(RawMeshData* mesh);  // FIXED: RawMeshData* not Mesh*
 inline void computepackedTNBFrame(RawMeshData* mesh);  // FIXED: RawMeshData* not Mesh*
 
 /*
 *  Main OBJ Loading
 */
-static RawMeshData* loadOBJ(const std::string& fileContent) {
-    if (fileContent.empty()) {
+static RawMeshData* loadOBJ(const char* data, size_t size) {
+    if (!data || size == 0) {
         std::cerr << "[Error] OBJLoader::loadOBJ: File content is empty\n";
         return nullptr;
     }
 
-    RawMeshData* mesh = new RawMeshData();
-    OBJParseContext ctx(*mesh);
-
-    std::istringstream fileStream(fileContent);
-    std::string line;
-    while (std::getline(fileStream, line)) {
-        parseOBJLine(line, ctx);
+    // Chunk boundaries are moved forward to the next line start
+    size_t chunkCount = std::min<size_t>(JobSystem::getInstance().getWorkerCount() + 1,
+                                         std::max<size_t>(1, size / OBJ_MIN_CHUNK_BYTES));
+    std::vector<const char*> bounds(chunkCount + 1);
+    bounds[0] = data;
+    bounds[chunkCount] = data + size;
+    for (size_t i = 1; i < chunkCount; ++i) {
+        const char* split = std::max(data + size * i / chunkCount, bounds[i - 1]);
+        const char* newline = static_cast<const char*>(std::memchr(split, '\n', (data + size) - split));
+        bounds[i] = newline ? newline + 1 : data + size;
     }
 
+    std::vector<OBJChunk> chunks(chunkCount);
+    JobSystem::getInstance().parallelFor(chunkCount, [&](size_t i) {
+        parseOBJChunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    RawMeshData* mesh = new RawMeshData();
+    mergeOBJChunks(chunks, *mesh);
+
     // Check if we have any vertices
     if (mesh->vertices.empty()) {
         std::cerr << "[Error] OBJLoader::loadOBJ: No vertices found in OBJ file\n";
@@ -94,113 +183,186 @@ static RawMeshData* loadOBJ(const std::string& fileContent) {
 }
 
 /*
-*  Parsing Functions (unchanged)
+*  Parsing Functions
 */
-static void parseVertexString(const std::string& vertex_string, unsigned int& vertex_idx, int& uv_idx, int& normal_idx) {
-    std::istringstream vertex_stream(vertex_string);
-
-    vertex_stream >> vertex_idx;
-
-    if (vertex_string.find('/') != std::string::npos) {
-        char delimiter;
-        vertex_stream >> delimiter;
+inline bool isOBJSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
 
-        if (vertex_stream.peek() != '/') {
-            vertex_stream >> uv_idx;
-        }
+inline const char* skipOBJSpaces(const char* p, const char* end) {
+    while (p < end && isOBJSpace(*p)) ++p;
+    return p;
+}
 
-        if (vertex_stream.peek() == '/') {
-            vertex_stream >> delimiter;  // Move to normal if present
-            vertex_stream >> normal_idx;
-        }
+// Correctly rounded like the istream parse it replaces, missing values read as 0
+inline const char* parseOBJFloat(const char* p, const char* end, float& value) {
+    p = skipOBJSpaces(p, end);
+    if (p < end && *p == '+') ++p;
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        value = 0.0f;
+        return p;
     }
+    return result.ptr;
 }
 
-static unsigned int processVertex(VertexIdx& vi, OBJParseContext& ctx) {
-    // Check if this vertex has already been processed
-    auto it = ctx.vertexMap.find(vi);
-    if (it != ctx.vertexMap.end()) {
-        return it->second;
-    }
+template <typename T>
+inline const char* parseOBJInt(const char* p, const char* end, T& value) {
+    if (p < end && *p == '+') ++p;
+    auto result = std::from_chars(p, end, value);
+    return result.ec == std::errc() ? result.ptr : p;
+}
 
-    // Add new vertex
-    ctx.mesh.vertices.push_back(ctx.temp_vertices[vi.vertex_idx]);
+// v, v/vt, v//vn or v/vt/vn
+inline void parseOBJCorner(const char* p, const char* end, OBJFaceCorner& corner) {
+    corner = { 0, -1, -1 };
+    const char* q = parseOBJInt(p, end, corner.vertex_idx);
+    if (!std::memchr(p, '/', end - p) || q >= end) {
+        return;
+    }
 
-    // If UVs are present, add them, otherwise add placeholder
-    if (vi.uv_idx >= 0 && vi.uv_idx < static_cast<int>(ctx.temp_uvs.size())) {
-        ctx.mesh.uvs.push_back(ctx.temp_uvs[vi.uv_idx]);
-    } else {
-        ctx.mesh.uvs.push_back(glm::vec2(0.0f)); // UVs will be generated later
+    ++q;  // Delimiter
+    if (q < end && *q != '/') {
+        q = parseOBJInt(q, end, corner.uv_idx);
+    }
+    if (q < end && *q == '/') {
+        parseOBJInt(q + 1, end, corner.normal_idx);
     }
+}
 
-    unsigned int new_idx = static_cast<unsigned int>(ctx.mesh.vertices.size() - 1);
-    ctx.vertexMap[vi] = new_idx;
+static void parseOBJChunk(const char* begin, const char* end, OBJChunk& chunk) {
+    // Rough reservation, a typical v / f line is ~30 bytes
+    size_t estimatedLines = static_cast<size_t>(end - begin) / 32;
+    chunk.vertices.reserve(estimatedLines / 2);
+    chunk.corners.reserve(estimatedLines * 3 / 2);
+    chunk.faces.reserve(estimatedLines / 2);
+
+    const char* line = begin;
+    while (line < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd) lineEnd = end;
+
+        // Skip empty lines and comments
+        if (line < lineEnd && *line != '#') {
+            const char* token = skipOBJSpaces(line, lineEnd);
+            const char* tokenEnd = token;
+            while (tokenEnd < lineEnd && !isOBJSpace(*tokenEnd)) ++tokenEnd;
+            size_t tokenLength = static_cast<size_t>(tokenEnd - token);
+
+            if (tokenLength == 1 && token[0] == 'v') {
+                // Vertex position
+                glm::vec3 vertex;
+                const char* p = parseOBJFloat(tokenEnd, lineEnd, vertex.x);
+                p = parseOBJFloat(p, lineEnd, vertex.y);
+                parseOBJFloat(p, lineEnd, vertex.z);
+                chunk.vertices.push_back(vertex);
+            } else if (tokenLength == 2 && token[0] == 'v' && token[1] == 't') {
+                // Texture coordinate
+                glm::vec2 uv;
+                const char* p = parseOBJFloat(tokenEnd, lineEnd, uv.x);
+                parseOBJFloat(p, lineEnd, uv.y);
+                chunk.uvs.push_back(uv);
+            } else if (tokenLength == 1 && token[0] == 'f') {
+                // Face, one corner per whitespace separated token
+                OBJFace face;
+                face.firstCorner = static_cast<uint32_t>(chunk.corners.size());
+                face.verticesBefore = static_cast<uint32_t>(chunk.vertices.size());
+                face.uvsBefore = static_cast<uint32_t>(chunk.uvs.size());
+
+                const char* p = skipOBJSpaces(tokenEnd, lineEnd);
+                while (p < lineEnd) {
+                    const char* cornerEnd = p;
+                    while (cornerEnd < lineEnd && !isOBJSpace(*cornerEnd)) ++cornerEnd;
+
+                    OBJFaceCorner corner;
+                    parseOBJCorner(p, cornerEnd, corner);
+                    chunk.corners.push_back(corner);
+                    p = skipOBJSpaces(cornerEnd, lineEnd);
+                }
+
+                face.cornerCount = static_cast<uint32_t>(chunk.corners.size()) - face.firstCorner;
+                chunk.faces.push_back(face);
+            }
+            // vn is not stored, normals are rebuilt by computepackedTNBFrame
+        }
 
-    return new_idx;
+        line = lineEnd + 1;
+    }
 }
 
-static void parseOBJLine(const std::string& line, OBJParseContext& ctx) {
-    // Skip empty lines and comments
-    if (line.empty() || line[0] == '#') {
-        return;
+static void mergeOBJChunks(const std::vector<OBJChunk>& chunks, RawMeshData& mesh) {
+    std::vector<glm::vec3> tempVertices;
+    std::vector<glm::vec2> tempUVs;
+    size_t totalCorners = 0;
+    size_t totalVertices = 0, totalUVs = 0;
+    for (const OBJChunk& chunk : chunks) {
+        totalVertices += chunk.vertices.size();
+        totalUVs += chunk.uvs.size();
+        totalCorners += chunk.corners.size();
+    }
+    tempVertices.reserve(totalVertices);
+    tempUVs.reserve(totalUVs);
+    for (const OBJChunk& chunk : chunks) {
+        tempVertices.insert(tempVertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+        tempUVs.insert(tempUVs.end(), chunk.uvs.begin(), chunk.uvs.end());
     }
 
-    std::istringstream s(line);
-    std::string token;
-    s >> token;
-
-    if (token == "v") {
-        // Vertex position
-        glm::vec3 vertex;
-        s >> vertex.x >> vertex.y >> vertex.z;
-        ctx.temp_vertices.push_back(vertex);
-    } else if (token == "vt") {
-        // Texture coordinate
-        glm::vec2 uv;
-        s >> uv.x >> uv.y;
-        ctx.temp_uvs.push_back(uv);
-    } else if (token == "vn") {
-        // Vertex normal
-        glm::vec3 normal;
-        s >> normal.x >> normal.y >> normal.z;
-        ctx.temp_normals.push_back(normal);
-    } else if (token == "f") {
-        // Face
-        std::string vertex_string;
-        std::vector<unsigned int> face_indices;
-
-        while (s >> vertex_string) {
-            unsigned int vertex_idx = 0;
-            int uv_idx = -1;
-            int normal_idx = -1;
-
-            parseVertexString(vertex_string, vertex_idx, uv_idx, normal_idx);
-
-            // Validate vertex index
-            if (vertex_idx == 0 || vertex_idx > ctx.temp_vertices.size()) {
-                std::cerr << "[Warning] Invalid vertex index: " << vertex_idx << std::endl;
-                continue;
+    OBJVertexTable vertexTable(std::max(totalVertices, totalUVs));
+    mesh.indices.reserve(totalCorners * 2);
+    std::vector<unsigned int> faceIndices;
+
+    size_t verticesBeforeChunk = 0, uvsBeforeChunk = 0;
+    for (const OBJChunk& chunk : chunks) {
+        for (const OBJFace& face : chunk.faces) {
+            // Only what was declared above the face line is visible to it
+            size_t visibleVertices = verticesBeforeChunk + face.verticesBefore;
+            size_t visibleUVs = uvsBeforeChunk + face.uvsBefore;
+
+            faceIndices.clear();
+            for (uint32_t c = 0; c < face.cornerCount; ++c) {
+                const OBJFaceCorner& corner = chunk.corners[face.firstCorner + c];
+
+                // Validate vertex index
+                if (corner.vertex_idx == 0 || corner.vertex_idx > visibleVertices) {
+                    std::cerr << "[Warning] Invalid vertex index: " << corner.vertex_idx << std::endl;
+                    continue;
+                }
+
+                // Adjust indices to be zero-based
+                VertexIdx vi = {
+                    corner.vertex_idx - 1,
+                    corner.uv_idx > 0 ? corner.uv_idx - 1 : -1,
+                    corner.normal_idx > 0 ? corner.normal_idx - 1 : -1
+                };
+
+                bool inserted = false;
+                unsigned int newIndex = static_cast<unsigned int>(mesh.vertices.size());
+                unsigned int idx = vertexTable.findOrInsert(vi, newIndex, inserted);
+                if (inserted) {
+                    mesh.vertices.push_back(tempVertices[vi.vertex_idx]);
+
+                    // If UVs are present, add them, otherwise add placeholder
+                    if (vi.uv_idx >= 0 && static_cast<size_t>(vi.uv_idx) < visibleUVs) {
+                        mesh.uvs.push_back(tempUVs[vi.uv_idx]);
+                    } else {
+                        mesh.uvs.push_back(glm::vec2(0.0f)); // UVs will be generated later
+                    }
+                }
+                faceIndices.push_back(idx);
             }
 
-            // Adjust indices to be zero-based
-            VertexIdx vi = {
-                vertex_idx - 1,
-                uv_idx > 0 ? uv_idx - 1 : -1,
-                normal_idx > 0 ? normal_idx - 1 : -1
-            };
-
-            unsigned int idx = processVertex(vi, ctx);
-            face_indices.push_back(idx);
-        }
-
-        // Triangulate face (fan triangulation)
-        if (face_indices.size() >= 3) {
-            for (size_t i = 1; i + 1 < face_indices.size(); i++) {
-                ctx.mesh.indices.push_back(face_indices[0]);
-                ctx.mesh.indices.push_back(face_indices[i]);
-                ctx.mesh.indices.push_back(face_indices[i + 1]);
+            // Triangulate face (fan triangulation)
+            if (faceIndices.size() >= 3) {
+                for (size_t i = 1; i + 1 < faceIndices.size(); i++) {
+                    mesh.indices.push_back(faceIndices[0]);
+                    mesh.indices.push_back(faceIndices[i]);
+                    mesh.indices.push_back(faceIndices[i + 1]);
+                }
             }
         }
+
+        verticesBeforeChunk += chunk.vertices.size();
+        uvsBeforeChunk += chunk.uvs.size();
     }
 }
 
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "../../../components/mesh.h"
+#include "../../mappedFile.h"
+#include "../../../system/jobSystem.h"
 // ... and any other mesh data in the future
 
 #include <json/json.hpp>
-#include <fstream>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
 #include <sstream>
 #include <iostream>
 
@@ -20,20 +25,53 @@ struct glTFBufferView{
     size_t index, byteOffset, size, stride;
 };
 
+/*
+* Bytes of a glTF buffer. External .bin files and the GLB BIN chunk point into
+* a memory mapping, only data: URIs are decoded into owned storage.
+*/
+struct glTFBuffer {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<MappedFile> mapping;
+    std::vector<uint8_t> storage;
+};
+
+// One decoded primitive, filled by a job
+struct glTFPrimitiveResult {
+    std::unique_ptr<RawMeshData> mesh;
+    int materialIndex = -1;
+    bool generatedTangents = false;
+    std::string error; // Set when required attributes are missing
+};
+
+// GLB container, all fields little endian
+constexpr uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
 /*
 * Forward declartation(s)
 */
 bool parseAccessors(
     const json& gltfDoc,
-    std::vector<std::vector<uint8_t>>& buffers,
+    const std::vector<glTFBuffer>& buffers,
     std::vector<glTFBufferView>& bufferViews,
     std::vector<std::unique_ptr<RawMeshData>>& meshes,
     std::vector<int>& materialIndices);
-bool parseBuffers(const json &gltfDoc, const std::string &fileName, std::vector<std::vector<uint8_t>>& buffers);
+void decodePrimitive(
+    const json& primitiveJson,
+    size_t primitiveIdx,
+    const json& accessorsJson,
+    const std::vector<glTFBuffer>& buffers,
+    const std::vector<glTFBufferView>& bufferViews,
+    glTFPrimitiveResult& result);
+bool parseGLB(const std::shared_ptr<MappedFile>& file, json& gltfDoc, glTFBuffer& binChunk);
+bool parseBuffers(const json &gltfDoc, const std::string &fileName, const glTFBuffer& binChunk, std::vector<glTFBuffer>& buffers,
+                  std::vector<std::string>* sourceFiles = nullptr);
 template <typename T>
 void parseAccessorData(
     const json& accessorJson,
-    const std::vector<std::vector<uint8_t>>& buffers,
+    const std::vector<glTFBuffer>& buffers,
     const glTFBufferView& bufferView,
     std::vector<T>& targetVector);
 bool parseNodes(const json& gltfDoc, std::vector<SceneData>& nodeData);
@@ -59,26 +97,89 @@ void parseJsonProperty(const json& j, const char* key, T& target) {
     }
 }
 
-std::string base64Decode(const std::string& base64) {
-    static const std::string base64_chars =
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "abcdefghijklmnopqrstuvwxyz"
-        "0123456789+/";
+/*
+ * Base64 (RFC 4648, standard and URL safe alphabets). Table driven, four
+ * characters become three bytes per step and are written straight into the
+ * destination buffer.
+ */
+constexpr uint8_t BASE64_INVALID = 0x80;
+
+constexpr std::array<uint8_t, 256> makeBase64Table() {
+    std::array<uint8_t, 256> table{};
+    for (auto& entry : table) {
+        entry = BASE64_INVALID;
+    }
+    for (int i = 0; i < 26; ++i) {
+        table['A' + i] = static_cast<uint8_t>(i);
+        table['a' + i] = static_cast<uint8_t>(26 + i);
+    }
+    for (int i = 0; i < 10; ++i) {
+        table['0' + i] = static_cast<uint8_t>(52 + i);
+    }
+    table['+'] = table['-'] = 62;
+    table['/'] = table['_'] = 63;
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> BASE64_TABLE = makeBase64Table();
 
-    std::vector<unsigned char> decodedBytes;
-    size_t val = 0, valb = -8;
+// Upper bound of the decoded size, exact for padded input
+size_t base64DecodedSize(const char* src, size_t length) {
+    while (length > 0 && src[length - 1] == '=') {
+        --length;
+    }
+    return length / 4 * 3 + (length % 4 * 3) / 4;
+}
+
+/*
+ * Decodes into dst, which must hold base64DecodedSize(src, length) bytes.
+ * @return Bytes written, or SIZE_MAX if the input holds a non base64 character.
+ */
+size_t base64Decode(const char* src, size_t length, uint8_t* dst) {
+    while (length > 0 && src[length - 1] == '=') {
+        --length;
+    }
 
-    for (unsigned char c : base64) {
-        if (c == '=') break;
-        val = (val << 6) + base64_chars.find(c);
-        valb += 6;
-        if (valb >= 0) {
-            decodedBytes.push_back((val >> valb) & 0xFF);
-            valb -= 8;
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+    uint8_t* out = dst;
+    size_t fullGroups = length / 4;
+
+    for (size_t i = 0; i < fullGroups; ++i, in += 4, out += 3) {
+        uint32_t a = BASE64_TABLE[in[0]];
+        uint32_t b = BASE64_TABLE[in[1]];
+        uint32_t c = BASE64_TABLE[in[2]];
+        uint32_t d = BASE64_TABLE[in[3]];
+        if ((a | b | c | d) & BASE64_INVALID) {
+            return SIZE_MAX;
         }
+
+        uint32_t bits = (a << 18) | (b << 12) | (c << 6) | d;
+        out[0] = static_cast<uint8_t>(bits >> 16);
+        out[1] = static_cast<uint8_t>(bits >> 8);
+        out[2] = static_cast<uint8_t>(bits);
     }
 
-    return std::string(decodedBytes.begin(), decodedBytes.end());
+    // 2 or 3 trailing characters carry 1 or 2 bytes, a single one is malformed
+    size_t remaining = length % 4;
+    if (remaining == 1) {
+        return SIZE_MAX;
+    }
+    if (remaining > 1) {
+        uint32_t bits = 0;
+        for (size_t i = 0; i < remaining; ++i) {
+            uint32_t value = BASE64_TABLE[in[i]];
+            if (value & BASE64_INVALID) {
+                return SIZE_MAX;
+            }
+            bits |= value << (18 - 6 * i);
+        }
+        *out++ = static_cast<uint8_t>(bits >> 16);
+        if (remaining == 3) {
+            *out++ = static_cast<uint8_t>(bits >> 8);
+        }
+    }
+
+    return static_cast<size_t>(out - dst);
 }
 
 size_t getComponentSize(int componentType) {
@@ -156,26 +257,39 @@ void packTBNframe(RawMeshData* mesh, const std::vector<glm::vec3>& gltfNormals,
 /*
 * Parsing
 */
+
+// sourceFiles, when given, receives every file the result was built from (the glTF and its external buffers)
 bool loadglTF(const std::string& fileName,
               std::vector<std::unique_ptr<RawMeshData>>& meshes,
               std::vector<std::unique_ptr<MaterialDefinition>>& materialDefs,
-              std::vector<SceneData>& nodeData) {
-    std::ifstream file(fileName);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << fileName << "\n";
+              std::vector<SceneData>& nodeData,
+              std::vector<std::string>* sourceFiles = nullptr) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(fileName)) {
         return false;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-
-    bool isBinary = (fileName.size() >= 3 && fileName.substr(fileName.size() - 3) == "glb");
-    if (isBinary) {
-        // Binary .glb not supported
-        return false;
+    // .glb is detected by its header rather than the extension
+    json gltfDoc;
+    glTFBuffer binChunk;
+    uint32_t magic = 0;
+    if (file->size() >= sizeof(magic)) {
+        std::memcpy(&magic, file->data(), sizeof(magic));
     }
 
-    json gltfDoc = json::parse(buffer.str());
+    if (magic == GLB_MAGIC) {
+        if (!parseGLB(file, gltfDoc, binChunk)) {
+            return false;
+        }
+    } else {
+        // Parse straight from the mapping, no intermediate string
+        gltfDoc = json::parse(file->data(), file->data() + file->size(), nullptr, false);
+        if (gltfDoc.is_discarded()) {
+            std::cerr << "Failed to parse glTF JSON: " << fileName << "\n";
+            return false;
+        }
+        file.reset();
+    }
 
     // Preliminary check
     std::string gltfVersion;
@@ -186,8 +300,11 @@ bool loadglTF(const std::string& fileName,
     }
 
     // Buffers
-    std::vector<std::vector<uint8_t>> buffers;
-    if (!parseBuffers(gltfDoc, fileName, buffers)) {
+    std::vector<glTFBuffer> buffers;
+    if (sourceFiles) {
+        sourceFiles->push_back(fileName);
+    }
+    if (!parseBuffers(gltfDoc, fileName, binChunk, buffers, sourceFiles)) {
         std::cerr << "Failed to parse glTF buffers\n";
         return false;
     }
@@ -235,7 +352,64 @@ bool loadglTF(const std::string& fileName,
     return true;
 }
 
-bool parseBuffers(const json& gltfDoc, const std::string& fileName, std::vector<std::vector<uint8_t>>& buffers) {
+bool parseGLB(const std::shared_ptr<MappedFile>& file, json& gltfDoc, glTFBuffer& binChunk) {
+    const uint8_t* bytes = file->data();
+    size_t size = file->size();
+
+    auto readU32 = [bytes](size_t offset) {
+        uint32_t value;
+        std::memcpy(&value, bytes + offset, sizeof(value));
+        return value;
+    };
+
+    // Header: magic, version, total length
+    if (size < 20 || readU32(4) != 2) {
+        std::cerr << "Unsupported GLB container version\n";
+        return false;
+    }
+    size_t length = std::min<size_t>(readU32(8), size);
+
+    // Chunks: length, type, 4 byte aligned payload. JSON must come first.
+    size_t offset = 12;
+    bool hasJson = false;
+    while (offset + 8 <= length) {
+        size_t chunkLength = readU32(offset);
+        uint32_t chunkType = readU32(offset + 4);
+        const uint8_t* chunkData = bytes + offset + 8;
+        if (offset + 8 + chunkLength > length) {
+            std::cerr << "GLB chunk exceeds file size\n";
+            return false;
+        }
+
+        if (!hasJson) {
+            if (chunkType != GLB_CHUNK_JSON) {
+                std::cerr << "GLB does not start with a JSON chunk\n";
+                return false;
+            }
+            gltfDoc = json::parse(chunkData, chunkData + chunkLength, nullptr, false);
+            if (gltfDoc.is_discarded()) {
+                std::cerr << "Failed to parse GLB JSON chunk\n";
+                return false;
+            }
+            hasJson = true;
+        } else if (chunkType == GLB_CHUNK_BIN && !binChunk.data) {
+            binChunk.data = chunkData;
+            binChunk.size = chunkLength;
+            binChunk.mapping = file;
+        }
+        // Unknown chunk types are skipped as the spec requires
+        offset += 8 + ((chunkLength + 3) & ~size_t(3));
+    }
+
+    if (!hasJson) {
+        std::cerr << "GLB is missing its JSON chunk\n";
+        return false;
+    }
+    return true;
+}
+
+bool parseBuffers(const json& gltfDoc, const std::string& fileName, const glTFBuffer& binChunk, std::vector<glTFBuffer>& buffers,
+                  std::vector<std::string>* sourceFiles) {
     if (!gltfDoc.contains("buffers")) {
         return false;
     }
@@ -245,34 +419,64 @@ bool parseBuffers(const json& gltfDoc, const std::string& fileName, std::vector<
 
     for (size_t i = 0; i < buffersJson.size(); ++i) {
         const auto& bufferJson = buffersJson[i];
+        glTFBuffer& buffer = buffers[i];
+
+        size_t byteLength = 0;
+        parseJsonProperty(bufferJson, "byteLength", byteLength);
+
         if (!bufferJson.contains("uri")) {
+            // The first buffer of a .glb without a uri is the BIN chunk
+            if (i == 0 && binChunk.data) {
+                if (binChunk.size < byteLength) {
+                    std::cerr << "GLB BIN chunk is smaller than buffer 0\n";
+                    return false;
+                }
+                buffer = binChunk;
+            }
             continue;
         }
 
-        std::string uri;
-        parseJsonProperty(bufferJson, "uri", uri);
+        const std::string& uri = bufferJson["uri"].get_ref<const std::string&>();
 
-        if (uri.find("data:application/octet-stream;base64,") == 0) {
-            // Handle base64 embedded buffer
-            std::string base64Data = uri.substr(37); // Skip the prefix
-            std::string decodedData = base64Decode(base64Data);
+        if (uri.compare(0, 5, "data:") == 0) {
+            // Embedded buffer, any media type as long as it's data:[<mediatype>][;params];base64,<data>
+            size_t comma = uri.find(',');
+            if (comma == std::string::npos || comma < 12 || uri.compare(comma - 7, 7, ";base64") != 0) {
+                std::cerr << "Unsupported data URI for buffer " << i << ", only base64 is supported\n";
+                return false;
+            }
 
-            buffers[i].resize(decodedData.size());
-            std::memcpy(buffers[i].data(), decodedData.data(), decodedData.size());
+            const char* encoded = uri.data() + comma + 1;
+            size_t encodedLength = uri.size() - comma - 1;
+            buffer.storage.resize(base64DecodedSize(encoded, encodedLength));
+
+            size_t written = base64Decode(encoded, encodedLength, buffer.storage.data());
+            if (written == SIZE_MAX) {
+                std::cerr << "Invalid base64 data in buffer " << i << "\n";
+                return false;
+            }
+            buffer.storage.resize(written);
+            buffer.data = buffer.storage.data();
+            buffer.size = buffer.storage.size();
 
         } else {
-            // Handle external buffer
+            // External buffer, mapped instead of read into memory
             std::string bufferPath = fileName.substr(0, fileName.find_last_of("/\\") + 1) + uri;
-            std::ifstream bufferFile(bufferPath, std::ios::binary);
-            if (!bufferFile.is_open()) {
-                std::cerr << "Failed to open buffer file: " << bufferPath << "\n";
+            auto mapping = std::make_shared<MappedFile>();
+            if (!mapping->open(bufferPath)) {
+                return false;
+            }
+            if (mapping->size() < byteLength) {
+                std::cerr << "Buffer file is smaller than its byteLength: " << bufferPath << "\n";
                 return false;
             }
 
-            size_t byteLength = 0;
-            parseJsonProperty(bufferJson, "byteLength", byteLength);
-            buffers[i].resize(byteLength);
-            bufferFile.read(reinterpret_cast<char*>(buffers[i].data()), byteLength);
+            buffer.data = mapping->data();
+            buffer.size = byteLength;
+            buffer.mapping = std::move(mapping);
+            if (sourceFiles) {
+                sourceFiles->push_back(std::move(bufferPath));
+            }
         }
     }
 
@@ -284,7 +488,7 @@ bool parseBuffers(const json& gltfDoc, const std::string& fileName, std::vector<
 */
 bool parseAccessors(
     const json& gltfDoc,
-    std::vector<std::vector<uint8_t>>& buffers,
+    const std::vector<glTFBuffer>& buffers,
     std::vector<glTFBufferView>& bufferViews,
     std::vector<std::unique_ptr<RawMeshData>>& meshes,
     std::vector<int>& materialIndices) {
@@ -302,10 +506,8 @@ bool parseAccessors(
     const auto& accessorsJson = gltfDoc["accessors"];
     const auto& meshesJson = gltfDoc["meshes"];
 
-    meshes.clear();
-    meshes.reserve(meshesJson.size());
-    materialIndices.reserve(meshesJson.size());
-
+    // Flatten primitives in file order, results are stored by this index so the output order is fixed
+    std::vector<std::pair<const json*, size_t>> primitives;
     for (size_t meshIdx = 0; meshIdx < meshesJson.size(); ++meshIdx) {
         const auto& meshJson = meshesJson[meshIdx];
         if (!meshJson.contains("primitives") || !meshJson["primitives"].is_array() || meshJson["primitives"].empty()) {
@@ -315,107 +517,139 @@ bool parseAccessors(
 
         const auto& primitivesJson = meshJson["primitives"];
         for (size_t primitiveIdx = 0; primitiveIdx < primitivesJson.size(); ++primitiveIdx) {
-            auto mesh = std::make_unique<RawMeshData>();
-            const auto& primitiveJson = primitivesJson[primitiveIdx];
-            if (!primitiveJson.contains("attributes")) {
-                continue;
-            }
-
-            if (primitiveJson.contains("mode")) {
-                mesh->drawMode = static_cast<GLenum>(primitiveJson.value("mode", GL_TRIANGLES));
+            if (primitivesJson[primitiveIdx].contains("attributes")) {
+                primitives.emplace_back(&primitivesJson[primitiveIdx], primitiveIdx);
             }
+        }
+    }
 
-            const auto& attributeJson = primitiveJson["attributes"];
+    // Decode, tangent generation and TBN packing are independent per primitive
+    std::vector<glTFPrimitiveResult> results(primitives.size());
+    JobSystem::getInstance().parallelFor(primitives.size(), [&](size_t i) {
+        // Malformed JSON throws on access, fail the load like a missing attribute would
+        try {
+            decodePrimitive(*primitives[i].first, primitives[i].second, accessorsJson, buffers, bufferViews, results[i]);
+        } catch (const std::exception& e) {
+            results[i].error = "Primitive " + std::to_string(primitives[i].second) + " is malformed: " + e.what();
+        }
+    });
 
-            /*
-            * Required attributes
-            */
-            std::vector<glm::vec3> tempNormals;
-            std::vector<glm::vec4> tempTangents;
+    meshes.clear();
+    meshes.reserve(results.size());
+    materialIndices.reserve(results.size());
+
+    size_t generatedTangents = 0;
+    for (auto& result : results) {
+        if (!result.error.empty()) {
+            std::cerr << result.error << "\n";
+            meshes.clear();
+            return false;
+        }
 
-            // Process POSITION attribute
-            if (attributeJson.contains("POSITION")) {
-                size_t positionIdx = attributeJson["POSITION"];
-                const auto& positionAccesor = accessorsJson[positionIdx];
-                size_t positionBufferViewIdx = positionAccesor["bufferView"];
-                parseAccessorData(positionAccesor, buffers, bufferViews[positionBufferViewIdx], mesh->vertices);
-            }
+        generatedTangents += result.generatedTangents ? 1 : 0;
+        meshes.push_back(std::move(result.mesh));
+        materialIndices.push_back(result.materialIndex);
+    }
 
-            // Process Indices
-            if (primitiveJson.contains("indices")) {
-                size_t indicesAccessorIndex = primitiveJson["indices"];
-                const auto& indicesAccessor = accessorsJson[indicesAccessorIndex];
-                size_t indicesBufferViewIndex = indicesAccessor["bufferView"];
-                parseAccessorData(indicesAccessor, buffers, bufferViews[indicesBufferViewIndex], mesh->indices);
-            }
+    if (generatedTangents > 0) {
+        std::cerr << "[Warning] Tangents not found for " << generatedTangents << " primitive(s), calculated them\n";
+    }
 
-            // Process NORMAL attribute
-            if (attributeJson.contains("NORMAL")) {
-                size_t normalIdx = attributeJson["NORMAL"];
-                const auto& normalAccesor = accessorsJson[normalIdx];
-                size_t normalBufferViewIdx = normalAccesor["bufferView"];
-                parseAccessorData(normalAccesor, buffers, bufferViews[normalBufferViewIdx], tempNormals);
-            }
+    return !meshes.empty();
+}
 
-            // Process TEXCOORD_0 attribute
-            if (attributeJson.contains("TEXCOORD_0")) {
-                size_t uvIdx = attributeJson["TEXCOORD_0"];
-                const auto& uvAccesor = accessorsJson[uvIdx];
-                size_t uvBufferViewIdx = uvAccesor["bufferView"];
-                parseAccessorData(uvAccesor, buffers, bufferViews[uvBufferViewIdx], mesh->uvs);
-                // Flip UVs for engine (glTF uses a coordinate system where (0,0) is the bottom-left, while the engine's top-left is (0,0).)
-                for (auto& uv : mesh->uvs) {
-                    uv.y = 1.0f - uv.y;
-                }
-            }
+void decodePrimitive(
+    const json& primitiveJson,
+    size_t primitiveIdx,
+    const json& accessorsJson,
+    const std::vector<glTFBuffer>& buffers,
+    const std::vector<glTFBufferView>& bufferViews,
+    glTFPrimitiveResult& result) {
+
+    auto mesh = std::make_unique<RawMeshData>();
+    if (primitiveJson.contains("mode")) {
+        mesh->drawMode = static_cast<GLenum>(primitiveJson.value("mode", GL_TRIANGLES));
+    }
 
-            if (mesh->vertices.empty() || tempNormals.empty() || mesh->indices.empty() || mesh->uvs.empty()) {
-                std::stringstream warningMsg;
-                warningMsg << "[Warning] failed to load glTF mesh at index [" << primitiveIdx
-                        << "]: one or more required attributes are missing.\n"
-                        << "Present data: \n"
-                        << "    Vertices: " << (mesh->vertices.empty() ? "Missing" : "OK") << "\n"
-                        << "    Indices: " << (mesh->indices.empty() ? "Missing" : "OK") << "\n"
-                        << "    Normals: " << (tempNormals.empty() ? "Missing" : "OK") << "\n"
-                        << "    TexCoords: " << (mesh->uvs.empty() ? "Missing" : "OK") << "\n";
-                std::cerr << warningMsg.str() << "\n";
-                meshes.clear();
-                return false;
-            }
+    const auto& attributeJson = primitiveJson["attributes"];
 
-            /*
-            * Optional resources
-            */
+    /*
+    * Required attributes
+    */
+    std::vector<glm::vec3> tempNormals;
+    std::vector<glm::vec4> tempTangents;
 
-            // Process TANGENT attribute
-            if (attributeJson.contains("TANGENT")) {
-                size_t tangentIdx = attributeJson["TANGENT"];
-                const auto& tangentAccessor = accessorsJson[tangentIdx];
-                size_t tangentBufferViewIdx = tangentAccessor["bufferView"];
-                parseAccessorData(tangentAccessor, buffers, bufferViews[tangentBufferViewIdx], tempTangents);
-            } else {
-                std::cerr << "[Warning] Tangents not found for mesh, calculating...\n";
-                calculateTangentSpace(mesh.get(), tempNormals, tempTangents);
-                std::cout << "[Info] Done.\n";
-            }
+    // Process POSITION attribute
+    if (attributeJson.contains("POSITION")) {
+        size_t positionIdx = attributeJson["POSITION"];
+        const auto& positionAccesor = accessorsJson[positionIdx];
+        size_t positionBufferViewIdx = positionAccesor["bufferView"];
+        parseAccessorData(positionAccesor, buffers, bufferViews[positionBufferViewIdx], mesh->vertices);
+    }
 
-            // Material index handling
-            int materialIndex = -1;
-            if (primitiveJson.contains("material")) {
-                materialIndex = primitiveJson["material"].get<int>();
-            }
+    // Process Indices
+    if (primitiveJson.contains("indices")) {
+        size_t indicesAccessorIndex = primitiveJson["indices"];
+        const auto& indicesAccessor = accessorsJson[indicesAccessorIndex];
+        size_t indicesBufferViewIndex = indicesAccessor["bufferView"];
+        parseAccessorData(indicesAccessor, buffers, bufferViews[indicesBufferViewIndex], mesh->indices);
+    }
 
-            // CRITICAL FIX: Call packTBNframe BEFORE moving the unique_ptr
-            // Store the mesh and its corresponding material index
-            packTBNframe(mesh.get(), tempNormals, tempTangents);
+    // Process NORMAL attribute
+    if (attributeJson.contains("NORMAL")) {
+        size_t normalIdx = attributeJson["NORMAL"];
+        const auto& normalAccesor = accessorsJson[normalIdx];
+        size_t normalBufferViewIdx = normalAccesor["bufferView"];
+        parseAccessorData(normalAccesor, buffers, bufferViews[normalBufferViewIdx], tempNormals);
+    }
 
-            // Now it's safe to move the mesh to the container
-            meshes.push_back(std::move(mesh));
-            materialIndices.push_back(materialIndex);
+    // Process TEXCOORD_0 attribute
+    if (attributeJson.contains("TEXCOORD_0")) {
+        size_t uvIdx = attributeJson["TEXCOORD_0"];
+        const auto& uvAccesor = accessorsJson[uvIdx];
+        size_t uvBufferViewIdx = uvAccesor["bufferView"];
+        parseAccessorData(uvAccesor, buffers, bufferViews[uvBufferViewIdx], mesh->uvs);
+        // Flip UVs for engine (glTF uses a coordinate system where (0,0) is the bottom-left, while the engine's top-left is (0,0).)
+        for (auto& uv : mesh->uvs) {
+            uv.y = 1.0f - uv.y;
         }
     }
 
-    return !meshes.empty();
+    if (mesh->vertices.empty() || tempNormals.empty() || mesh->indices.empty() || mesh->uvs.empty()) {
+        std::stringstream warningMsg;
+        warningMsg << "[Warning] failed to load glTF mesh at index [" << primitiveIdx
+                << "]: one or more required attributes are missing.\n"
+                << "Present data: \n"
+                << "    Vertices: " << (mesh->vertices.empty() ? "Missing" : "OK") << "\n"
+                << "    Indices: " << (mesh->indices.empty() ? "Missing" : "OK") << "\n"
+                << "    Normals: " << (tempNormals.empty() ? "Missing" : "OK") << "\n"
+                << "    TexCoords: " << (mesh->uvs.empty() ? "Missing" : "OK") << "\n";
+        result.error = warningMsg.str();
+        return;
+    }
+
+    /*
+    * Optional resources
+    */
+
+    // Process TANGENT attribute
+    if (attributeJson.contains("TANGENT")) {
+        size_t tangentIdx = attributeJson["TANGENT"];
+        const auto& tangentAccessor = accessorsJson[tangentIdx];
+        size_t tangentBufferViewIdx = tangentAccessor["bufferView"];
+        parseAccessorData(tangentAccessor, buffers, bufferViews[tangentBufferViewIdx], tempTangents);
+    } else {
+        calculateTangentSpace(mesh.get(), tempNormals, tempTangents);
+        result.generatedTangents = true;
+    }
+
+    // Material index handling
+    if (primitiveJson.contains("material")) {
+        result.materialIndex = primitiveJson["material"].get<int>();
+    }
+
+    packTBNframe(mesh.get(), tempNormals, tempTangents);
+    result.mesh = std::move(mesh);
 }
 
 void calculateTangentSpace(RawMeshData* mesh, std::vector<glm::vec3>& normals, std::vector<glm::vec4>& tangents) {
@@ -608,6 +842,8 @@ void loadMaterialDefinitions(
                 if (imageIndex < imagesJson.size() && imagesJson[imageIndex].contains("uri")) {
                     std::string imageUri = imagesJson[imageIndex]["uri"].get<std::string>();
                     texturePaths[i] = fileName.substr(0, fileName.find_last_of("/\\") + 1) + imageUri;
+                } else if (imageIndex < imagesJson.size() && imagesJson[imageIndex].contains("bufferView")) {
+                    std::cerr << "[Warning] glTF image " << imageIndex << " is embedded in a bufferView, only uri images are loaded\n";
                 }
             }
         }
@@ -824,10 +1060,20 @@ void unpackData(const uint8_t* dataPtr, int componentType, int vecSize, T& targe
     }
 }
 
+// True when the accessor's elements already have T's memory layout
+template <typename T>
+bool isLayoutCompatible(int componentType, int vecSize) {
+    if constexpr (std::is_same_v<T, uint32_t>) {
+        return componentType == 5125 && vecSize == 1;
+    } else {
+        return componentType == 5126 && static_cast<size_t>(vecSize) * sizeof(float) == sizeof(T);
+    }
+}
+
 template <typename T>
 void parseAccessorData(
     const json& accessorJson,
-    const std::vector<std::vector<uint8_t>>& buffers,
+    const std::vector<glTFBuffer>& buffers,
     const glTFBufferView& bufferView,
     std::vector<T>& targetVector) {
 
@@ -852,12 +1098,46 @@ void parseAccessorData(
     int componentType = 0;
     parseJsonProperty(accessorJson, "componentType", componentType);
 
-    const uint8_t* bufferData = buffers[bufferView.index].data() + bufferView.byteOffset + byteOffset;
     size_t elementByteSize = getComponentSize(componentType) * vecSize;
     size_t stride = bufferView.stride == 0 ? elementByteSize : bufferView.stride;
 
+    targetVector.clear();
+    if (count == 0 || elementByteSize == 0) {
+        return;
+    }
+
+    // Reject accessors reaching past their buffer instead of reading the mapping out of bounds.
+    // Checked by division so huge offsets and counts can't wrap around.
+    size_t bufferSize = bufferView.index < buffers.size() ? buffers[bufferView.index].size : 0;
+    size_t start = bufferView.byteOffset + byteOffset;
+    if (bufferView.byteOffset > bufferSize || byteOffset > bufferSize - bufferView.byteOffset ||
+        bufferSize - start < elementByteSize || count - 1 > (bufferSize - start - elementByteSize) / stride) {
+        std::cerr << "glTF accessor exceeds its buffer (" << count << " elements, stride " << stride << ", offset " << start
+                  << ", buffer " << bufferSize << " bytes)\n";
+        return;
+    }
+
+    const uint8_t* bufferData = buffers[bufferView.index].data + start;
     targetVector.resize(count);
 
+    // Tightly packed float / uint32 data is copied in one go
+    if (stride == sizeof(T) && isLayoutCompatible<T>(componentType, vecSize)) {
+        std::memcpy(targetVector.data(), bufferData, count * sizeof(T));
+        return;
+    }
+
+    // 16 bit indices are the other common case, widen without the generic unpack
+    if constexpr (std::is_same_v<T, uint32_t>) {
+        if (componentType == 5123) {
+            for (size_t i = 0; i < count; ++i) {
+                uint16_t value;
+                std::memcpy(&value, bufferData + i * stride, sizeof(value));
+                targetVector[i] = value;
+            }
+            return;
+        }
+    }
+
     for (size_t i = 0; i < count; ++i) {
         const uint8_t* dataPtr = bufferData + i * stride;
         unpackData(dataPtr, componentType, vecSize, targetVector[i], true);
@@ -5,6 +5,13 @@
 // Loaders
 #include "objloader.h"
 #include "parsers/gltf/gltfParser.h"
+#include "mappedFile.h"
+#include "meshCache.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+#include "meshletBuilder.h"
+
+#include "../debugging/profiler.h"
 
 #include <fstream>
 #include <sstream>
@@ -34,7 +41,8 @@ std::string ResourceLoader::readFile(const std::string& filePath) {
 * Images
 */
 unsigned char* ResourceLoader::loadImage(const std::string& filePath, int* width, int* height, int* nrChannels) {
-    stbi_set_flip_vertically_on_load(true);
+    // Per thread, images are decoded on workers while the main thread loads cubemaps
+    stbi_set_flip_vertically_on_load_thread(true);
     unsigned char* data = stbi_load(filePath.c_str(), width, height, nrChannels, 0);
 
     if (!data) {
@@ -52,12 +60,39 @@ void ResourceLoader::freeImage(unsigned char* data) {
 /*
 * Mesh
 */
-RawMeshData* ResourceLoader::loadMesh(const std::string& filepath) {
-    std::string fileContent = readFile(filepath);
-    if (fileContent.empty()) {
-        std::cerr << "[Error] ResourceLoader::loadMesh: File contents empty: " << filepath << "\n";
-        return nullptr;
+namespace {
+    // Runs before MeshCache::store so cache hits skip it
+    void optimizeMeshes(const std::string& filepath, std::vector<std::unique_ptr<RawMeshData>>& meshes) {
+        MeshOptimizer::CacheStats before;
+        MeshOptimizer::CacheStats after;
+        size_t optimized = 0;
+        size_t lodLevels = 0;
+        size_t meshlets = 0;
+        for (auto& mesh : meshes) {
+            if (!mesh) {
+                continue;
+            }
+            MeshOptimizer::Report report = MeshOptimizer::optimize(*mesh);
+            if (report.optimized) {
+                before += report.before;
+                after += report.after;
+                optimized++;
+            }
+            lodLevels += MeshSimplifier::generateLods(*mesh) - 1;
+            meshlets += MeshletBuilder::generateMeshlets(*mesh);
+        }
+        if (optimized == 0) {
+            return;
+        }
+        std::cout << "[Info] ResourceLoader: Optimized " << optimized << " mesh(es) of " << filepath
+                  << ": ACMR " << before.getACMR() << " -> " << after.getACMR()
+                  << ", ATVR " << before.getATVR() << " -> " << after.getATVR()
+                  << ", " << lodLevels << " LOD level(s) and " << meshlets << " meshlet(s) added\n";
     }
+}
+
+RawMeshData* ResourceLoader::loadMesh(const std::string& filepath) {
+    PROFILE_SCOPE("ResourceLoader::loadMesh");
 
     // Extract the file extension
     size_t dotPos = filepath.find_last_of(".");
@@ -74,8 +109,28 @@ RawMeshData* ResourceLoader::loadMesh(const std::string& filepath) {
 
     // Determine the appropriate function based on the extension
     if (extension == "obj") {
-        return ObjLoader::loadOBJ(fileContent);
-    } else if (extension == "gltf") {
+        std::vector<std::unique_ptr<RawMeshData>> meshes;
+        std::vector<std::unique_ptr<MaterialDefinition>> materialDefs;
+        std::vector<SceneData> nodeData;
+        if (MeshCache::load(filepath, meshes, materialDefs, nodeData) && meshes.size() == 1 && meshes[0]) {
+            return meshes[0].release();
+        }
+
+        // Parsed straight out of the mapping
+        MappedFile file;
+        if (!file.open(filepath) || file.size() == 0) {
+            std::cerr << "[Error] ResourceLoader::loadMesh: File contents empty: " << filepath << "\n";
+            return nullptr;
+        }
+
+        meshes.clear();
+        meshes.emplace_back(ObjLoader::loadOBJ(reinterpret_cast<const char*>(file.data()), file.size()));
+        if (meshes[0]) {
+            optimizeMeshes(filepath, meshes);
+            MeshCache::store(filepath, {filepath}, meshes, {}, {});
+        }
+        return meshes[0].release();
+    } else if (extension == "gltf" || extension == "glb") {
         std::cerr << "[Error] ResourceLoader::loadMesh: for glTF files use ResourceLoader::loadMeshVector() for file: " << filepath << "\n";
         return nullptr;
     } else {
@@ -89,8 +144,10 @@ void ResourceLoader::loadMeshVector(
     std::vector<std::unique_ptr<RawMeshData>>& meshes,
     std::vector<std::unique_ptr<MaterialDefinition>>& materialDefs,
     std::vector<SceneData>& nodeData) {
-    std::string fileContent = readFile(filepath);
-    if (fileContent.empty()) {
+    PROFILE_SCOPE("ResourceLoader::loadMeshVector");
+    // The glTF loader maps the file itself, only check it's there
+    std::error_code error;
+    if (std::filesystem::file_size(filepath, error) == 0 || error) {
         std::cerr << "[Error] ResourceLoader::loadMeshVector: File contents empty: " << filepath << "\n";
         return;
     }
@@ -107,25 +164,32 @@ void ResourceLoader::loadMeshVector(
         c = std::tolower(c);
     }
 
-    if (extension != "gltf") {
-        std::cerr << "[Error] ResourceLoader::loadMeshVector: only accepts glTF files: " << filepath << "\n";
+    if (extension != "gltf" && extension != "glb") {
+        std::cerr << "[Error] ResourceLoader::loadMeshVector: only accepts glTF files (.gltf, .glb): " << filepath << "\n";
+        return;
+    }
+
+    if (MeshCache::load(filepath, meshes, materialDefs, nodeData)) {
         return;
     }
 
-    if (!loadglTF(filepath, meshes, materialDefs, nodeData)) {
+    std::vector<std::string> sourceFiles;
+    if (!loadglTF(filepath, meshes, materialDefs, nodeData, &sourceFiles)) {
         std::cerr << "[Error] ResourceLoader::loadMeshVector: Failed to load glTF mesh: " << filepath << "\n";
         meshes.clear();
         materialDefs.clear();
         nodeData.clear();
         return;
     }
+    optimizeMeshes(filepath, meshes);
+    MeshCache::store(filepath, sourceFiles, meshes, materialDefs, nodeData);
 }
 
 /*
 * Cubemap (Loading only image data, no OpenGL calls)
 */
 std::vector<unsigned char*> ResourceLoader::loadCubemapImages(const std::vector<std::string>& faces, int* width, int* height, int* nrChannels) {
-    stbi_set_flip_vertically_on_load(false);
+    stbi_set_flip_vertically_on_load_thread(false);
 
     std::vector<unsigned char*> data;
     for (const std::string& face : faces) {
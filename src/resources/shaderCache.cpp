@@ -0,0 +1,179 @@
+#include "shaderCache.h"
+#include "cacheFile.h"
+#include "mappedFile.h"
+
+#include "../debugging/profiler.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#ifndef SHADER_CACHE_DIR
+#define SHADER_CACHE_DIR "cache/shaders/"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr uint32_t CACHE_MAGIC = 0x43534746;  // "FGSC"
+    constexpr uint32_t CACHE_VERSION = 1;
+    constexpr const char* CACHE_EXTENSION = ".bin";
+
+    struct EntryHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t binaryFormat;
+        uint32_t binarySize;
+    };
+
+    std::string g_directory = SHADER_CACHE_DIR;
+    bool g_enabled = true;
+    ShaderCache::Stats g_stats;
+
+    // Driver identity and binary support, queried once a context exists
+    bool g_driverQueried = false;
+    bool g_driverSupported = false;
+    uint64_t g_driverHash = 0;
+
+    bool queryDriver() {
+        if (!g_driverQueried) {
+            g_driverQueried = true;
+            GLint formatCount = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+            g_driverSupported = formatCount > 0;
+
+            std::string driver;
+            for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+                const GLubyte* value = glGetString(name);
+                driver += value ? reinterpret_cast<const char*>(value) : "";
+                driver += '\n';
+            }
+            g_driverHash = CacheFile::hashString(driver);
+            if (!g_driverSupported) {
+                std::cout << "[Info] ShaderCache: Driver has no program binary formats, cache inactive\n";
+            }
+        }
+        return g_driverSupported;
+    }
+
+    std::string entryPath(uint64_t key) {
+        return CacheFile::entryPath(g_directory, std::to_string(key), CACHE_EXTENSION);
+    }
+}
+
+void ShaderCache::setDirectory(const std::string& directory) {
+    g_directory = directory;
+}
+
+const std::string& ShaderCache::getDirectory() {
+    return g_directory;
+}
+
+void ShaderCache::setEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+bool ShaderCache::isEnabled() {
+    return g_enabled && !g_directory.empty();
+}
+
+void ShaderCache::clear() {
+    CacheFile::clearDirectory(g_directory, CACHE_EXTENSION);
+}
+
+uint64_t ShaderCache::makeKey(std::initializer_list<const std::string*> stageSources) {
+    queryDriver();
+    uint64_t key = g_driverHash;
+    for (const std::string* source : stageSources) {
+        key = CacheFile::hashBytes(reinterpret_cast<const uint8_t*>(source->data()), source->size(), key);
+    }
+    return key;
+}
+
+GLuint ShaderCache::load(uint64_t key) {
+    if (!isEnabled() || !queryDriver()) {
+        return 0;
+    }
+    PROFILE_SCOPE("ShaderCache::load");
+
+    std::string cachePath = entryPath(key);
+    std::error_code error;
+    if (!fs::exists(cachePath, error)) {
+        g_stats.misses++;
+        return 0;
+    }
+
+    MappedFile file;
+    EntryHeader header;
+    if (!file.open(cachePath) || file.size() < sizeof(header)) {
+        g_stats.misses++;
+        return 0;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.key != key ||
+        header.binarySize != file.size() - sizeof(header)) {
+        g_stats.misses++;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, file.data() + sizeof(header), static_cast<GLsizei>(header.binarySize));
+    GLint linkStatus = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (!linkStatus) {
+        // The driver changed in a way its version string doesn't show, recompile and overwrite
+        glDeleteProgram(program);
+        g_stats.misses++;
+        return 0;
+    }
+
+    g_stats.hits++;
+    g_stats.bytesRead += file.size();
+    return program;
+}
+
+bool ShaderCache::store(uint64_t key, GLuint program) {
+    if (!isEnabled() || !queryDriver() || program == 0) {
+        return false;
+    }
+    PROFILE_SCOPE("ShaderCache::store");
+
+    GLint binarySize = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0) {
+        return false;
+    }
+
+    std::vector<uint8_t> bytes(sizeof(EntryHeader) + static_cast<size_t>(binarySize));
+    EntryHeader header{};
+    GLsizei written = 0;
+    glGetProgramBinary(program, binarySize, &written, &header.binaryFormat, bytes.data() + sizeof(header));
+    if (written <= 0) {
+        std::cerr << "[Warning] ShaderCache::store: Driver returned no program binary\n";
+        return false;
+    }
+
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.key = key;
+    header.binarySize = static_cast<uint32_t>(written);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    bytes.resize(sizeof(header) + static_cast<size_t>(written));
+
+    if (!CacheFile::writeAtomic(entryPath(key), bytes.data(), bytes.size())) {
+        return false;
+    }
+    g_stats.writes++;
+    g_stats.bytesWritten += bytes.size();
+    return true;
+}
+
+ShaderCache::Stats ShaderCache::getStats() {
+    return g_stats;
+}
+
+void ShaderCache::resetStats() {
+    g_stats = Stats();
+}
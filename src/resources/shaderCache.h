@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+/*
+ * Disk cache of linked shader programs (glGetProgramBinary/glProgramBinary).
+ *
+ * Entries are keyed by the preprocessed source of every stage plus the GL
+ * vendor, renderer and version strings, so editing a shader or one of its
+ * includes, or updating the driver, simply misses. A binary the driver
+ * refuses to load is a miss as well and gets overwritten after the compile.
+ * Drivers without binary formats leave the cache inactive.
+ */
+namespace ShaderCache {
+    struct Stats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;     // Missing entries and binaries the driver rejected
+        uint32_t writes = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+    };
+
+    // Defaults to SHADER_CACHE_DIR (the build directory), changes must happen before loading
+    void setDirectory(const std::string& directory);
+    const std::string& getDirectory();
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    // Deletes every cache file in the directory
+    void clear();
+
+    // Key of a program from its preprocessed stages in link order, needs a current context
+    uint64_t makeKey(std::initializer_list<const std::string*> stageSources);
+
+    // @return A linked program, 0 on a miss
+    GLuint load(uint64_t key);
+
+    // Writes the binary of a freshly linked program
+    bool store(uint64_t key, GLuint program);
+
+    Stats getStats();
+    void resetStats();
+}
@@ -0,0 +1,202 @@
+#include "textureCache.h"
+#include "cacheFile.h"
+#include "ddsFile.h"
+#include "mappedFile.h"
+
+#include "../debugging/profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#ifndef TEXTURE_CACHE_DIR
+#define TEXTURE_CACHE_DIR "cache/textures/"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    /*
+     * Entries are plain DDS files, validation data lives in the header's reserved words:
+     *   magic, version, usage | quality << 8, source size, source mtime, content hash, key hash
+     *
+     * Bump the version whenever the encoder's output changes.
+     */
+    constexpr uint32_t CACHE_MAGIC = 0x43544746;  // "FGTC"
+    constexpr uint32_t CACHE_VERSION = 1;
+    constexpr const char* CACHE_EXTENSION = ".dds";
+
+    std::string g_directory = TEXTURE_CACHE_DIR;
+    bool g_enabled = true;
+    BlockCompression::Quality g_quality = BlockCompression::Quality::High;
+
+    std::atomic<uint32_t> g_hits{0};
+    std::atomic<uint32_t> g_misses{0};
+    std::atomic<uint32_t> g_writes{0};
+    std::atomic<uint64_t> g_bytesRead{0};
+    std::atomic<uint64_t> g_bytesWritten{0};
+    std::atomic<uint64_t> g_encodeMicroseconds{0};
+
+    std::string cacheKey(const std::string& sourcePath, TextureUsage usage) {
+        return CacheFile::normalizePath(sourcePath) + "|" + std::to_string(static_cast<uint32_t>(usage)) +
+               "|" + std::to_string(static_cast<uint32_t>(g_quality));
+    }
+
+    uint32_t usageWord(TextureUsage usage) {
+        return static_cast<uint32_t>(usage) | (static_cast<uint32_t>(g_quality) << 8);
+    }
+
+    void putWide(DDSFile::Reserved& reserved, size_t index, uint64_t value) {
+        reserved[index] = static_cast<uint32_t>(value);
+        reserved[index + 1] = static_cast<uint32_t>(value >> 32);
+    }
+
+    uint64_t getWide(const DDSFile::Reserved& reserved, size_t index) {
+        return static_cast<uint64_t>(reserved[index]) | (static_cast<uint64_t>(reserved[index + 1]) << 32);
+    }
+}
+
+void TextureCache::setDirectory(const std::string& directory) {
+    g_directory = directory;
+}
+
+const std::string& TextureCache::getDirectory() {
+    return g_directory;
+}
+
+void TextureCache::setEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+bool TextureCache::isEnabled() {
+    return g_enabled && !g_directory.empty();
+}
+
+void TextureCache::setQuality(BlockCompression::Quality quality) {
+    g_quality = quality;
+}
+
+BlockCompression::Quality TextureCache::getQuality() {
+    return g_quality;
+}
+
+void TextureCache::clear() {
+    CacheFile::clearDirectory(g_directory, CACHE_EXTENSION);
+}
+
+bool TextureCache::load(const std::string& sourcePath, TextureUsage usage, TextureImage& image) {
+    if (!isEnabled()) {
+        return false;
+    }
+    PROFILE_SCOPE("TextureCache::load");
+
+    std::string key = cacheKey(sourcePath, usage);
+    std::string cachePath = CacheFile::entryPath(g_directory, key, CACHE_EXTENSION);
+
+    std::error_code error;
+    if (!fs::exists(cachePath, error)) {
+        g_misses++;
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(cachePath)) {
+        g_misses++;
+        return false;
+    }
+
+    TextureImage cached;
+    DDSFile::Reserved reserved{};
+    if (!DDSFile::parse(file.data(), file.size(), cached, &reserved)) {
+        std::cerr << "[Warning] TextureCache::load: Corrupt cache file " << cachePath << " for " << sourcePath << ", reimporting\n";
+        g_misses++;
+        return false;
+    }
+    if (reserved[0] != CACHE_MAGIC || reserved[1] != CACHE_VERSION || reserved[2] != usageWord(usage) ||
+        getWide(reserved, 9) != CacheFile::hashString(key)) {
+        g_misses++;
+        return false;
+    }
+
+    // Size must match, a changed mtime falls back to the content hash
+    uint64_t size;
+    int64_t mtime;
+    if (!CacheFile::querySource(sourcePath, size, mtime) || size != getWide(reserved, 3)) {
+        g_misses++;
+        return false;
+    }
+    if (static_cast<uint64_t>(mtime) != getWide(reserved, 5) &&
+        CacheFile::hashFiles({sourcePath}) != getWide(reserved, 7)) {
+        g_misses++;
+        return false;
+    }
+
+    image = std::move(cached);
+    g_hits++;
+    g_bytesRead += file.size();
+    return true;
+}
+
+bool TextureCache::import(const std::string& sourcePath, TextureUsage usage, TextureImage& image) {
+    if (!isEnabled() || !image.pixels) {
+        return false;
+    }
+
+    TextureFormat format = BlockCompression::chooseFormat(usage, image, g_quality);
+    if (format == TextureFormat::Uncompressed) {
+        return false;
+    }
+    PROFILE_SCOPE("TextureCache::import");
+
+    uint64_t size;
+    int64_t mtime;
+    if (!CacheFile::querySource(sourcePath, size, mtime)) {
+        return false;
+    }
+
+    auto encodeStart = std::chrono::steady_clock::now();
+    if (!BlockCompression::compress(image, format)) {
+        return false;
+    }
+    g_encodeMicroseconds += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - encodeStart).count());
+
+    std::string key = cacheKey(sourcePath, usage);
+    DDSFile::Reserved reserved{};
+    reserved[0] = CACHE_MAGIC;
+    reserved[1] = CACHE_VERSION;
+    reserved[2] = usageWord(usage);
+    putWide(reserved, 3, size);
+    putWide(reserved, 5, static_cast<uint64_t>(mtime));
+    putWide(reserved, 7, CacheFile::hashFiles({sourcePath}));
+    putWide(reserved, 9, CacheFile::hashString(key));
+
+    // The image is compressed either way, a failed write only costs the next startup
+    std::vector<uint8_t> bytes = DDSFile::serialize(image, &reserved);
+    if (CacheFile::writeAtomic(CacheFile::entryPath(g_directory, key, CACHE_EXTENSION), bytes.data(), bytes.size())) {
+        g_writes++;
+        g_bytesWritten += bytes.size();
+    }
+    return true;
+}
+
+TextureCache::Stats TextureCache::getStats() {
+    Stats stats;
+    stats.hits = g_hits.load();
+    stats.misses = g_misses.load();
+    stats.writes = g_writes.load();
+    stats.bytesRead = g_bytesRead.load();
+    stats.bytesWritten = g_bytesWritten.load();
+    stats.encodeMs = g_encodeMicroseconds.load() / 1000.0;
+    return stats;
+}
+
+void TextureCache::resetStats() {
+    g_hits = 0;
+    g_misses = 0;
+    g_writes = 0;
+    g_bytesRead = 0;
+    g_bytesWritten = 0;
+    g_encodeMicroseconds = 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "blockCompression.h"
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Import cache of block compressed textures.
+ *
+ * The first decode of a texture is compressed for its usage (see
+ * BlockCompression::chooseFormat), mips included, and written as a .dds
+ * file. Later decodes load the blocks straight from it, skipping both
+ * stb_image and the encoder. The same file imported with another usage or
+ * quality is a separate entry.
+ *
+ * An entry is used while its source keeps its size and either its mtime or
+ * its content hash, the same rules as MeshCache.
+ */
+namespace TextureCache {
+    struct Stats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;     // Missing or stale entries
+        uint32_t writes = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        double encodeMs = 0.0;   // CPU time spent in the encoder, summed over threads
+    };
+
+    // Defaults to TEXTURE_CACHE_DIR (the build directory), changes must happen before loading
+    void setDirectory(const std::string& directory);
+    const std::string& getDirectory();
+    void setEnabled(bool enabled);
+    bool isEnabled();
+    void setQuality(BlockCompression::Quality quality);
+    BlockCompression::Quality getQuality();
+
+    // Deletes every cache file in the directory
+    void clear();
+
+    // @return false on a miss or a stale/corrupt entry, image is left untouched.
+    bool load(const std::string& sourcePath, TextureUsage usage, TextureImage& image);
+
+    /*
+     * Compresses a freshly decoded image (mip levels included) in place and writes its entry.
+     * @return false if the image stays uncompressed, it can still be uploaded as is.
+     */
+    bool import(const std::string& sourcePath, TextureUsage usage, TextureImage& image);
+
+    Stats getStats();
+    void resetStats();
+}
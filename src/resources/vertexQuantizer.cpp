@@ -0,0 +1,122 @@
+#include "vertexQuantizer.h"
+
+#include "../debugging/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    struct CompactVertex {
+        uint16_t position[3];
+        uint16_t padding;
+        uint32_t uv;
+        int16_t tbn[4];
+    };
+    static_assert(sizeof(CompactVertex) == MESH_COMPACT_VERTEX_SIZE, "Compact vertex layout");
+
+    uint16_t toUnorm16(float value) {
+        return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    int16_t toSnorm16(float value) {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    float fromSnorm16(int16_t value) {
+        return std::max(value / 32767.0f, -1.0f);
+    }
+
+    // Same unpacking as gbuff.vs
+    glm::vec4 normalizeTBN(glm::vec4 q) {
+        q = glm::normalize(q);
+        return q.w < 0.0f ? -q : q;
+    }
+
+    glm::vec3 unpackNormal(const glm::vec4& q) {
+        return glm::vec3(0.0f, 0.0f, 1.0f) +
+               glm::vec3(2.0f, -2.0f, -2.0f) * q.x * glm::vec3(q.z, q.w, q.x) +
+               glm::vec3(2.0f, 2.0f, -2.0f) * q.y * glm::vec3(q.w, q.z, q.y);
+    }
+
+    glm::vec3 unpackTangent(const glm::vec4& q) {
+        return glm::vec3(1.0f, 0.0f, 0.0f) +
+               glm::vec3(-2.0f, 2.0f, -2.0f) * q.y * glm::vec3(q.y, q.x, q.w) +
+               glm::vec3(-2.0f, 2.0f, 2.0f) * q.z * glm::vec3(q.z, q.w, q.x);
+    }
+
+    float angleDegrees(const glm::vec3& a, const glm::vec3& b) {
+        float cosine = glm::dot(glm::normalize(a), glm::normalize(b));
+        return glm::degrees(std::acos(std::clamp(cosine, -1.0f, 1.0f)));
+    }
+}
+
+VertexQuantizer::Bounds VertexQuantizer::computeBounds(const float* vertices, size_t vertexCount) {
+    Bounds bounds;
+    if (vertexCount == 0) {
+        return bounds;
+    }
+
+    glm::vec3 minimum(std::numeric_limits<float>::max());
+    glm::vec3 maximum(std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < vertexCount; ++i, vertices += MESH_VERTEX_SIZE) {
+        glm::vec3 position(vertices[0], vertices[1], vertices[2]);
+        minimum = glm::min(minimum, position);
+        maximum = glm::max(maximum, position);
+    }
+    bounds.offset = minimum;
+    bounds.scale = maximum - minimum;
+    return bounds;
+}
+
+VertexQuantizer::Bounds VertexQuantizer::pack(const float* vertices, size_t vertexCount, uint8_t* dst, Report* report) {
+    PROFILE_SCOPE("VertexQuantizer::pack");
+    Bounds bounds = computeBounds(vertices, vertexCount);
+
+    // Flat axes quantize to 0 and come back exact
+    glm::vec3 inverseScale(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (bounds.scale[axis] > 0.0f) {
+            inverseScale[axis] = 1.0f / bounds.scale[axis];
+        }
+    }
+
+    Report result;
+    for (size_t i = 0; i < vertexCount; ++i, vertices += MESH_VERTEX_SIZE, dst += MESH_COMPACT_VERTEX_SIZE) {
+        CompactVertex vertex{};
+        glm::vec3 position(vertices[0], vertices[1], vertices[2]);
+        glm::vec3 normalized = (position - bounds.offset) * inverseScale;
+        for (int axis = 0; axis < 3; ++axis) {
+            vertex.position[axis] = toUnorm16(normalized[axis]);
+        }
+        std::memcpy(&vertex.uv, &vertices[3], sizeof(uint32_t));
+
+        glm::vec4 tbn(vertices[4], vertices[5], vertices[6], vertices[7]);
+        for (int component = 0; component < 4; ++component) {
+            vertex.tbn[component] = toSnorm16(tbn[component]);
+        }
+        std::memcpy(dst, &vertex, sizeof(vertex));
+
+        if (report) {
+            // Dequantized the way the vertex shader does it
+            for (int axis = 0; axis < 3; ++axis) {
+                float restored = bounds.offset[axis] + (vertex.position[axis] / 65535.0f) * bounds.scale[axis];
+                result.maxPositionError = std::max(result.maxPositionError, std::abs(restored - position[axis]));
+            }
+
+            glm::vec4 original = normalizeTBN(tbn);
+            glm::vec4 restored = normalizeTBN(glm::vec4(fromSnorm16(vertex.tbn[0]), fromSnorm16(vertex.tbn[1]),
+                                                        fromSnorm16(vertex.tbn[2]), fromSnorm16(vertex.tbn[3])));
+            result.maxNormalError = std::max(result.maxNormalError, angleDegrees(unpackNormal(original), unpackNormal(restored)));
+            result.maxTangentError = std::max(result.maxTangentError, angleDegrees(unpackTangent(original), unpackTangent(restored)));
+        }
+    }
+
+    if (report) {
+        float extent = std::max({bounds.scale.x, bounds.scale.y, bounds.scale.z});
+        result.relativePositionError = extent > 0.0f ? result.maxPositionError / extent : 0.0f;
+        *report = result;
+    }
+    return bounds;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../components/mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Converts vertices from the float layout (MESH_VERTEX_SIZE floats) to the
+ * compact one (MESH_COMPACT_VERTEX_SIZE bytes):
+ *
+ *   0  unorm16 x3  position within the mesh bounds, 2 bytes padding
+ *   8  half2       UV, the same bits as the float layout
+ *   12 snorm16 x4  TBN quaternion, packTBNframe keeps |w| >= 1/32767 so the
+ *                  reflection sign survives the rounding
+ *
+ * Shaders get the position back as offset + unorm * scale, see Renderer::bindMeshBuffer.
+ */
+namespace VertexQuantizer {
+    // Float meshes use the identity
+    struct Bounds {
+        glm::vec3 offset = glm::vec3(0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);  // Extent of the bounds
+    };
+
+    // Worst error of the quantized vertices
+    struct Report {
+        float maxPositionError = 0.0f;       // Model units
+        float relativePositionError = 0.0f;  // Of the largest extent
+        float maxNormalError = 0.0f;         // Degrees
+        float maxTangentError = 0.0f;        // Degrees
+    };
+
+    Bounds computeBounds(const float* vertices, size_t vertexCount);
+
+    // Writes vertexCount * MESH_COMPACT_VERTEX_SIZE bytes to dst, @return the bounds to dequantize with
+    Bounds pack(const float* vertices, size_t vertexCount, uint8_t* dst, Report* report = nullptr);
+}
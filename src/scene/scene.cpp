@@ -1,4 +1,7 @@
 #include "scene.h"
+#include "debugging/profiler.h"
+#include "resources/meshOptimizer.h"
+#include "resources/meshSimplifier.h"
 #include <random>
 #include <chrono>
 
@@ -16,6 +19,9 @@
 
 // TODO: In the future, this will be user generated through UI, not code.
 void Scene::loadScene() {
+    PROFILE_SCOPE("Scene::loadScene");
+    auto loadStart = std::chrono::steady_clock::now();
+
     // ------------------------ Skybox Setup ------------------------
     std::vector<std::string> skyboxPaths = {
         ASSET_DIR "textures/skyboxes/bspace/1.png",
@@ -66,16 +72,14 @@ void Scene::loadScene() {
         save_bunnyData.scale = glm::vec3(20.0f);
         GameObject* bunnyObject = SceneUtils::addGameObjectComponent(registry, bunnyEntity, save_bunnyData);
 
-        std::unique_ptr<RawMeshData> bunnyMesh(ResourceLoader::loadMesh(MODEL_DIR + "bunny.obj"));
-        if (bunnyMesh != nullptr) {
-            EntityMeshDefinition bunnyMeshDef{bunnyObject->getEntity()};
-            bunnyMeshDef.materialDef->vertexShaderPath = defaultVertexPath;
-            bunnyMeshDef.materialDef->fragmentShaderPath = defaultFragPath;
-            bunnyMeshDef.materialDef->albedoColor = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
-            bunnyMeshDef.materialDef->isDeferred = true;
-            bunnyMeshDef.rawMeshData = std::move(bunnyMesh);
-            meshEntityPairs.emplace_back(std::move(bunnyMeshDef));
-        }
+        // Decoded in the background by the AssetStreamer
+        EntityMeshDefinition bunnyMeshDef{bunnyObject->getEntity()};
+        bunnyMeshDef.sourcePath = MODEL_DIR + "bunny.obj";
+        bunnyMeshDef.materialDef->vertexShaderPath = defaultVertexPath;
+        bunnyMeshDef.materialDef->fragmentShaderPath = defaultFragPath;
+        bunnyMeshDef.materialDef->albedoColor = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+        bunnyMeshDef.materialDef->isDeferred = true;
+        meshEntityPairs.emplace_back(std::move(bunnyMeshDef));
     }
 
     // for (int row = 0; row < numRows; ++row) {
@@ -135,18 +139,15 @@ void Scene::loadScene() {
     GameObject* diabloObject = SceneUtils::addGameObjectComponent(registry, diabloEntity, save_diabloData);
     diabloObject->addScript<MoveScript>();
 
-    std::unique_ptr<RawMeshData> diabloMesh(ResourceLoader::loadMesh(MODEL_DIR + "/diablo3_pose.obj"));
-    if (diabloMesh != nullptr) {
-        EntityMeshDefinition diabloMeshDef{diabloObject->getEntity()};
-        diabloMeshDef.materialDef->vertexShaderPath = defaultVertexPath;
-        diabloMeshDef.materialDef->fragmentShaderPath = defaultFragPath;
-        diabloMeshDef.materialDef->albedoColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-        diabloMeshDef.materialDef->isDeferred = true;
-        diabloMeshDef.materialDef->albedoMapPath = TEXTURE_DIR + "diablo/diablo3_pose_diffuse.tga";
-        diabloMeshDef.materialDef->normalMapPath = TEXTURE_DIR + "diablo/diablo3_pose_nm_tangent.tga";
-        diabloMeshDef.rawMeshData = std::move(diabloMesh);
-        meshEntityPairs.emplace_back(std::move(diabloMeshDef));
-    }
+    EntityMeshDefinition diabloMeshDef{diabloObject->getEntity()};
+    diabloMeshDef.sourcePath = MODEL_DIR + "/diablo3_pose.obj";
+    diabloMeshDef.materialDef->vertexShaderPath = defaultVertexPath;
+    diabloMeshDef.materialDef->fragmentShaderPath = defaultFragPath;
+    diabloMeshDef.materialDef->albedoColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    diabloMeshDef.materialDef->isDeferred = true;
+    diabloMeshDef.materialDef->albedoMapPath = TEXTURE_DIR + "diablo/diablo3_pose_diffuse.tga";
+    diabloMeshDef.materialDef->normalMapPath = TEXTURE_DIR + "diablo/diablo3_pose_nm_tangent.tga";
+    meshEntityPairs.emplace_back(std::move(diabloMeshDef));
 
     /*
     * glTF Game Objects
@@ -222,6 +223,9 @@ void Scene::loadScene() {
     //         }
     //     }
     // }
+
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    std::cout << "[Info] Scene::loadScene: Assets loaded in " << loadMs << " ms\n";
 }
 
 void Scene::createSuns(int n, float circleRadius, float yPosition, std::string vertexPath, std::string fragPath) {
@@ -351,17 +355,14 @@ void Scene::createSpotLights(int n, float circleRadius, float yPosition, std::st
         SceneUtils::addLightComponents(registry, lightEntity, lightData);
 
         // Cube mesh
-        std::unique_ptr<RawMeshData> spotlightMesh(ResourceLoader::loadMesh(MODEL_DIR + "/spotlight.obj"));
-        if (spotlightMesh != nullptr) {
-            EntityMeshDefinition cubeMeshDef{lightObject->getEntity()};
-            cubeMeshDef.materialDef->vertexShaderPath = vertexPath;
-            cubeMeshDef.materialDef->fragmentShaderPath = fragPath;
-            cubeMeshDef.materialDef->albedoColor = glm::vec4(1.0f);
-            cubeMeshDef.materialDef->albedoMapPath = TEXTURE_DIR + "gold/gold.png";
-            cubeMeshDef.materialDef->isDeferred = true;
-            cubeMeshDef.rawMeshData = std::move(spotlightMesh);
-            meshEntityPairs.emplace_back(std::move(cubeMeshDef));
-        }
+        EntityMeshDefinition cubeMeshDef{lightObject->getEntity()};
+        cubeMeshDef.sourcePath = MODEL_DIR + "/spotlight.obj";
+        cubeMeshDef.materialDef->vertexShaderPath = vertexPath;
+        cubeMeshDef.materialDef->fragmentShaderPath = fragPath;
+        cubeMeshDef.materialDef->albedoColor = glm::vec4(1.0f);
+        cubeMeshDef.materialDef->albedoMapPath = TEXTURE_DIR + "gold/gold.png";
+        cubeMeshDef.materialDef->isDeferred = true;
+        meshEntityPairs.emplace_back(std::move(cubeMeshDef));
     }
 }
 
@@ -372,6 +373,10 @@ void Scene::createSpheres(int n, float fieldSize, float minHeight, float maxHeig
         return;
     }
 
+    // Generated meshes skip the import pipeline, thousands of instances make the LODs worth it
+    MeshOptimizer::optimize(*asteroidMesh);
+    MeshSimplifier::generateLods(*asteroidMesh);
+
     // Get the group ID for this instanced mesh
     size_t groupId = instancedMeshGroups.size();
 
@@ -451,6 +456,11 @@ void Scene::loadSkyBox(const std::vector<std::string>& skyboxFilePaths) {
         return;
     }
 
+#ifdef FACTORY_HEADLESS
+    // No GL context to upload the cubemap to
+    m_skyboxHandle = 0;
+#else
     // Load the cubemap textures from the provided file paths
     m_skyboxHandle = CubeMap::createFromImages(skyboxFilePaths);
+#endif
 }
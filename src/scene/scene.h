@@ -44,6 +44,7 @@ public:
      * @param cameraEntity - The entity representing the primary camera to set.
      */
     void setPrimaryCamera(entt::entity cameraEntity);
+    entt::entity getPrimaryCameraEntity() const { return m_primaryCameraEntity; }
 
     // =========================================================================
     // SKybox Management
@@ -60,7 +61,7 @@ public:
     void createSuns(int n, float circleRadius, float yPosition, std::string vertexPath, std::string fragPath);
 
 private:
-    unsigned int m_skyboxHandle;
+    unsigned int m_skyboxHandle = 0;
 
     // Scene Management
     std::unique_ptr<Octree<entt::entity>> m_octree;
@@ -1,4 +1,5 @@
 #include "scene_utils.h"
+#include "system/jobSystem.h"
 
 void SceneUtils::addLightComponents(entt::registry& registry, entt::entity entity, Light lightData) {
     registry.emplace<Light>(entity, lightData);
@@ -37,6 +38,50 @@ GameObject* SceneUtils::addGameObjectComponent(entt::registry& registry, entt::e
     return &registry.emplace<GameObject>(entity, entity, registry);
 }
 
+namespace {
+    // Keeps the instance range contiguous, the last member moves into the destroyed one's slot
+    void removeMeshInstance(entt::registry& registry, entt::entity entity) {
+        const MeshInstance& instance = registry.get<MeshInstance>(entity);
+        InstancedMesh* group = registry.try_get<InstancedMesh>(instance.group);
+        if (!group || instance.index >= group->members.size() || group->members[instance.index] != entity) {
+            return;
+        }
+
+        uint32_t last = static_cast<uint32_t>(group->members.size() - 1);
+        if (instance.index != last) {
+            entt::entity moved = group->members[last];
+            group->members[instance.index] = moved;
+            group->matrices[instance.index] = group->matrices[last];
+            group->lodLevels[instance.index] = group->lodLevels[last];
+            registry.get<MeshInstance>(moved).index = instance.index;
+        }
+        group->members.pop_back();
+        group->matrices.pop_back();
+        group->lodLevels.pop_back();
+    }
+}
+
+entt::entity SceneUtils::createInstancedMesh(entt::registry& registry, const std::vector<entt::entity>& members, const Mesh& mesh) {
+    registry.on_destroy<MeshInstance>().connect<&removeMeshInstance>();
+
+    entt::entity groupEntity = registry.create();
+    InstancedMesh& group = registry.emplace<InstancedMesh>(groupEntity);
+    group.mesh = mesh;
+    group.members.reserve(members.size());
+    group.matrices.reserve(members.size());
+    for (entt::entity member : members) {
+        if (!registry.valid(member) || registry.all_of<MeshInstance>(member)) {
+            continue;
+        }
+        const ModelMatrix* modelMatrix = registry.try_get<ModelMatrix>(member);
+        registry.emplace<MeshInstance>(member, groupEntity, static_cast<uint32_t>(group.members.size()));
+        group.members.push_back(member);
+        group.matrices.push_back(modelMatrix ? modelMatrix->matrix : glm::mat4(1.0f));
+    }
+    group.lodLevels.assign(group.members.size(), 0);
+    return groupEntity;
+}
+
 GameObject* SceneUtils::createMeshGameObject(
     entt::registry& registry,
     std::vector<EntityMeshDefinition>& meshEntityPairs,
@@ -138,6 +183,20 @@ GameObject* SceneUtils::createMeshGameObject(
     return gameObjects[rootIdx];
 }
 
+void SceneUtils::loadPendingMeshes(std::vector<EntityMeshDefinition>& meshEntityPairs) {
+    JobSystem::getInstance().parallelFor(meshEntityPairs.size(), [&meshEntityPairs](size_t i) {
+        EntityMeshDefinition& meshDef = meshEntityPairs[i];
+        if (!meshDef.sourcePath.empty()) {
+            meshDef.rawMeshData.reset(ResourceLoader::loadMesh(meshDef.sourcePath));
+            meshDef.sourcePath.clear();
+        }
+    });
+
+    meshEntityPairs.erase(std::remove_if(meshEntityPairs.begin(), meshEntityPairs.end(),
+        [](const EntityMeshDefinition& meshDef) { return meshDef.rawMeshData == nullptr; }),
+        meshEntityPairs.end());
+}
+
 void SceneUtils::createEmptyGameObject(entt::registry& registry, const SceneData& data) {
     entt::entity entity = registry.create();
     addGameObjectComponent(registry, entity, data);
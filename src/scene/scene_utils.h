@@ -36,6 +36,16 @@ public:
      */
     static GameObject* addGameObjectComponent(entt::registry& registry, entt::entity entity, const SceneData& data);
 
+    /**
+     * Creates an InstancedMesh entity drawing mesh for every member. Members get a MeshInstance
+     * and their current model matrix, they must not hold a Mesh themselves.
+     * @param registry - The registry to create the group in.
+     * @param members - Entities with a ModelMatrix, in the order of the instance range.
+     * @param mesh - The shared mesh, may be a placeholder that is replaced once uploaded.
+     * @return The group entity.
+     */
+    static entt::entity createInstancedMesh(entt::registry& registry, const std::vector<entt::entity>& members, const Mesh& mesh);
+
     // =========================================================================
     // GameObject Helpers
     // =========================================================================
@@ -69,6 +79,13 @@ public:
         std::vector<EntityMeshDefinition>& meshEntityPairs,
         const std::string& filePath,
         const std::string& vertPath, const std::string& fragPath);
+
+    /**
+     * Decodes every EntityMeshDefinition::sourcePath mesh on the job system and waits for them.
+     * For runners that upload synchronously instead of going through an AssetStreamer.
+     * @param meshEntityPairs Definitions to fill, ones that fail to load are removed.
+     */
+    static void loadPendingMeshes(std::vector<EntityMeshDefinition>& meshEntityPairs);
 };
 
 #endif // SCENE_UTILS_H
@@ -0,0 +1,184 @@
+#include "headlessRunner.h"
+
+#include "scene/scene.h"
+#include "debugging/profiler.h"
+#include "resources/meshCache.h"
+#include "resources/textureCache.h"
+#include "resources/shaderCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+void HeadlessOptions::parse(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = argv[i + 1];
+
+        if (std::strcmp(arg, "--ticks") == 0) {
+            ticks = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(arg, "--dt") == 0) {
+            deltaTime = std::strtof(value, nullptr);
+        } else if (std::strcmp(arg, "--warmup") == 0) {
+            warmupTicks = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(arg, "--trace") == 0) {
+            tracePath = value;
+        } else if (std::strcmp(arg, "--stats") == 0) {
+            statsPath = value;
+        } else if (std::strcmp(arg, "--mesh-cache") == 0) {
+            meshCache = value;
+        } else if (std::strcmp(arg, "--texture-cache") == 0) {
+            textureCache = value;
+        } else if (std::strcmp(arg, "--shader-cache") == 0) {
+            shaderCache = value;
+        } else {
+            continue;
+        }
+        ++i;
+    }
+}
+
+HeadlessRunner::HeadlessRunner(config::GraphicsSettings& settings) : m_settings(settings) {}
+
+void HeadlessRunner::stubMeshUploads(Scene& scene) {
+    SceneUtils::loadPendingMeshes(scene.meshEntityPairs);
+    size_t nextId = 0;
+
+    for (auto& meshDef : scene.meshEntityPairs) {
+        Mesh mesh;
+        mesh.id = nextId++;
+        mesh.count = static_cast<uint32_t>(meshDef.rawMeshData->getLod0IndexCount());
+        mesh.drawMode = meshDef.rawMeshData->drawMode;
+        scene.registry.emplace<Mesh>(meshDef.entity, mesh);
+        meshDef.rawMeshData->clearData();
+    }
+
+    for (auto& instanceGroup : scene.instancedMeshGroups) {
+        Mesh mesh;
+        mesh.id = nextId++;
+        mesh.count = static_cast<uint32_t>(instanceGroup.meshData->getLod0IndexCount());
+        mesh.drawMode = instanceGroup.meshData->drawMode;
+        SceneUtils::createInstancedMesh(scene.registry, instanceGroup.entities, mesh);
+        instanceGroup.meshData->clearData();
+    }
+}
+
+void HeadlessRunner::configureMeshCache(const HeadlessOptions& options) {
+    if (options.meshCache == "off") {
+        MeshCache::setEnabled(false);
+        return;
+    }
+
+    MeshCache::setEnabled(true);
+    if (options.meshCache == "cold") {
+        MeshCache::clear();
+    } else if (options.meshCache != "warm") {
+        std::cerr << "[Error] HeadlessRunner::configureMeshCache: Unknown mode '" << options.meshCache << "', using warm\n";
+    }
+}
+
+void HeadlessRunner::configureTextureCache(const HeadlessOptions& options) {
+    if (options.textureCache == "off") {
+        TextureCache::setEnabled(false);
+        return;
+    }
+
+    TextureCache::setEnabled(true);
+    if (options.textureCache == "cold") {
+        TextureCache::clear();
+    } else if (options.textureCache != "warm") {
+        std::cerr << "[Error] HeadlessRunner::configureTextureCache: Unknown mode '" << options.textureCache << "', using warm\n";
+    }
+}
+
+void HeadlessRunner::configureShaderCache(const HeadlessOptions& options) {
+    if (options.shaderCache == "off") {
+        ShaderCache::setEnabled(false);
+        return;
+    }
+
+    ShaderCache::setEnabled(true);
+    if (options.shaderCache == "cold") {
+        ShaderCache::clear();
+    } else if (options.shaderCache != "warm") {
+        std::cerr << "[Error] HeadlessRunner::configureShaderCache: Unknown mode '" << options.shaderCache << "', using warm\n";
+    }
+}
+
+double HeadlessRunner::run(Scene& scene, const HeadlessOptions& options) {
+    Profiler& profiler = Profiler::getInstance();
+    profiler.setThreadName("Main");
+
+    GameObjectSystem gameObjectSystem(scene.registry);
+    TransformSystem transformSystem(scene.registry);
+    LightSystem lightSystem(m_settings, scene.registry);
+    gameObjectSystem.startAll();
+
+    float currentTime = 0.0f;
+    auto tick = [&]() {
+        PROFILE_SCOPE("Frame");
+        {
+            PROFILE_SCOPE("Systems");
+            gameObjectSystem.updateAll(currentTime, options.deltaTime);
+            {
+                PROFILE_SCOPE("Transform");
+                transformSystem.updateTransformComponents();
+            }
+            {
+                PROFILE_SCOPE("Shadow");
+                lightSystem.updateShadowMatrices(scene.getPrimaryCamera());
+            }
+        }
+        currentTime += options.deltaTime;
+    };
+
+    // Warm up caches and first-touch allocations, then restart the stats window
+    for (uint32_t i = 0; i < options.warmupTicks; ++i) {
+        tick();
+        profiler.endFrame();
+    }
+    profiler.setStatsWindow(options.ticks > 0 ? options.ticks : 1);
+
+    if (!options.tracePath.empty()) {
+        profiler.captureTrace(options.ticks, options.tracePath);
+    }
+
+    auto runStart = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < options.ticks; ++i) {
+        auto tickStart = std::chrono::steady_clock::now();
+        tick();
+        profiler.endFrame();
+        profiler.record(std::chrono::duration<float>(std::chrono::steady_clock::now() - tickStart).count());
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - runStart).count();
+
+    // ---------------------------- Report ----------------------------
+    size_t gameObjectCount = scene.registry.storage<GameObject>().size();
+    std::printf("[Info] HeadlessRunner: %u ticks (dt %.4f s), %zu game objects, %.2f ms total, %.1f ticks/s\n",
+                options.ticks, options.deltaTime, gameObjectCount, totalMs,
+                totalMs > 0.0 ? options.ticks / (totalMs / 1000.0) : 0.0);
+
+    std::printf("%-32s %10s %10s %10s %10s %10s\n", "scope", "mean ms", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    auto printRow = [](const char* name, const Profiler::Summary& s) {
+        std::printf("%-32s %10.4f %10.4f %10.4f %10.4f %10.4f\n", name, s.meanMs, s.p50Ms, s.p95Ms, s.p99Ms, s.maxMs);
+    };
+    printRow("FrameTime", profiler.getFrameSummary());
+    for (uint32_t scope = 0; scope < profiler.getScopeCount(); ++scope) {
+        Profiler::Summary summary = profiler.getScopeSummary(scope);
+        if (summary.samples > 0) {
+            printRow(profiler.getScopeName(scope), summary);
+        }
+    }
+
+    const std::string& statsPath = options.statsPath;
+    if (!statsPath.empty()) {
+        if (statsPath.size() >= 4 && statsPath.compare(statsPath.size() - 4, 4, ".csv") == 0) {
+            profiler.writeSummaryCSV(statsPath);
+        } else {
+            profiler.writeSummaryJSON(statsPath);
+        }
+    }
+
+    return totalMs;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "config/settings.h"
+
+class Scene;
+
+/*
+ * Simulation-only runner. Drives the same systems as the windowed game loop
+ * (GameObjectSystem, TransformSystem, LightSystem) for a fixed number of
+ * ticks with a fixed delta, without a Window, GL context or Renderer.
+ */
+struct HeadlessOptions {
+    uint32_t ticks = 1000;
+    float deltaTime = 1.0f / 60.0f;
+    uint32_t warmupTicks = 10;  // Excluded from the statistics
+    std::string tracePath;      // Chrome trace of the measured ticks when set
+    std::string statsPath;      // .csv or .json summary when set
+    std::string meshCache = "warm"; // warm (use/write the cache), cold (clear it first) or off
+    std::string textureCache = "warm"; // Same modes for the block compressed texture cache
+    std::string shaderCache = "warm";  // And for the program binary cache
+
+    // Picks up --ticks, --dt, --warmup, --trace, --stats, --mesh-cache, --texture-cache and --shader-cache,
+    // other arguments are ignored
+    void parse(int argc, char** argv);
+};
+
+class HeadlessRunner {
+public:
+    explicit HeadlessRunner(config::GraphicsSettings& settings);
+
+    /*
+     * Gives every mesh entity a Mesh component without touching the GPU, so
+     * systems see the same components as in a rendered run.
+     * @param scene - Scene whose meshEntityPairs and instancedMeshGroups are consumed.
+     */
+    static void stubMeshUploads(Scene& scene);
+
+    // Applies options.meshCache before a scene is loaded, so cold and warm startups can be compared
+    static void configureMeshCache(const HeadlessOptions& options);
+    static void configureTextureCache(const HeadlessOptions& options);
+    static void configureShaderCache(const HeadlessOptions& options);
+
+    /*
+     * Runs the simulation and prints the profiler summary.
+     * @return Measured wall time of the ticks in milliseconds.
+     */
+    double run(Scene& scene, const HeadlessOptions& options);
+
+private:
+    config::GraphicsSettings& m_settings;
+};
@@ -22,6 +22,7 @@ public:
 
     // Update key states by checking GLFW for all keys
     void update() {
+#ifndef FACTORY_NO_WINDOW
         // Copy current key states to previous key states
         for (int key = 0; key < MAX_KEYS; ++key) {
             m_prevKeyStates[key] = m_keyStates[key];
@@ -44,6 +45,7 @@ public:
         m_lastY = m_mouseY;
 
         m_cursorMode = glfwGetInputMode(m_window, GLFW_CURSOR);
+#endif
     }
 
     // Check if a specific key is currently held down
@@ -75,7 +77,9 @@ public:
 
     // Set the cursor mode
     void setCursorMode(int mode) {
+#ifndef FACTORY_NO_WINDOW
         glfwSetInputMode(m_window, GLFW_CURSOR, mode);
+#endif
         m_cursorMode = mode;  // Update the internal state to reflect the change
     }
 
@@ -99,10 +103,10 @@ public:
 
 private:
     GLFWwindow* m_window = nullptr;  // Store reference to the window
-    bool m_keyStates[MAX_KEYS];  // Track current key states
-    bool m_prevKeyStates[MAX_KEYS]; // Track previous key states
+    bool m_keyStates[MAX_KEYS] = {};  // Track current key states
+    bool m_prevKeyStates[MAX_KEYS] = {}; // Track previous key states
     bool m_firstMouse = true;
-    double m_lastX, m_lastY, m_mouseX, m_mouseY;
-    double m_xOffset, m_yOffset;
-    int m_cursorMode;
+    double m_lastX = 0.0, m_lastY = 0.0, m_mouseX = 0.0, m_mouseY = 0.0;
+    double m_xOffset = 0.0, m_yOffset = 0.0;
+    int m_cursorMode = GLFW_CURSOR_NORMAL;
 };
@@ -0,0 +1,127 @@
+#include "jobSystem.h"
+
+#include "debugging/profiler.h"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+JobSystem& JobSystem::getInstance() {
+    static JobSystem instance;
+    return instance;
+}
+
+JobSystem::JobSystem() {
+    // Make sure the profiler outlives the workers that register with it
+    Profiler::getInstance();
+
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    size_t workerCount = std::max(1u, hardwareThreads > 1 ? hardwareThreads - 1 : 1u);
+
+    m_workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopping = true;
+    }
+    m_queueCondition.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_queue.push_back(std::move(job));
+    }
+    m_queueCondition.notify_one();
+}
+
+void JobSystem::workerLoop(size_t workerIndex) {
+    Profiler::getInstance().setThreadName("Worker " + std::to_string(workerIndex));
+
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_stopping && m_queue.empty()) {
+                return;
+            }
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        // Every job shows up on its worker's track, call sites can nest finer scopes inside
+        {
+            PROFILE_SCOPE("Job");
+            job();
+        }
+    }
+}
+
+void JobSystem::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1) {
+        fn(0);
+        return;
+    }
+
+    // Helpers that start after every index is taken exit without touching fn
+    struct ForState {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        size_t count = 0;
+        const std::function<void(size_t)>* fn = nullptr;
+        // First exception thrown by fn, the indices after it are skipped
+        std::atomic<bool> failed{false};
+        std::exception_ptr exception;
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+    };
+
+    auto state = std::make_shared<ForState>();
+    state->count = count;
+    state->fn = &fn;
+
+    auto work = [](ForState& s) {
+        size_t index;
+        while ((index = s.next.fetch_add(1, std::memory_order_relaxed)) < s.count) {
+            if (!s.failed.load(std::memory_order_relaxed)) {
+                try {
+                    (*s.fn)(index);
+                } catch (...) {
+                    if (!s.failed.exchange(true, std::memory_order_acq_rel)) {
+                        s.exception = std::current_exception();
+                    }
+                }
+            }
+            // Counted either way, the caller only returns once no thread touches fn anymore
+            if (s.done.fetch_add(1, std::memory_order_acq_rel) + 1 == s.count) {
+                std::lock_guard<std::mutex> lock(s.doneMutex);
+                s.doneCondition.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(m_workers.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        enqueue([state, work]() { work(*state); });
+    }
+
+    work(*state);
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->doneCondition.wait(lock, [&]() { return state->done.load(std::memory_order_acquire) == count; });
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}
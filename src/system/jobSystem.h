@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Shared worker pool for load-time work (asset decoding, tangent generation, ...).
+ *
+ * Workers are created on first use, hardware threads - 1 of them (at least
+ * one) since the calling thread helps out in parallelFor. Jobs must not touch
+ * OpenGL, the context only lives on the main thread.
+ */
+class JobSystem {
+public:
+    static JobSystem& getInstance();
+
+    /*
+     * Runs fn(i) for every i in [0, count) and returns once all calls finished.
+     * The caller works through indices too, so nested calls from a job can't deadlock.
+     * Which thread runs an index is unspecified, write results into per index slots.
+     * The first exception fn throws is rethrown here after the other calls finished, remaining indices are skipped.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    // Queues a job and returns a future for its result
+    template <typename F>
+    auto submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    size_t getWorkerCount() const { return m_workers.size(); }
+
+private:
+    JobSystem();
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void enqueue(std::function<void()> job);
+    void workerLoop(size_t workerIndex);
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_queue;
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCondition;
+    bool m_stopping = false;
+};
@@ -0,0 +1,177 @@
+#include "offscreenContext.h"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+    bool hasExtension(const char* extensions, const char* name) {
+        if (!extensions) return false;
+        size_t length = std::strlen(name);
+        for (const char* found = std::strstr(extensions, name); found; found = std::strstr(found + length, name)) {
+            bool startOk = found == extensions || found[-1] == ' ';
+            bool endOk = found[length] == ' ' || found[length] == '\0';
+            if (startOk && endOk) return true;
+        }
+        return false;
+    }
+
+    EGLDisplay openDisplay() {
+        // Surfaceless platform works without X11/Wayland or a DRM device
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+            auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (getPlatformDisplay) {
+                EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+                if (display != EGL_NO_DISPLAY) return display;
+            }
+        }
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+}
+
+OffscreenContext::OffscreenContext(int width, int height)
+    : m_width(width), m_height(height) {}
+
+OffscreenContext::~OffscreenContext() {
+    EGLDisplay display = static_cast<EGLDisplay>(m_display);
+    if (display == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_surface) eglDestroySurface(display, static_cast<EGLSurface>(m_surface));
+    if (m_context) eglDestroyContext(display, static_cast<EGLContext>(m_context));
+    eglTerminate(display);
+}
+
+bool OffscreenContext::init() {
+    EGLDisplay display = openDisplay();
+    EGLint eglMajor = 0, eglMinor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &eglMajor, &eglMinor)) {
+        std::cerr << "[Error] OffscreenContext::init: Failed to initialize EGL (0x" << std::hex << eglGetError() << std::dec << ")\n";
+        return false;
+    }
+    m_display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "[Error] OffscreenContext::init: EGL display does not support desktop OpenGL\n";
+        return false;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+    bool noConfig = hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_no_config_context");
+    if (configCount == 0 && !noConfig) {
+        std::cerr << "[Error] OffscreenContext::init: No pbuffer config and no EGL_KHR_no_config_context\n";
+        return false;
+    }
+
+    // Same target as Window::init, older 4.x cores are still useful for diagnostics
+    const int versions[][2] = { {4, 6}, {4, 5}, {4, 3} };
+    EGLContext context = EGL_NO_CONTEXT;
+    for (const auto& version : versions) {
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, version[0],
+            EGL_CONTEXT_MINOR_VERSION, version[1],
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+        if (context != EGL_NO_CONTEXT) break;
+    }
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "[Error] OffscreenContext::init: Failed to create an OpenGL 4.x core context (0x" << std::hex << eglGetError() << std::dec << ")\n";
+        return false;
+    }
+    m_context = context;
+
+    EGLSurface surface = EGL_NO_SURFACE;
+    if (configCount > 0) {
+        const EGLint surfaceAttributes[] = { EGL_WIDTH, m_width, EGL_HEIGHT, m_height, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    }
+    if (surface == EGL_NO_SURFACE) {
+        std::cerr << "[Warning] OffscreenContext::init: No pbuffer surface, running surfaceless (framebuffer 0 is incomplete)\n";
+    }
+    m_surface = surface == EGL_NO_SURFACE ? nullptr : surface;
+
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        std::cerr << "[Error] OffscreenContext::init: eglMakeCurrent failed (0x" << std::hex << eglGetError() << std::dec << ")\n";
+        return false;
+    }
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+        std::cerr << "[Error] OffscreenContext::init: Failed to initialize GLAD\n";
+        return false;
+    }
+
+    glGetIntegerv(GL_MAJOR_VERSION, &m_major);
+    glGetIntegerv(GL_MINOR_VERSION, &m_minor);
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    m_rendererName = renderer ? reinterpret_cast<const char*>(renderer) : "unknown";
+
+    std::cout << "[Success] Running OpenGL " << m_major << "." << m_minor << " Core Profile offscreen ("
+              << m_rendererName << ", EGL " << eglMajor << "." << eglMinor << ", "
+              << (m_surface ? "pbuffer" : "surfaceless") << ")\n";
+    return true;
+}
+
+bool OffscreenContext::checkRendererSupport() const {
+    bool supported = true;
+
+    // gl_BaseInstance in the geometry and shadow shaders needs GLSL 4.60
+    if (m_major < 4 || (m_major == 4 && m_minor < 6)) {
+        std::cerr << "[Error] OffscreenContext: OpenGL 4.6 required, context is " << m_major << "." << m_minor << "\n";
+        supported = false;
+    }
+    // Material textures are bindless handles
+    if (!GLAD_GL_ARB_bindless_texture) {
+        std::cerr << "[Error] OffscreenContext: GL_ARB_bindless_texture is not supported by " << m_rendererName << "\n";
+        supported = false;
+    }
+    return supported;
+}
+
+bool OffscreenContext::saveFramebuffer(const std::string& path) const {
+    if (!m_surface) {
+        std::cerr << "[Error] OffscreenContext::saveFramebuffer: Surfaceless context has no framebuffer to read\n";
+        return false;
+    }
+
+    std::vector<unsigned char> pixels(static_cast<size_t>(m_width) * m_height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "[Error] OffscreenContext::saveFramebuffer: Failed to open " << path << "\n";
+        return false;
+    }
+
+    // GL rows start at the bottom, PPM at the top
+    file << "P6\n" << m_width << " " << m_height << "\n255\n";
+    size_t rowBytes = static_cast<size_t>(m_width) * 3;
+    for (int y = m_height - 1; y >= 0; --y) {
+        file.write(reinterpret_cast<const char*>(pixels.data() + y * rowBytes), rowBytes);
+    }
+    return file.good();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+
+/*
+ * Windowless OpenGL context on EGL, the offscreen counterpart of Window::init.
+ * Prefers a pbuffer surface so framebuffer 0 exists and the final frame can be
+ * read back, falls back to a surfaceless context (Mesa llvmpipe, headless GPUs)
+ * where framebuffer 0 is incomplete.
+ *
+ * Only built into targets that link EGL (see FactoryGameRenderBench).
+ */
+class OffscreenContext {
+public:
+    OffscreenContext(int width, int height);
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Creates the context (4.6 core, else the newest 4.x core), makes it current and loads GLAD
+    bool init();
+
+    /*
+     * Checks the extensions the renderer cannot run without.
+     * @return false and logs every missing feature.
+     */
+    bool checkRendererSupport() const;
+
+    bool hasDefaultFramebuffer() const { return m_surface != nullptr; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    int getMajorVersion() const { return m_major; }
+    int getMinorVersion() const { return m_minor; }
+    const std::string& getRendererName() const { return m_rendererName; }
+
+    /*
+     * Reads framebuffer 0 back and writes it as a binary PPM (P6), top row first.
+     * @return false when there is no default framebuffer or the file can't be written.
+     */
+    bool saveFramebuffer(const std::string& path) const;
+
+private:
+    int m_width;
+    int m_height;
+    int m_major = 0;
+    int m_minor = 0;
+    std::string m_rendererName;
+
+    // EGL handles kept opaque so this header doesn't drag EGL into every includer
+    void* m_display = nullptr;
+    void* m_context = nullptr;
+    void* m_surface = nullptr;
+};